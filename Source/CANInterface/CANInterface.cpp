@@ -19,10 +19,13 @@ const char* N_TAtypeToString(const N_TAtype_t nTAtype)
 
 const char* nAiToString(const N_AI& nAi)
 {
-    static char buffer[MAX_N_AI_STR_SIZE]; // 72 = 40 (N_TAtype) + 3 (N_SA) + 3 (N_TA) + 25 (for the format string) + 1
-                                           // (for the null terminator)
+    static char buffer[MAX_N_AI_STR_SIZE];
+    return nAiToString(nAi, buffer, sizeof(buffer));
+}
 
-    snprintf(buffer, sizeof(buffer), "{N_SA=%u, N_TA=%u, N_TAtype=%s}", nAi.N_SA, nAi.N_TA,
+const char* nAiToString(const N_AI& nAi, char* buffer, const size_t bufferSize)
+{
+    snprintf(buffer, bufferSize, "{N_SA=%u, N_TA=%u, N_TAtype=%s}", nAi.N_SA, nAi.N_TA,
              N_TAtypeToString(nAi.N_TAtype));
 
     return buffer;
@@ -30,32 +33,47 @@ const char* nAiToString(const N_AI& nAi)
 
 const char* frameDataToString(const uint8_t* data, const uint8_t data_length_code)
 {
-    /* Allocate twice the number of bytes in the "buf" array because each byte would
-     * be converted to two hex characters, also add an extra space for the terminating
-     * null byte.
-     */
-    static char output[(CAN_FRAME_MAX_DLC * 2) + 1];
-    const char  size = MIN(data_length_code, CAN_FRAME_MAX_DLC);
+    static char output[MAX_FRAME_DATA_STR_SIZE];
+    return frameDataToString(data, data_length_code, output, sizeof(output));
+}
 
-    char* ptr = &output[0];
+const char* frameDataToString(const uint8_t* data, const uint8_t data_length_code, char* buffer,
+                              const size_t bufferSize)
+{
+    // Each byte is converted to two hex characters, the bytes that do not fit in the buffer are left out.
+    const uint8_t size   = MIN(data_length_code, CAN_FRAME_MAX_DLC);
+    size_t        offset = 0;
 
-    for (int i = 0; i < size; i++)
+    if (bufferSize == 0)
     {
-        ptr += sprintf(ptr, "%02X", data[i]);
+        return buffer;
     }
+    buffer[0] = '\0';
 
-    return output;
+    for (uint8_t i = 0; i < size && offset + 2 < bufferSize; i++)
+    {
+        offset += snprintf(&buffer[offset], bufferSize - offset, "%02X", data[i]);
+    }
+
+    return buffer;
 }
 
 const char* frameToString(const CANFrame& frame)
 {
-    static char buffer[MAX_FRAME_STR_SIZE]; // 181 = 72 (N_AI) + 5 (flags) + 1 (data_length_code) + 17 (data) + 85
-                                            // (format string) + 1 (null terminator)
+    static char buffer[MAX_FRAME_STR_SIZE];
+    return frameToString(frame, buffer, sizeof(buffer));
+}
+
+const char* frameToString(const CANFrame& frame, char* buffer, const size_t bufferSize)
+{
+    char nAiStr[MAX_N_AI_STR_SIZE];
+    char dataStr[MAX_FRAME_DATA_STR_SIZE];
 
-    snprintf(buffer, sizeof(buffer),
+    snprintf(buffer, bufferSize,
              "{N_AI=%s, flags={extd=%u, rtr=%u, ss=%u, self=%u, dlc_non_comp=%u}, data_length_code=%u, data=[0x%s]}",
-             nAiToString(frame.identifier), frame.extd, frame.rtr, frame.ss, frame.self, frame.dlc_non_comp,
-             frame.data_length_code, frameDataToString(frame.data, frame.data_length_code));
+             nAiToString(frame.identifier, nAiStr, sizeof(nAiStr)), frame.extd, frame.rtr, frame.ss, frame.self,
+             frame.dlc_non_comp, frame.data_length_code,
+             frameDataToString(frame.data, frame.data_length_code, dataStr, sizeof(dataStr)));
 
     return buffer;
 }
@@ -74,3 +92,69 @@ const char* CANInterface::ackResultToString(const ACKResult ackResult)
             return "UNKNOWN_ACK_RESULT";
     }
 }
+
+bool CANInterface::writeFrameWithToken(CANFrame* frame, TxToken& token)
+{
+    if (!writeFrame(frame))
+    {
+        return false;
+    }
+    token = this->nextWriteToken++;
+    return true;
+}
+
+CANInterface::ACKResult CANInterface::getWriteFrameACKWithToken(TxToken& token)
+{
+    const ACKResult ack = getWriteFrameACK();
+    if (ack != ACK_NONE)
+    {
+        token = this->nextACKToken++;
+    }
+    return ack;
+}
+
+bool CANInterface::setWakeupCallback(const WakeupCallback callback, void* context)
+{
+    if (callback != nullptr && this->wakeupCallback != nullptr &&
+        (this->wakeupCallback != callback || this->wakeupCallbackContext != context))
+    {
+        return false;
+    }
+    this->wakeupCallback        = callback;
+    this->wakeupCallbackContext = context;
+    return true;
+}
+
+void CANInterface::clearWakeupCallback(const void* context)
+{
+    if (this->wakeupCallbackContext == context)
+    {
+        this->wakeupCallback        = nullptr;
+        this->wakeupCallbackContext = nullptr;
+    }
+}
+
+void CANInterface::setTxConfirmationCallback(const TxConfirmationCallback callback, void* context)
+{
+    this->txConfirmationCallback        = callback;
+    this->txConfirmationCallbackContext = context;
+}
+
+bool CANInterface::notifyTxConfirmation(const TxToken token, const ACKResult ack) const
+{
+    if (this->txConfirmationCallback == nullptr ||
+        !this->txConfirmationCallback(this->txConfirmationCallbackContext, token, ack))
+    {
+        return false;
+    }
+    notifyWakeup();
+    return true;
+}
+
+void CANInterface::notifyWakeup() const
+{
+    if (this->wakeupCallback != nullptr)
+    {
+        this->wakeupCallback(this->wakeupCallbackContext);
+    }
+}
@@ -1,11 +1,14 @@
 #ifndef CANInterface_h
 #define CANInterface_h
 
+#include <cstddef>
 #include <cstdint>
 
 constexpr uint8_t  CAN_FRAME_MAX_DLC = 8;
 constexpr uint32_t MAX_N_AI_STR_SIZE =
     72; // 72 = 40 (N_TAtype) + 3 (N_SA) + 3 (N_TA) + 25 (for the format string) + 1 (for the null terminator)
+constexpr uint32_t MAX_FRAME_DATA_STR_SIZE =
+    (CAN_FRAME_MAX_DLC * 2) + 1; // 17 = 2 hex characters per data byte + 1 (null terminator)
 constexpr uint32_t MAX_FRAME_STR_SIZE =
     181; // 181 = 72 (N_AI) + 5 (flags) + 1 (data_length_code) + 17 (data) + 85 (format string) + 1 (null terminator)
 
@@ -69,6 +72,15 @@ const char* N_TAtypeToString(N_TAtype_t nTAtype);
  */
 const char* nAiToString(const N_AI& nAi);
 
+/**
+ * @brief Convert N_AI to string into a buffer provided by the caller, so it is safe to use from several threads.
+ * @param nAi The N_AI to convert.
+ * @param buffer The buffer to write the string to, MAX_N_AI_STR_SIZE bytes are enough for any N_AI.
+ * @param bufferSize The size of the buffer.
+ * @return buffer.
+ */
+const char* nAiToString(const N_AI& nAi, char* buffer, size_t bufferSize);
+
 /**
  * @brief Convert frame data to string.
  * @param data Pointer to the data bytes.
@@ -79,6 +91,16 @@ const char* nAiToString(const N_AI& nAi);
  */
 const char* frameDataToString(const uint8_t* data, uint8_t data_length_code);
 
+/**
+ * @brief Convert frame data to string into a buffer provided by the caller, so it is safe to use from several threads.
+ * @param data Pointer to the data bytes.
+ * @param data_length_code The length of the data in bytes.
+ * @param buffer The buffer to write the string to, MAX_FRAME_DATA_STR_SIZE bytes are enough for any frame.
+ * @param bufferSize The size of the buffer.
+ * @return buffer.
+ */
+const char* frameDataToString(const uint8_t* data, uint8_t data_length_code, char* buffer, size_t bufferSize);
+
 /**
  * @brief Convert CANFrame to string.
  * @param frame The CANFrame to convert.
@@ -88,6 +110,15 @@ const char* frameDataToString(const uint8_t* data, uint8_t data_length_code);
  */
 const char* frameToString(const CANFrame& frame);
 
+/**
+ * @brief Convert CANFrame to string into a buffer provided by the caller, so it is safe to use from several threads.
+ * @param frame The CANFrame to convert.
+ * @param buffer The buffer to write the string to, MAX_FRAME_STR_SIZE bytes are enough for any frame.
+ * @param bufferSize The size of the buffer.
+ * @return buffer.
+ */
+const char* frameToString(const CANFrame& frame, char* buffer, size_t bufferSize);
+
 /**
  * @brief Interface for a CAN bus driver.
  */
@@ -96,6 +127,27 @@ class CANInterface
 public:
     using ACKResult = enum ACKResult { ACK_SUCCESS, ACK_ERROR, ACK_NONE };
 
+    /**
+     * @brief Identifies a written frame until its ACK is reported, so the ACKs can be matched to their frames in any
+     * order. A token can be reused once the ACK of its frame was reported.
+     */
+    using TxToken = uint32_t;
+
+    /**
+     * @brief Function called by the driver when there is new work for the user of the interface.
+     * @param context The context registered with the callback.
+     */
+    using WakeupCallback = void (*)(void* context);
+
+    /**
+     * @brief Function called by the driver when a frame written with writeFrameWithToken() finishes transmission.
+     * @param context The context registered with the callback.
+     * @param token The token of the frame.
+     * @param ack The result of the transmission.
+     * @return True if the confirmation was taken, false if the driver must keep it for getWriteFrameACKWithToken().
+     */
+    using TxConfirmationCallback = bool (*)(void* context, TxToken token, ACKResult ack);
+
     /**
      * @brief Check if a frame is available to read.
      * @return Number of frames available to read. or 0 if no frames are available, or the bus is not active.
@@ -129,6 +181,28 @@ public:
      */
     virtual ACKResult getWriteFrameACK() = 0;
 
+    /**
+     * @brief Write a frame to the CAN bus and get the token its ACK will be reported with.
+     * The default implementation uses writeFrame() and numbers the frames in write order, which is right for drivers
+     * that report the ACKs in that order. Drivers that confirm out of order (e.g. several TX mailboxes) override it
+     * together with getWriteFrameACKWithToken().
+     * @param frame Pointer to a CANFrame struct to write to the bus.
+     * @param token Set to the token of the frame if it was written.
+     * @return True if the frame was written, false if the bus is not active, or the frame was not written.
+     * @note The default implementation is not synchronized with getWriteFrameACKWithToken(), the caller serializes
+     * them.
+     */
+    virtual bool writeFrameWithToken(CANFrame* frame, TxToken& token);
+
+    /**
+     * @brief Get the ACK result of a frame written with writeFrameWithToken(), and the token of that frame.
+     * The default implementation uses getWriteFrameACK() and numbers the ACKs in report order.
+     * @param token Set to the token of the acknowledged frame if an ACK is returned.
+     * @return The result of the ACK or ACK_NONE if no message finished transmission since the last call to this
+     * function, or the bus is not active.
+     */
+    virtual ACKResult getWriteFrameACKWithToken(TxToken& token);
+
     /**
      * @brief Convert ACKResult to string.
      * @param ackResult The ACKResult to convert.
@@ -136,7 +210,64 @@ public:
      */
     static const char* ackResultToString(ACKResult ackResult);
 
+    /**
+     * @brief Set the function to call when a frame is received or a written frame finishes transmission, so the user
+     * of the interface can sleep instead of polling it. There is a single callback: it is only set if no other one is.
+     * @param callback The function to call, or nullptr to stop notifying.
+     * @param context The context passed to the callback.
+     * @return True if the callback was set, false if another callback is already set.
+     *
+     * @note Drivers that never call notifyWakeup() are still supported, their users must poll them periodically.
+     * @warning Set the callback before the driver starts notifying, it is not synchronized with notifyWakeup().
+     */
+    bool setWakeupCallback(WakeupCallback callback, void* context);
+
+    /**
+     * @brief Stop notifying the callback set by setWakeupCallback(), if it is still the one set with this context.
+     * @param context The context the callback was set with.
+     */
+    void clearWakeupCallback(const void* context);
+
+    /**
+     * @brief Set the function to call when a written frame finishes transmission, so the user of the interface gets
+     * the ACKs as they happen instead of polling getWriteFrameACKWithToken().
+     * @param callback The function to call, or nullptr to stop pushing the ACKs.
+     * @param context The context passed to the callback.
+     *
+     * @note Polling stays the fallback: drivers that never call notifyTxConfirmation() are still supported, and the
+     * ACKs the callback does not take are still returned by getWriteFrameACKWithToken().
+     * @warning Set the callback before the driver starts notifying, it is not synchronized with notifyTxConfirmation().
+     */
+    void setTxConfirmationCallback(TxConfirmationCallback callback, void* context);
+
     virtual ~CANInterface() = default;
+
+protected:
+    /**
+     * @brief Notify the user of the interface that a frame is available to read or an ACK is available.
+     * It can be called from any thread, but not from an ISR: the callbacks of ISOTP and CANBusDispatcher take locks and
+     * signal the sleeping threads. An ISR should defer the notification to a driver thread.
+     */
+    void notifyWakeup() const;
+
+    /**
+     * @brief Push the ACK of a frame written with writeFrameWithToken() to the user of the interface, and wake it up.
+     * It can be called from any thread, but not from an ISR (see notifyWakeup()). Drivers that call it override
+     * writeFrameWithToken() to return the token they confirm the frame with.
+     * @param token The token of the frame.
+     * @param ack The result of the transmission.
+     * @return True if the ACK was taken, false if there is no callback or it did not take it: the driver keeps the ACK
+     * and returns it from getWriteFrameACKWithToken().
+     */
+    bool notifyTxConfirmation(TxToken token, ACKResult ack) const;
+
+private:
+    WakeupCallback         wakeupCallback                = nullptr;
+    void*                  wakeupCallbackContext         = nullptr;
+    TxConfirmationCallback txConfirmationCallback        = nullptr;
+    void*                  txConfirmationCallbackContext = nullptr;
+    TxToken                nextWriteToken                = 0; // Of the default writeFrameWithToken().
+    TxToken                nextACKToken                  = 0; // Of the default getWriteFrameACKWithToken().
 };
 
 #endif // CANInterface_h
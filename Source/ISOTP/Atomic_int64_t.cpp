@@ -1,5 +1,56 @@
 #include "Atomic_int64_t.h"
 
+#if ATOMIC_INT64_T_LOCK_FREE
+
+static_assert(std::atomic<int64_t>::is_always_lock_free, "ATOMIC_INT64_T_LOCK_FREE requires lock-free int64_t");
+
+Atomic_int64_t::Atomic_int64_t(const int64_t initialValue, OSInterface& OSInterface) : internalValue(initialValue)
+{
+    this->osInterface = &OSInterface;
+}
+
+Atomic_int64_t::~Atomic_int64_t() = default;
+
+bool Atomic_int64_t::get(int64_t* out, [[maybe_unused]] const uint32_t timeout) const
+{
+    *out = internalValue.load();
+    return true;
+}
+
+bool Atomic_int64_t::set(const int64_t newValue, [[maybe_unused]] const uint32_t timeout)
+{
+    internalValue.store(newValue);
+    return true;
+}
+
+bool Atomic_int64_t::add(const int64_t amount, [[maybe_unused]] const uint32_t timeout)
+{
+    internalValue.fetch_add(amount);
+    return true;
+}
+
+bool Atomic_int64_t::sub(const int64_t amount, [[maybe_unused]] const uint32_t timeout)
+{
+    internalValue.fetch_sub(amount);
+    return true;
+}
+
+bool Atomic_int64_t::subIfResIsGreaterThanZero(const int64_t amount, [[maybe_unused]] const uint32_t timeout)
+{
+    int64_t current = internalValue.load();
+    do
+    {
+        if (current - amount <= 0)
+        {
+            return false;
+        }
+    }
+    while (!internalValue.compare_exchange_weak(current, current - amount)); // On failure, current is reloaded.
+    return true;
+}
+
+#else
+
 Atomic_int64_t::Atomic_int64_t(const int64_t initialValue, OSInterface& OSInterface)
 {
     this->osInterface = &OSInterface;
@@ -71,3 +122,5 @@ bool Atomic_int64_t::subIfResIsGreaterThanZero(const int64_t amount, const uint3
     }
     return false;
 }
+
+#endif
@@ -0,0 +1,258 @@
+#include "CANBusDispatcher.h"
+
+#include "ISOTP_Common.h"
+
+CANBusDispatcher::CANBusDispatcher(CANInterface& canInterface, OSInterface& osInterface, const char* tag)
+{
+    this->tag          = tag;
+    this->canInterface = &canInterface;
+    this->mutex        = osInterface.osCreateMutex();
+    this->pendingAcks.fill({nullptr, 0});
+
+    if (!this->canInterface->setWakeupCallback(wakeupCallback, this))
+    {
+        OSInterfaceLogWarning(this->tag, "The CANInterface already wakes up another user, the connections are polled");
+    }
+}
+
+CANBusDispatcher::~CANBusDispatcher()
+{
+    this->canInterface->clearWakeupCallback(this);
+
+    for (auto& connection : this->connections)
+    {
+        delete connection.load();
+    }
+    delete this->mutex;
+}
+
+CANInterface* CANBusDispatcher::getCANInterface(const typeof(N_AI::N_SA) nSA)
+{
+    if (!this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex to get the connection of N_SA=%u", nSA);
+        return nullptr;
+    }
+
+    Connection* connection = this->connections[nSA].load();
+    if (connection == nullptr)
+    {
+        connection = new Connection(*this);
+        this->connections[nSA].store(connection);
+        OSInterfaceLogInfo(this->tag, "Created the connection of N_SA=%u", nSA);
+    }
+    this->mutex->signal();
+    return connection;
+}
+
+CANBusDispatcher::PendingAck& CANBusDispatcher::slotOf(const CANInterface::TxToken token)
+{
+    return this->pendingAcks[token % CANBusDispatcher_PendingAcksCapacity];
+}
+
+void CANBusDispatcher::pump()
+{
+    CANFrame frame;
+    // Bounded by the frames available when the pump starts, so a busy bus cannot keep a connection here.
+    for (uint32_t available = this->canInterface->frameAvailable(); available > 0; available--)
+    {
+        if (!this->canInterface->readFrame(&frame))
+        {
+            break;
+        }
+        route(frame);
+    }
+
+    CANInterface::TxToken   token = 0;
+    CANInterface::ACKResult ack;
+    while ((ack = this->canInterface->getWriteFrameACKWithToken(token)) != CANInterface::ACK_NONE)
+    {
+        PendingAck& pendingAck = slotOf(token);
+        if (pendingAck.connection == nullptr || pendingAck.token != token)
+        {
+            OSInterfaceLogWarning(this->tag, "No connection is waiting for ACK %s of token %u",
+                                  CANInterface::ackResultToString(ack), token);
+            continue;
+        }
+        Connection* connection = pendingAck.connection;
+        pendingAck.connection  = nullptr;
+        // Pushed to its user if it takes it (it is woken up then), kept to be polled otherwise.
+        if (!connection->confirm(token, ack))
+        {
+            connection->acks.emplace_back(token, ack);
+            connection->wakeup();
+        }
+    }
+}
+
+void CANBusDispatcher::route(const CANFrame& frame)
+{
+    if (frame.identifier.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional)
+    {
+        // Each ISOTP instance filters the functional N_TAs it accepts.
+        for (auto& connection : this->connections)
+        {
+            if (Connection* c = connection.load(); c != nullptr)
+            {
+                deliver(*c, frame);
+            }
+        }
+    }
+    else if (Connection* connection = this->connections[frame.identifier.N_TA].load(); connection != nullptr)
+    {
+        deliver(*connection, frame);
+    }
+    else
+    {
+        OSInterfaceLogVerbose(this->tag, "Discarding frame for N_TA=%u, it has no connection", frame.identifier.N_TA);
+    }
+}
+
+void CANBusDispatcher::deliver(Connection& connection, const CANFrame& frame) const
+{
+    if (connection.frames.size() >= CANBusDispatcher_MaxQueuedFrames)
+    {
+        OSInterfaceLogWarning(this->tag, "Too many frames queued for N_TA=%u, discarding frame", frame.identifier.N_TA);
+        return;
+    }
+    connection.frames.push_back(frame);
+    connection.wakeup(); // It may be sleeping, the frame was read by another connection.
+}
+
+void CANBusDispatcher::wakeupCallback(void* context)
+{
+    for (const auto& connection : static_cast<CANBusDispatcher*>(context)->connections)
+    {
+        if (const Connection* c = connection.load(); c != nullptr)
+        {
+            c->wakeup();
+        }
+    }
+}
+
+CANBusDispatcher::Connection::Connection(CANBusDispatcher& dispatcher)
+{
+    this->dispatcher = &dispatcher;
+}
+
+bool CANBusDispatcher::Connection::lock() const
+{
+    if (!this->dispatcher->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(this->dispatcher->tag, "Failed to acquire mutex");
+        return false;
+    }
+    return true;
+}
+
+void CANBusDispatcher::Connection::unlock() const
+{
+    this->dispatcher->mutex->signal();
+}
+
+uint32_t CANBusDispatcher::Connection::frameAvailable()
+{
+    if (!lock())
+    {
+        return 0;
+    }
+    this->dispatcher->pump();
+    const uint32_t available = this->frames.size();
+    unlock();
+    return available;
+}
+
+bool CANBusDispatcher::Connection::readFrame(CANFrame* frame)
+{
+    if (!lock())
+    {
+        return false;
+    }
+    if (this->frames.empty())
+    {
+        this->dispatcher->pump();
+        if (this->frames.empty())
+        {
+            unlock();
+            return false;
+        }
+    }
+    *frame = this->frames.front();
+    this->frames.pop_front();
+    unlock();
+    return true;
+}
+
+bool CANBusDispatcher::Connection::writeFrame(CANFrame* frame)
+{
+    TxToken token;
+    return writeFrameWithToken(frame, token);
+}
+
+bool CANBusDispatcher::Connection::writeFrameWithToken(CANFrame* frame, TxToken& token)
+{
+    // The write and the registration of its ACK owner are done together, so an ACK always finds its connection. The
+    // token of the shared CANInterface is unique among the connections, so it is given as is.
+    if (!lock())
+    {
+        return false;
+    }
+    if (!this->dispatcher->canInterface->writeFrameWithToken(frame, token))
+    {
+        unlock();
+        return false;
+    }
+    PendingAck& pendingAck = this->dispatcher->slotOf(token);
+    if (pendingAck.connection != nullptr)
+    {
+        // The driver reused the token of a frame whose ACK it did not report, that ACK is lost.
+        OSInterfaceLogWarning(this->dispatcher->tag, "Token %u of an unacknowledged frame was reused, overwriting it",
+                              pendingAck.token);
+    }
+    pendingAck = {this, token};
+    unlock();
+    return true;
+}
+
+bool CANBusDispatcher::Connection::active()
+{
+    return this->dispatcher->canInterface->active();
+}
+
+CANInterface::ACKResult CANBusDispatcher::Connection::getWriteFrameACK()
+{
+    TxToken token;
+    return getWriteFrameACKWithToken(token);
+}
+
+CANInterface::ACKResult CANBusDispatcher::Connection::getWriteFrameACKWithToken(TxToken& token)
+{
+    if (!lock())
+    {
+        return ACK_NONE;
+    }
+    if (this->acks.empty())
+    {
+        this->dispatcher->pump();
+        if (this->acks.empty())
+        {
+            unlock();
+            return ACK_NONE;
+        }
+    }
+    const ACKResult ack = this->acks.front().second;
+    token               = this->acks.front().first;
+    this->acks.pop_front();
+    unlock();
+    return ack;
+}
+
+void CANBusDispatcher::Connection::wakeup() const
+{
+    notifyWakeup();
+}
+
+bool CANBusDispatcher::Connection::confirm(const TxToken token, const ACKResult ack) const
+{
+    return notifyTxConfirmation(token, ack);
+}
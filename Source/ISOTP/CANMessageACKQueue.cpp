@@ -1,130 +1,279 @@
 #include "CANMessageACKQueue.h"
 #include <N_USData_Runner.h>
 
-CANMessageACKQueue::CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag)
+CANMessageACKQueue::CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag) :
+    pushedAcks(CANMessageACKQueue_Capacity)
 {
     this->tag          = tag;
     mutex              = osInterface.osCreateMutex();
     this->canInterface = &canInterface;
+    this->pendingFrames.fill({nullptr, 0, CANInterface::ACK_NONE});
+    this->pendingCount = 0;
+    this->ackedHead    = 0;
+    this->ackedCount   = 0;
+
+    this->canInterface->setTxConfirmationCallback(txConfirmationCallback, this);
 }
 CANMessageACKQueue::~CANMessageACKQueue()
 {
+    this->canInterface->setTxConfirmationCallback(nullptr, nullptr);
     delete mutex;
 }
 
-void CANMessageACKQueue::saveAck(const CANInterface::ACKResult ack)
+bool CANMessageACKQueue::txConfirmationCallback(void* context, const CANInterface::TxToken token,
+                                                const CANInterface::ACKResult ack)
 {
-    if (!messageQueue.empty())
+    // Called by a thread of the driver, which may be writing a frame with the mutex held: no locking and no logging. If
+    // the queue is full, the driver keeps the ACK and runStep() polls it.
+    return static_cast<CANMessageACKQueue*>(context)->pushedAcks.push(token, ack);
+}
+
+bool CANMessageACKQueue::storePushedAcks()
+{
+    bool                    ackReceived = false;
+    CANInterface::TxToken   token;
+    CANInterface::ACKResult ack;
+    while (this->pushedAcks.pop(token, ack))
     {
-        for (auto& [runner, runnerAck] : messageQueue)
-        {
-            if (runnerAck == CANInterface::ACK_NONE)
-            {
-                OSInterfaceLogDebug(this->tag, "Processing ACK %s for runner with N_AI=%s",
-                                    CANInterface::ackResultToString(ack), nAiToString(runner->getN_AI()));
-                runnerAck = ack; // Update the ACK result for the runner.
-                break;
-            }
-        }
+        OSInterfaceLogDebug(this->tag, "ACK pushed: %s (token %u)", CANInterface::ackResultToString(ack), token);
+        saveAck(token, ack);
+        ackReceived = true;
+    }
+    return ackReceived;
+}
+
+CANMessageACKQueue::PendingFrame& CANMessageACKQueue::slotOf(const CANInterface::TxToken token)
+{
+    return this->pendingFrames[token % CANMessageACKQueue_Capacity];
+}
+
+void CANMessageACKQueue::saveAck(const CANInterface::TxToken token, const CANInterface::ACKResult ack)
+{
+    PendingFrame& pendingFrame = slotOf(token);
+    if (pendingFrame.runner == nullptr || pendingFrame.token != token)
+    {
+        // Its runner was removed from the queue while the frame was being transmitted.
+        OSInterfaceLogWarning(this->tag, "No runner in queue to process ACK %s of token %u",
+                              CANInterface::ackResultToString(ack), token);
+        return;
+    }
+    if (pendingFrame.ack != CANInterface::ACK_NONE)
+    {
+        OSInterfaceLogWarning(this->tag, "Discarding ACK %s of token %u, it was already acknowledged",
+                              CANInterface::ackResultToString(ack), token);
+        return;
     }
-    else
+
+    char nAiStr[MAX_N_AI_STR_SIZE];
+    OSInterfaceLogDebug(this->tag, "Processing ACK %s of token %u for runner with N_AI=%s",
+                        CANInterface::ackResultToString(ack), token,
+                        nAiToString(pendingFrame.runner->getN_AI(), nAiStr, sizeof(nAiStr)));
+    if (this->ackedCount >= CANMessageACKQueue_Capacity)
     {
-        OSInterfaceLogWarning(this->tag, "No runners in queue to process ACK");
+        // Only possible if the driver reuses the tokens of frames whose ACK it did not report.
+        OSInterfaceLogError(this->tag, "Too many ACKs waiting for their callback, discarding ACK of token %u", token);
+        return;
     }
+    pendingFrame.ack = ack; // Update the ACK result for the runner.
+    this->ackedTokens[(this->ackedHead + this->ackedCount) % CANMessageACKQueue_Capacity] = token;
+    this->ackedCount++;
 }
-void CANMessageACKQueue::runStep()
+bool CANMessageACKQueue::runStep()
 {
-    if (const CANInterface::ACKResult ack = canInterface->getWriteFrameACK(); ack != CANInterface::ACK_NONE)
+    // The CANInterface is polled with the mutex held, so the tokens its default implementation numbers in order match
+    // the ones given to writeFrame().
+    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        OSInterfaceLogDebug(this->tag, "ACK received: %s", CANInterface::ackResultToString(ack));
-        if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
-        {
-            saveAck(ack);
-            mutex->signal();
-        }
-        else
-        {
-            OSInterfaceLogError(this->tag, "Failed to acquire mutex for ACK storage of %s",
-                                CANInterface::ackResultToString(ack));
-        }
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex for ACK storage");
+        return false;
+    }
+    bool ackReceived = storePushedAcks();
+
+    CANInterface::TxToken   token = 0;
+    CANInterface::ACKResult ack;
+    while ((ack = canInterface->getWriteFrameACKWithToken(token)) != CANInterface::ACK_NONE)
+    {
+        OSInterfaceLogDebug(this->tag, "ACK received: %s (token %u)", CANInterface::ackResultToString(ack), token);
+        saveAck(token, ack);
+        ackReceived = true;
+    }
+    mutex->signal();
+    return ackReceived;
+}
+
+bool CANMessageACKQueue::waitingForAcks() const
+{
+    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return false;
     }
+    const bool waiting = this->pendingCount > this->ackedCount;
+    mutex->signal();
+    return waiting;
 }
 
 void CANMessageACKQueue::runAvailableAckCallbacks()
 {
-    bool callbackHasRun = false;
+    const N_USData_Runner* ackedRunner = nullptr;
     do
     {
-        callbackHasRun = runNextAvailableAckCallback();
+        ackedRunner = runNextAvailableAckCallback();
     }
-    while (callbackHasRun);
+    while (ackedRunner != nullptr);
 }
 
-bool CANMessageACKQueue::runNextAvailableAckCallback()
+void CANMessageACKQueue::runAvailableAckCallbacks(std::vector<N_USData_Runner*>& ackedRunners)
 {
-    bool callbackHasRun = false;
-    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    while (N_USData_Runner* runner = runNextAvailableAckCallback())
     {
-        if (!messageQueue.empty())
-        {
-            if (const auto ack = messageQueue.front().second; ack != CANInterface::ACK_NONE)
-            {
-                auto* runner = messageQueue.front().first;
-
-                messageQueue.pop_front();
-                mutex->signal();
-
-                OSInterfaceLogDebug(this->tag, "Running callback for runner with N_AI=%s and ACK=%s",
-                                    nAiToString(runner->getN_AI()), CANInterface::ackResultToString(ack));
-                runner->messageACKReceivedCallback(ack);
-                callbackHasRun = true;
-            }
-            else
-            {
-                mutex->signal();
-                callbackHasRun = false; // No more callbacks to run.
-                OSInterfaceLogDebug(this->tag, "No ACK available for the first runner in the queue");
-            }
-        }
-        else
+        ackedRunners.push_back(runner);
+    }
+}
+
+N_USData_Runner* CANMessageACKQueue::runNextAvailableAckCallback()
+{
+    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return nullptr;
+    }
+    storePushedAcks();
+    while (this->ackedCount > 0)
+    {
+        const CANInterface::TxToken token = this->ackedTokens[this->ackedHead];
+        this->ackedHead                   = (this->ackedHead + 1) % CANMessageACKQueue_Capacity;
+        this->ackedCount--;
+
+        PendingFrame& pendingFrame = slotOf(token);
+        if (pendingFrame.runner == nullptr || pendingFrame.token != token || pendingFrame.ack == CANInterface::ACK_NONE)
         {
-            mutex->signal();
-            callbackHasRun = false; // No more callbacks to run.
-            OSInterfaceLogDebug(this->tag, "No runners in queue to run callbacks");
+            continue; // The frame of this token was replaced after the ACK was stored.
         }
+        N_USData_Runner*              runner = pendingFrame.runner;
+        const CANInterface::ACKResult ack    = pendingFrame.ack;
+        pendingFrame.runner                  = nullptr;
+        this->pendingCount--;
+        mutex->signal();
+
+        char nAiStr[MAX_N_AI_STR_SIZE];
+        OSInterfaceLogDebug(this->tag, "Running callback for runner with N_AI=%s and ACK=%s",
+                            nAiToString(runner->getN_AI(), nAiStr, sizeof(nAiStr)),
+                            CANInterface::ackResultToString(ack));
+        runner->messageACKReceivedCallback(ack);
+        return runner;
     }
-    return callbackHasRun;
+    mutex->signal();
+    OSInterfaceLogDebug(this->tag, "No ACK available to run callbacks");
+    return nullptr; // nullptr when there are no more callbacks to run.
 }
 
 bool CANMessageACKQueue::writeFrame(N_USData_Runner& runner, CANFrame& frame)
 {
-    OSInterfaceLogDebug(this->tag, "Writing frame with N_AI=%s", nAiToString(frame.identifier));
-    OSInterfaceLogVerbose(this->tag, "Writing frame: %s", frameToString(frame));
-    bool res = canInterface->writeFrame(&frame);
-    if (res && mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    char nAiStr[MAX_N_AI_STR_SIZE];
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogDebug(this->tag, "Writing frame with N_AI=%s", nAiToString(frame.identifier, nAiStr, sizeof(nAiStr)));
+    OSInterfaceLogVerbose(this->tag, "Writing frame: %s", frameToString(frame, frameStr, sizeof(frameStr)));
+    // The frame is written with the mutex held, so an ACK polled by another thread always finds its runner queued.
+    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex for writing frame with N_AI=%s",
+                            nAiToString(frame.identifier, nAiStr, sizeof(nAiStr)));
+        return false;
+    }
+    if (this->pendingCount >= CANMessageACKQueue_Capacity)
     {
-        messageQueue.emplace_back(&runner, CANInterface::ACK_NONE);
         mutex->signal();
+        OSInterfaceLogError(this->tag, "Too many frames waiting for their ACK, not writing frame with N_AI=%s",
+                            nAiToString(frame.identifier, nAiStr, sizeof(nAiStr)));
+        return false;
     }
+    CANInterface::TxToken token = 0;
+    const bool            res   = canInterface->writeFrameWithToken(&frame, token);
+    if (res)
+    {
+        PendingFrame& pendingFrame = slotOf(token);
+        if (pendingFrame.runner != nullptr)
+        {
+            // The driver reused a token whose ACK was not reported, the previous frame will time out.
+            OSInterfaceLogError(this->tag, "Token %u of frame with N_AI=%s is still waiting for its ACK", token,
+                                nAiToString(frame.identifier, nAiStr, sizeof(nAiStr)));
+        }
+        else
+        {
+            this->pendingCount++;
+        }
+        pendingFrame = {&runner, token, CANInterface::ACK_NONE};
+    }
+    mutex->signal();
     return res;
 }
 
-bool CANMessageACKQueue::removeFromQueue(const N_AI runnerNAi)
+template <typename Predicate> bool CANMessageACKQueue::removeFrames(Predicate isRemoved, size_t& removed)
 {
-    size_t res = 0;
-    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    removed = 0;
+    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return false;
+    }
+    for (auto& pendingFrame : this->pendingFrames)
+    {
+        if (pendingFrame.runner != nullptr && isRemoved(*pendingFrame.runner))
+        {
+            pendingFrame.runner = nullptr;
+            this->pendingCount--;
+            removed++;
+        }
+    }
+
+    // Drop the ACKed tokens of the removed frames, so the ring only holds the tokens of pending frames.
+    size_t kept = 0;
+    for (size_t i = 0; i < this->ackedCount; i++)
     {
-        res = messageQueue.remove_if([&runnerNAi](const auto& pair)
-                                     { return pair.first->getN_AI().N_AI == runnerNAi.N_AI; });
+        const CANInterface::TxToken token = this->ackedTokens[(this->ackedHead + i) % CANMessageACKQueue_Capacity];
+        if (slotOf(token).runner != nullptr)
+        {
+            this->ackedTokens[(this->ackedHead + kept) % CANMessageACKQueue_Capacity] = token;
+            kept++;
+        }
+    }
+    this->ackedCount = kept;
 
-        mutex->signal();
+    mutex->signal();
+    return true;
+}
+
+bool CANMessageACKQueue::removeFromQueue(const N_AI runnerNAi)
+{
+    size_t removed;
+    char   nAiStr[MAX_N_AI_STR_SIZE];
+    if (!removeFrames([runnerNAi](const N_USData_Runner& runner) { return runner.getN_AI().N_AI == runnerNAi.N_AI; },
+                      removed))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex for removing runner with N_AI=%s from queue",
+                            nAiToString(runnerNAi, nAiStr, sizeof(nAiStr)));
+        return false;
+    }
+    if (removed == 0)
+    {
         OSInterfaceLogDebug(this->tag, "Runners with N_AI=%s not found in queue when attempting to remove it",
-                            nAiToString(runnerNAi));
+                            nAiToString(runnerNAi, nAiStr, sizeof(nAiStr)));
     }
-    else
+    return removed > 0;
+}
+
+bool CANMessageACKQueue::removeFromQueue(const N_USData_Runner& runner)
+{
+    size_t removed;
+    char   nAiStr[MAX_N_AI_STR_SIZE];
+    if (!removeFrames([&runner](const N_USData_Runner& queuedRunner) { return &queuedRunner == &runner; }, removed))
     {
         OSInterfaceLogError(this->tag, "Failed to acquire mutex for removing runner with N_AI=%s from queue",
-                            nAiToString(runnerNAi));
+                            nAiToString(runner.getN_AI(), nAiStr, sizeof(nAiStr)));
+        return false;
+    }
+    if (removed > 0)
+    {
+        OSInterfaceLogDebug(this->tag, "Freed the %zu slots of the runner with N_AI=%s", removed,
+                            nAiToString(runner.getN_AI(), nAiStr, sizeof(nAiStr)));
     }
-    return res > 0;
+    return removed > 0;
 }
@@ -2,7 +2,9 @@
 
 #include "ISOTP.h"
 
+#include <cstring>
 #include <ranges>
+#include <type_traits>
 
 #include "N_USData_Indication_Runner.h"
 #include "N_USData_Request_Runner.h"
@@ -10,9 +12,12 @@
 ISOTP::ISOTP(const typeof(N_AI::N_SA) nSA, const uint32_t totalAvailableMemoryForRunners,
              const N_USData_confirm_cb_t N_USData_confirm_cb, const N_USData_indication_cb_t N_USData_indication_cb,
              const N_USData_FF_indication_cb_t N_USData_FF_indication_cb, OSInterface& osInterface,
-             CANInterface& canInterface, const uint8_t blockSize, const STmin stMin, const char* tag) :
-    osInterface(osInterface), canInterface(canInterface),
-    availableMemoryForRunners(totalAvailableMemoryForRunners, osInterface)
+             CANInterface& canInterface, const uint8_t blockSize, const STmin stMin, const char* tag,
+             const bool useMemoryArena, const size_t runnerPoolCapacity) :
+    osInterface(osInterface), canInterface(canInterface), rxWakeupSignal(osInterface), txWakeupSignal(osInterface),
+    callbackWakeupSignal(osInterface),
+    availableMemoryForRunners(totalAvailableMemoryForRunners, osInterface),
+    submittedRunners(ISOTP_SubmissionQueueCapacity)
 {
     this->tag = tag;
 
@@ -20,22 +25,61 @@ ISOTP::ISOTP(const typeof(N_AI::N_SA) nSA, const uint32_t totalAvailableMemoryFo
     ASSERT_SAFE(populateQueueTag(), == true);
 
     this->canMessageAckQueue = new CANMessageACKQueue(canInterface, osInterface, this->queueTag);
-    this->nSA                = nSA;
+
+    this->messageArena = nullptr;
+    if (useMemoryArena)
+    {
+        bool arenaReserved = false;
+        this->messageArena = new MemoryArena(arenaReserved, totalAvailableMemoryForRunners, osInterface);
+        if (!arenaReserved)
+        {
+            OSInterfaceLogError(tag, "Failed to reserve a memory arena of %u bytes, using osMalloc instead",
+                                totalAvailableMemoryForRunners);
+            delete this->messageArena;
+            this->messageArena = nullptr;
+        }
+    }
+
+    bool poolCreated = false;
+    this->runnerPool = new RunnerPool(poolCreated, runnerPoolCapacity, this->availableMemoryForRunners, osInterface,
+                                      *this->canMessageAckQueue, this->messageArena);
+    if (!poolCreated)
+    {
+        OSInterfaceLogError(tag, "Failed to create the %zu runners of each type of the pool", runnerPoolCapacity);
+    }
+
+    this->nSA = nSA;
     this->availableMemoryForRunners.set(totalAvailableMemoryForRunners);
     this->N_USData_confirm_cb       = N_USData_confirm_cb;
     this->N_USData_indication_cb    = N_USData_indication_cb;
     this->N_USData_FF_indication_cb = N_USData_FF_indication_cb;
-    this->blockSize                 = blockSize;
     this->lastRunTime               = 0;
+    this->ackLastRunTime            = 0;
+    this->workersRunning            = false;
+    this->rxWorker                  = nullptr;
+    this->txWorker                  = nullptr;
+    this->callbackWorker            = nullptr;
 
-    this->configMutex            = this->osInterface.osCreateMutex();
-    this->notStartedRunnersMutex = this->osInterface.osCreateMutex();
-    this->runnersMutex           = this->osInterface.osCreateMutex();
+    this->configMutex           = this->osInterface.osCreateMutex();
+    this->runnersMutex          = this->osInterface.osCreateMutex();
+    this->completedRunnersMutex = this->osInterface.osCreateMutex();
 
-    assert(this->configMutex != nullptr && this->notStartedRunnersMutex != nullptr && "Mutex creation failed");
+    assert(this->configMutex != nullptr && this->runnersMutex != nullptr && this->completedRunnersMutex != nullptr &&
+           "Mutex creation failed");
 
+    auto* initialConfig =
+        new ConfigSnapshot{{}, {}, blockSize, ISOTP_DefaultSTmin, ISOTP_DefaultMaxFramesPerStep, false, {}, {}};
+    initialConfig->acceptedPhysicalN_SAs.set(nSA);
+    this->config        = initialConfig;
+    this->configReaders = 0;
     ASSERT_SAFE(setSTmin(stMin), == true);
 
+    if (!this->canInterface.setWakeupCallback(wakeupCallback, this))
+    {
+        OSInterfaceLogWarning(this->tag, "The CANInterface already wakes up another user, it is polled every %u ms",
+                              ISOTP_MaxWaitForWork_MS);
+    }
+
     if (this->N_USData_confirm_cb == nullptr)
     {
         OSInterfaceLogWarning(this->tag, "N_USData_confirm_cb is nullptr");
@@ -57,28 +101,49 @@ const char* ISOTP::getTag() const
 
 ISOTP::~ISOTP()
 {
+    stop();
+    this->canInterface.clearWakeupCallback(this);
+
     if (this->queueTag != nullptr)
     {
         this->osInterface.osFree(this->queueTag);
     }
     delete this->canMessageAckQueue;
 
-    for (auto& runner : this->notStartedRunners)
+    takeSubmittedRunners();
+    std::list<N_USData_Runner*> pendingRunners;
+    this->notStartedRunners.takeAll(pendingRunners);
+    for (auto& runner : pendingRunners)
     {
-        delete runner;
+        this->runnerPool->release(runner);
     }
     for (auto& runner : this->activeRunners | std::views::values)
     {
-        delete runner;
+        this->runnerPool->release(runner);
     }
     for (auto& runner : this->finishedRunners)
     {
-        delete runner;
+        this->runnerPool->release(runner);
     }
+    delete this->runnerPool;
+    delete this->messageArena;
+
+    freeRetiredConfigs();
+    delete this->config.load();
 
     delete this->configMutex;
-    delete this->notStartedRunnersMutex;
     delete this->runnersMutex;
+    delete this->completedRunnersMutex;
+}
+
+bool ISOTP::getMemoryArenaStats(MemoryArena::Stats& stats) const
+{
+    if (this->messageArena == nullptr)
+    {
+        return false;
+    }
+    stats = this->messageArena->getStats();
+    return true;
 }
 
 bool ISOTP::populateQueueTag()
@@ -96,57 +161,124 @@ bool ISOTP::populateQueueTag()
 
 typeof(N_AI::N_SA) ISOTP::getN_SA() const
 {
+    return this->nSA;
+}
+
+const ISOTP::ConfigSnapshot* ISOTP::acquireConfig() const
+{
+    // Counted before the snapshot is loaded: a setter that does not see this reader published its snapshot before, so
+    // it is the one loaded.
+    this->configReaders.fetch_add(1);
+    return this->config.load();
+}
+
+void ISOTP::releaseConfig() const
+{
+    this->configReaders.fetch_sub(1);
+}
+
+template <typename F> void ISOTP::updateConfig(F&& update)
+{
+    static_assert(std::is_trivially_copyable_v<ConfigSnapshot>, "Snapshots are copied on every update");
     configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    typeof(N_AI::N_SA) NSA = this->nSA;
+    const ConfigSnapshot* previous = this->config.load();
+    auto*                 next     = new ConfigSnapshot(*previous);
+    update(*next);
+    this->config.store(next);
+
+    this->retiredConfigs.push_back(previous);
+    freeRetiredConfigs();
     configMutex->signal();
-    return NSA;
+}
+
+void ISOTP::freeRetiredConfigs()
+{
+    // A reader may hold any of the retired snapshots, they are freed by the first setter that sees none.
+    if (this->configReaders.load() != 0)
+    {
+        return;
+    }
+    for (const ConfigSnapshot* retired : this->retiredConfigs)
+    {
+        delete retired;
+    }
+    this->retiredConfigs.clear();
 }
 
 void ISOTP::addAcceptedFunctionalN_TA(const typeof(N_AI::N_TA) nTA)
 {
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    this->acceptedFunctionalN_TAs.insert(nTA);
-    configMutex->signal();
+    updateConfig([nTA](ConfigSnapshot& cfg) { cfg.acceptedFunctionalN_TAs.set(nTA); });
 }
 
 bool ISOTP::removeAcceptedFunctionalN_TA(const typeof(N_AI::N_TA) nTA)
 {
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    bool res = this->acceptedFunctionalN_TAs.erase(nTA) == 1;
-    configMutex->signal();
+    bool res = false;
+    updateConfig(
+        [nTA, &res](ConfigSnapshot& cfg)
+        {
+            res = cfg.acceptedFunctionalN_TAs.test(nTA);
+            cfg.acceptedFunctionalN_TAs.reset(nTA);
+        });
+    return res;
+}
+
+void ISOTP::addAcceptedPhysicalN_SA(const typeof(N_AI::N_SA) nSA)
+{
+    updateConfig([nSA](ConfigSnapshot& cfg) { cfg.acceptedPhysicalN_SAs.set(nSA); });
+}
+
+bool ISOTP::removeAcceptedPhysicalN_SA(const typeof(N_AI::N_SA) nSA)
+{
+    if (nSA == this->nSA)
+    {
+        return false;
+    }
+    bool res = false;
+    updateConfig(
+        [nSA, &res](ConfigSnapshot& cfg)
+        {
+            res = cfg.acceptedPhysicalN_SAs.test(nSA);
+            cfg.acceptedPhysicalN_SAs.reset(nSA);
+        });
+    return res;
+}
+
+bool ISOTP::hasAcceptedPhysicalN_SA(const typeof(N_AI::N_SA) nSA)
+{
+    const ConfigSnapshot* cfg = acquireConfig();
+    bool                  res = cfg->acceptedPhysicalN_SAs.test(nSA);
+    releaseConfig();
     return res;
 }
 
 bool ISOTP::hasAcceptedFunctionalN_TA(const typeof(N_AI::N_TA) nTA)
 {
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    bool res = this->acceptedFunctionalN_TAs.contains(nTA);
-    configMutex->signal();
+    const ConfigSnapshot* cfg = acquireConfig();
+    bool                  res = cfg->acceptedFunctionalN_TAs.test(nTA);
+    releaseConfig();
     return res;
 }
 
 uint8_t ISOTP::getBlockSize() const
 {
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    uint8_t bs = this->blockSize;
-    configMutex->signal();
+    const ConfigSnapshot* cfg = acquireConfig();
+    uint8_t               bs  = cfg->blockSize;
+    releaseConfig();
     return bs;
 }
 
 bool ISOTP::setBlockSize(const uint8_t bs)
 {
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    this->blockSize = bs;
-    configMutex->signal();
+    updateConfig([bs](ConfigSnapshot& cfg) { cfg.blockSize = bs; });
 
     return updateRunners();
 }
 
 STmin ISOTP::getSTmin() const
 {
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    const STmin stM = this->stMin;
-    configMutex->signal();
+    const ConfigSnapshot* cfg = acquireConfig();
+    const STmin           stM = cfg->stMin;
+    releaseConfig();
     return stM;
 }
 
@@ -157,73 +289,257 @@ bool ISOTP::setSTmin(const STmin stMin)
         return false;
     }
 
-    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    this->stMin = stMin;
-    configMutex->signal();
+    updateConfig([stMin](ConfigSnapshot& cfg) { cfg.stMin = stMin; });
 
     return updateRunners();
 }
 
+uint32_t ISOTP::getMaxFramesPerStep() const
+{
+    const ConfigSnapshot* cfg       = acquireConfig();
+    const uint32_t        maxFrames = cfg->maxFramesPerStep;
+    releaseConfig();
+    return maxFrames;
+}
+
+void ISOTP::setMaxFramesPerStep(const uint32_t maxFrames)
+{
+    updateConfig([maxFrames](ConfigSnapshot& cfg) { cfg.maxFramesPerStep = maxFrames; });
+}
+
+bool ISOTP::getPollAcksInRunStep() const
+{
+    const ConfigSnapshot* cfg      = acquireConfig();
+    const bool            pollAcks = cfg->pollAcksInRunStep;
+    releaseConfig();
+    return pollAcks;
+}
+
+void ISOTP::setPollAcksInRunStep(const bool pollAcks)
+{
+    updateConfig([pollAcks](ConfigSnapshot& cfg) { cfg.pollAcksInRunStep = pollAcks; });
+}
+
+N_USData_ReceiveBufferProvider ISOTP::getReceiveBufferProvider() const
+{
+    const ConfigSnapshot*                cfg      = acquireConfig();
+    const N_USData_ReceiveBufferProvider provider = cfg->rxBufferProvider;
+    releaseConfig();
+    return provider;
+}
+
+bool ISOTP::setReceiveBufferProvider(const N_USData_ReceiveBufferProvider provider)
+{
+    if (provider.getBuffer != nullptr && provider.releaseBuffer == nullptr)
+    {
+        OSInterfaceLogError(this->tag, "A receive buffer provider needs a releaseBuffer function");
+        return false;
+    }
+    updateConfig([provider](ConfigSnapshot& cfg) { cfg.rxBufferProvider = provider; });
+    return true;
+}
+
+N_USData_StreamingSink ISOTP::getStreamingSink() const
+{
+    const ConfigSnapshot*        cfg  = acquireConfig();
+    const N_USData_StreamingSink sink = cfg->streamingSink;
+    releaseConfig();
+    return sink;
+}
+
+void ISOTP::setStreamingSink(const N_USData_StreamingSink sink)
+{
+    updateConfig([sink](ConfigSnapshot& cfg) { cfg.streamingSink = sink; });
+}
+
 bool ISOTP::N_USData_request(const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType, const uint8_t* messageData,
                              const uint32_t length, const Mtype mType)
 {
-    bool             result;
-    N_AI             nAI    = ISOTP_N_AI_CONFIG(nTaType, nTa, getN_SA());
-    N_USData_Runner* runner = new N_USData_Request_Runner(result, nAI, availableMemoryForRunners, mType, messageData,
-                                                          length, osInterface, *canMessageAckQueue);
-    if (!result)
+    return N_USData_request(getN_SA(), nTa, nTaType, messageData, length, mType);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_SA) nSa, const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType,
+                             const uint8_t* messageData, const uint32_t length, const Mtype mType)
+{
+    N_AI nAI = ISOTP_N_AI_CONFIG(nTaType, nTa, nSa);
+    if (!hasAcceptedPhysicalN_SA(nSa))
+    {
+        char nAiStr[MAX_N_AI_STR_SIZE];
+        OSInterfaceLogError(this->tag, "Not accepted N_SA=%u, discarding request with N_AI=%s",
+                            nSa, nAiToString(nAI, nAiStr, sizeof(nAiStr)));
+        return false;
+    }
+    return submitRequest(runnerPool->acquireRequestRunner(nAI, mType, messageData, length), nAI);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType, const uint8_t* messageData,
+                             const uint32_t length, const N_USData_release_cb_t releaseCallback, void* releaseContext,
+                             const Mtype mType)
+{
+    return N_USData_request(getN_SA(), nTa, nTaType, messageData, length, releaseCallback, releaseContext, mType);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_SA) nSa, const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType,
+                             const uint8_t* messageData, const uint32_t length,
+                             const N_USData_release_cb_t releaseCallback, void* releaseContext, const Mtype mType)
+{
+    const N_USData_Segment segment = {messageData, length};
+    return N_USData_request(nSa, nTa, nTaType, &segment, 1, releaseCallback, releaseContext, mType);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType, const N_USData_Segment* segments,
+                             const uint8_t segmentCount, const N_USData_release_cb_t releaseCallback,
+                             void* releaseContext, const Mtype mType)
+{
+    return N_USData_request(getN_SA(), nTa, nTaType, segments, segmentCount, releaseCallback, releaseContext, mType);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_SA) nSa, const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType,
+                             const N_USData_Segment* segments, const uint8_t segmentCount,
+                             const N_USData_release_cb_t releaseCallback, void* releaseContext, const Mtype mType)
+{
+    N_AI nAI = ISOTP_N_AI_CONFIG(nTaType, nTa, nSa);
+    if (!hasAcceptedPhysicalN_SA(nSa))
     {
-        delete runner;
+        char nAiStr[MAX_N_AI_STR_SIZE];
+        OSInterfaceLogError(this->tag, "Not accepted N_SA=%u, discarding request with N_AI=%s", nSa,
+                            nAiToString(nAI, nAiStr, sizeof(nAiStr)));
         return false;
     }
-    if (notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    return submitRequest(
+        runnerPool->acquireRequestRunner(nAI, mType, segments, segmentCount, releaseCallback, releaseContext), nAI);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType, const uint32_t length,
+                             const N_USData_source_cb_t source, void* sourceContext, const Mtype mType)
+{
+    return N_USData_request(getN_SA(), nTa, nTaType, length, source, sourceContext, mType);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_SA) nSa, const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType,
+                             const uint32_t length, const N_USData_source_cb_t source, void* sourceContext,
+                             const Mtype mType)
+{
+    N_AI nAI = ISOTP_N_AI_CONFIG(nTaType, nTa, nSa);
+    if (!hasAcceptedPhysicalN_SA(nSa))
     {
-        notStartedRunners.push_back(runner);
-        notStartedRunnersMutex->signal();
-        return true;
+        char nAiStr[MAX_N_AI_STR_SIZE];
+        OSInterfaceLogError(this->tag, "Not accepted N_SA=%u, discarding request with N_AI=%s", nSa,
+                            nAiToString(nAI, nAiStr, sizeof(nAiStr)));
+        return false;
     }
-    delete runner;
-    return false;
+    return submitRequest(runnerPool->acquireRequestRunner(nAI, mType, length, source, sourceContext), nAI);
+}
+
+bool ISOTP::submitRequest(N_USData_Request_Runner* runner, const N_AI nAi)
+{
+    if (runner == nullptr)
+    {
+        return false;
+    }
+    if (!submittedRunners.push(runner))
+    {
+        char nAiStr[MAX_N_AI_STR_SIZE];
+        OSInterfaceLogError(this->tag, "Too many requests waiting to be started, discarding request with N_AI=%s",
+                            nAiToString(nAi, nAiStr, sizeof(nAiStr)));
+        runner->forgetLentMessage(); // The caller keeps its buffer.
+        runnerPool->release(runner);
+        return false;
+    }
+    notifyRxWorker();
+    return true;
 }
 
 void ISOTP::runFinishedRunnerCallbacks()
 {
+    // When the workers are running, the callbacks are left to the callback worker so they do not delay the next
+    // runStep.
+    const bool deferCallbacks = this->workersRunning;
+
     for (const auto runner : this->finishedRunners)
     {
-        OSInterfaceLogInfo(this->tag, "Runner %s finished with result %s", runner->getTAG(),
+        char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+        OSInterfaceLogInfo(this->tag, "Runner %s finished with result %s", runner->formatTag(tagStr, sizeof(tagStr)),
                            N_ResultToString(runner->getResult()));
-        // Call the callbacks.
-        if (runner->getRunnerType() == N_USData_Runner::RunnerRequestType)
+        if (!deferCallbacks)
         {
-            if (this->N_USData_confirm_cb != nullptr)
-            {
-                OSInterfaceLogInfo(this->tag, "Calling N_USData_confirm_cb of runner %s", runner->getTAG());
-                this->N_USData_confirm_cb(runner->getN_AI(), runner->getResult(), runner->getMtype());
-            }
+            runRunnerCallbacks(runner);
         }
-        else if (runner->getRunnerType() == N_USData_Runner::RunnerIndicationType)
+
+        // Remove the runner from activeRunners (runners that finished with their first frame were never added).
+        if (const auto it = this->activeRunners.find(runner->getN_AI().N_AI);
+            it != this->activeRunners.end() && it->second == runner)
         {
-            if (this->N_USData_indication_cb != nullptr)
-            {
-                OSInterfaceLogInfo(this->tag, "Calling N_USData_indication_cb of runner %s", runner->getTAG());
-                const uint8_t* messageData = runner->getMessageData();
-                this->N_USData_indication_cb(runner->getN_AI(), messageData, runner->getMessageLength(),
-                                             runner->getResult(), runner->getMtype());
-            }
+            this->activeRunners.erase(it);
+            this->notStartedRunners.release(runner->getN_AI()); // Its next message can start now.
+        }
+        this->activeRunnersDispatchIndex.erase(runner);
+        this->activeRunnersScheduler.remove(runner);
+        canMessageAckQueue->removeFromQueue(*runner);
+
+        if (deferCallbacks)
+        {
+            this->completedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+            this->completedRunners.push_back(runner);
+            this->completedRunnersMutex->signal();
         }
         else
         {
-            OSInterfaceLogError(this->tag, "Runner type is unknown");
+            this->runnerPool->release(runner);
         }
+    }
 
-        // Remove the runner from activeRunners.
-        this->activeRunners.erase(runner->getN_AI().N_AI);
-        canMessageAckQueue->removeFromQueue(runner->getN_AI());
-        delete runner;
+    if (deferCallbacks && !this->finishedRunners.empty())
+    {
+        notifyCallbackWorker();
     }
     this->finishedRunners.clear();
 }
 
+void ISOTP::runRunnerCallbacks(N_USData_Runner* runner)
+{
+    if (runner->getRunnerType() == N_USData_Runner::RunnerRequestType)
+    {
+        if (this->N_USData_confirm_cb != nullptr)
+        {
+            char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+            OSInterfaceLogInfo(this->tag, "Calling N_USData_confirm_cb of runner %s",
+                               runner->formatTag(tagStr, sizeof(tagStr)));
+            this->N_USData_confirm_cb(runner->getN_AI(), runner->getResult(), runner->getMtype());
+        }
+    }
+    else if (runner->getRunnerType() == N_USData_Runner::RunnerIndicationType)
+    {
+        if (this->N_USData_indication_cb != nullptr)
+        {
+            char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+            OSInterfaceLogInfo(this->tag, "Calling N_USData_indication_cb of runner %s",
+                               runner->formatTag(tagStr, sizeof(tagStr)));
+            const uint8_t* messageData = runner->getMessageData();
+            this->N_USData_indication_cb(runner->getN_AI(), messageData, runner->getMessageLength(),
+                                         runner->getResult(), runner->getMtype());
+        }
+    }
+    else
+    {
+        OSInterfaceLogError(this->tag, "Runner type is unknown");
+    }
+}
+
+void ISOTP::runCompletedRunnerCallbacks()
+{
+    std::list<N_USData_Runner*> runners;
+    this->completedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    runners.swap(this->completedRunners);
+    this->completedRunnersMutex->signal();
+
+    for (const auto runner : runners)
+    {
+        runRunnerCallbacks(runner);
+        this->runnerPool->release(runner);
+    }
+}
+
 template <std::ranges::input_range R> void ISOTP::runErrorCallbacks(R&& runners)
 {
     for (const auto runner : runners)
@@ -248,7 +564,18 @@ template <std::ranges::input_range R> void ISOTP::runErrorCallbacks(R&& runners)
             OSInterfaceLogError(this->tag, "Runner type is unknown");
         }
 
-        delete runner;
+        // Its frames may never be acknowledged (e.g. the bus went inactive), and the pool hands it out again.
+        canMessageAckQueue->removeFromQueue(*runner);
+        this->runnerPool->release(runner);
+    }
+}
+
+void ISOTP::takeSubmittedRunners()
+{
+    N_USData_Runner* runner;
+    while ((runner = this->submittedRunners.pop()) != nullptr)
+    {
+        this->notStartedRunners.push(runner);
     }
 }
 
@@ -257,29 +584,32 @@ void ISOTP::startRunners()
     // The second part of the runStep is to check if there are any runners in notStartedRunners, and move them
     // to activeRunners. ISO 15765-2 specifies that there should not be more than one message with the same N_AI
     // being transmitted or received at the same time. If that happens, leave the message in the
-    // notStartedRunners queue until the current message with this N_AI is processed.
+    // notStartedRunners queue until the current message with this N_AI is processed. Only the first runner of each
+    // idle N_AI is visited, the rest stay queued until the runner before them finishes.
     this->runnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
 
-    auto it = this->notStartedRunners.begin();
-    while (it != this->notStartedRunners.end())
+    takeSubmittedRunners();
+    N_USData_Runner* runner;
+    while ((runner = this->notStartedRunners.popReady()) != nullptr)
     {
-        if (!this->activeRunners.contains((*it)->getN_AI().N_AI))
+        if (this->activeRunners.emplace(runner->getN_AI().N_AI, runner).second)
         {
-            this->activeRunners.insert(std::make_pair((*it)->getN_AI().N_AI, *it));
-            it = this->notStartedRunners.erase(it); // Returns the next iterator if the current one is erased.
+            this->activeRunnersDispatchIndex.insert(runner);
+            scheduleRunner(runner);
         }
         else
         {
-            ++it; // Move to the next iterator.
+            char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+            OSInterfaceLogError(this->tag, "Runner %s already has an active runner with its N_AI",
+                                runner->formatTag(tagStr, sizeof(tagStr)));
+            runErrorCallbacks(std::views::single(runner));
         }
     }
 
-    this->notStartedRunnersMutex->signal();
     this->runnersMutex->signal();
 }
 
-void ISOTP::getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame) const
+void ISOTP::getFrameIfAvailable(const ConfigSnapshot& cfg, FrameStatus& frameStatus, CANFrame& frame) const
 {
     frameStatus = frameNotAvailable;
     if (this->canInterface.frameAvailable())
@@ -287,72 +617,138 @@ void ISOTP::getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame) const
         this->canInterface.readFrame(&frame);
         if (frame.extd == 1 && frame.data_length_code > 0 && frame.data_length_code <= CAN_FRAME_MAX_DLC)
         {
-            OSInterfaceLogVerbose(this->tag, "Received frame: %s", frameToString(frame));
+            char frameStr[MAX_FRAME_STR_SIZE];
+            OSInterfaceLogVerbose(this->tag, "Received frame: %s", frameToString(frame, frameStr, sizeof(frameStr)));
             if ((frame.identifier.N_TAtype == N_TATYPE_5_CAN_CLASSIC_29bit_Physical &&
-                 frame.identifier.N_TA == this->nSA) ||
+                 cfg.acceptedPhysicalN_SAs.test(frame.identifier.N_TA)) ||
                 (frame.identifier.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional &&
-                 this->acceptedFunctionalN_TAs.contains(frame.identifier.N_TA)))
+                 cfg.acceptedFunctionalN_TAs.test(frame.identifier.N_TA)))
             {
-                OSInterfaceLogDebug(this->tag, "Received frame for this ISOTP instance: %s", frameToString(frame));
+                OSInterfaceLogDebug(this->tag, "Received frame for this ISOTP instance: %s",
+                                    frameToString(frame, frameStr, sizeof(frameStr)));
                 frameStatus = frameAvailable;
             }
         }
     }
 }
 
-void ISOTP::runRunners(FrameStatus& frameStatus, CANFrame& frame)
+void ISOTP::scheduleRunner(N_USData_Runner* runner)
+{
+    this->activeRunnersScheduler.schedule(runner, runner->getNextRunTime());
+}
+
+void ISOTP::runRunners()
 {
-    for (auto runner : this->activeRunners | std::views::values)
+    // Only the runners whose deadline has passed are run. They are collected before running any of them, so a runner
+    // that is still due after running waits for the next runStep.
+    this->dueRunners.clear();
+    while (N_USData_Runner* runner = this->activeRunnersScheduler.popDue(this->lastRunTime))
     {
-        N_Result result = IN_PROGRESS; // If the runner does not run, do nothing in the switch below.
+        this->dueRunners.push_back(runner);
+    }
 
-        if (frameStatus == frameAvailable &&
-            runner->isThisFrameForMe(frame)) // If the runner has a message to process, do it immediately.
+    for (const auto runner : this->dueRunners)
+    {
+        char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+        OSInterfaceLogDebug(this->tag, "Runner %s is running without frame", runner->formatTag(tagStr, sizeof(tagStr)));
+        // Run the runner without the frame.
+        switch (runner->runStep(nullptr))
         {
-            OSInterfaceLogDebug(this->tag, "Runner %s is processing frame: %s", runner->getTAG(), frameToString(frame));
-            // Run the runner with the frame.
-            result      = runner->runStep(&frame);
-            frameStatus = frameProcessed;
+            case IN_PROGRESS_FF:
+                assert(false && "N_Result::IN_PROGRESS_FF should not happen, as the runner has already "
+                                "received at least one frame (if it is an indication runner)");
+            case IN_PROGRESS:
+                scheduleRunner(runner);
+                break;
+            default:
+                this->finishedRunners.push_back(runner);
+                break;
         }
-        else if (this->lastRunTime > runner->getNextRunTime()) // If the runner is ready to run, do it.
+    }
+}
+
+void ISOTP::runAckCallbacks()
+{
+    // An ACK changes the state of its runner (e.g. it starts the STmin of the next CF), so its deadline is updated.
+    this->ackedRunners.clear();
+    canMessageAckQueue->runAvailableAckCallbacks(this->ackedRunners);
+    for (const auto runner : this->ackedRunners)
+    {
+        if (this->activeRunnersScheduler.isScheduled(runner))
         {
-            OSInterfaceLogDebug(this->tag, "Runner %s is running without frame", runner->getTAG());
-            // Run the runner without the frame.
-            result = runner->runStep(nullptr);
+            scheduleRunner(runner);
         }
+    }
+}
+
+void ISOTP::dispatchFrame(const ConfigSnapshot& cfg, CANFrame& frame)
+{
+    FrameStatus frameStatus = frameAvailable;
 
-        // Check if the runner has finished
-        switch (result)
+    if (N_USData_Runner* runner = this->activeRunnersDispatchIndex.find(frame); runner != nullptr)
+    {
+        char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+        char frameStr[MAX_FRAME_STR_SIZE];
+        OSInterfaceLogDebug(this->tag, "Runner %s is processing frame: %s", runner->formatTag(tagStr, sizeof(tagStr)),
+                            frameToString(frame, frameStr, sizeof(frameStr)));
+        frameStatus = frameProcessed;
+        switch (runner->runStep(&frame))
         {
             case IN_PROGRESS_FF:
                 assert(false && "N_Result::IN_PROGRESS_FF should not happen, as the runner has already "
                                 "received at least one frame (if it is an indication runner)");
             case IN_PROGRESS:
+                scheduleRunner(runner);
                 break;
             default:
                 this->finishedRunners.push_back(runner);
                 break;
         }
     }
+
+    // If no runner processed the frame, start a new runner to handle it.
+    createRunnerForMessage(cfg, frameStatus, frame);
+
+    // Release the runners that finished with this frame before dispatching the next one, so a new message with the
+    // same N_AI in the same runStep gets a new runner instead of being matched against a finished one.
+    if (!this->finishedRunners.empty())
+    {
+        runFinishedRunnerCallbacks();
+    }
 }
 
-void ISOTP::createRunnerForMessage(const STmin stM, const uint8_t bs, const FrameStatus frameStatus, CANFrame& frame)
+void ISOTP::processAvailableFrames(const ConfigSnapshot& cfg)
 {
-    if (frameStatus == frameAvailable)
+    // Bound the work done in this runStep: either the configured cap or the frames that are already waiting.
+    const uint32_t framesToRead =
+        cfg.maxFramesPerStep == 0 ? this->canInterface.frameAvailable() : cfg.maxFramesPerStep;
+
+    for (uint32_t i = 0; i < framesToRead; i++)
     {
-        bool result;
+        FrameStatus frameStatus;
+        CANFrame    frame;
+        getFrameIfAvailable(cfg, frameStatus, frame);
 
-        N_USData_Runner* runner =
-            new N_USData_Indication_Runner(result, frame.identifier, this->availableMemoryForRunners, bs, stM,
-                                           this->osInterface, *this->canMessageAckQueue);
-        if (runner == nullptr)
+        if (frameStatus == frameNotAvailable && this->canInterface.frameAvailable() == 0)
+        {
+            break; // The bus has no more frames for us.
+        }
+        if (frameStatus == frameAvailable)
         {
-            OSInterfaceLogError(this->tag, "Failed to create a new runner");
+            dispatchFrame(cfg, frame);
         }
-        else if (!result)
+    }
+}
+
+void ISOTP::createRunnerForMessage(const ConfigSnapshot& cfg, const FrameStatus frameStatus, CANFrame& frame)
+{
+    if (frameStatus == frameAvailable)
+    {
+        N_USData_Runner* runner = this->runnerPool->acquireIndicationRunner(
+            frame.identifier, cfg.blockSize, cfg.stMin, cfg.rxBufferProvider, cfg.streamingSink);
+        if (runner == nullptr)
         {
-            OSInterfaceLogError(this->tag, "Failed to create a new runner");
-            delete runner;
+            OSInterfaceLogError(this->tag, "Failed to get a runner for the new message, discarding frame");
         }
         else
         {
@@ -363,12 +759,25 @@ void ISOTP::createRunnerForMessage(const STmin stM, const uint8_t bs, const Fram
                 case IN_PROGRESS_FF:
                     if (this->N_USData_FF_indication_cb != nullptr)
                     {
+                        char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
                         OSInterfaceLogInfo(this->tag, "Calling N_USData_FF_indication_cb of runner %s",
-                                           runner->getTAG());
+                                           runner->formatTag(tagStr, sizeof(tagStr)));
                         this->N_USData_FF_indication_cb(runner->getN_AI(), runner->getMessageLength(),
                                                         runner->getMtype());
                     }
-                    this->activeRunners.emplace(runner->getN_AI().N_AI, runner);
+                    if (this->activeRunners.emplace(runner->getN_AI().N_AI, runner).second)
+                    {
+                        this->activeRunnersDispatchIndex.insert(runner);
+                        this->notStartedRunners.acquire(runner->getN_AI());
+                        scheduleRunner(runner);
+                    }
+                    else
+                    {
+                        char tagStr[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+                        OSInterfaceLogError(this->tag, "Runner %s already has an active runner with its N_AI",
+                                            runner->formatTag(tagStr, sizeof(tagStr)));
+                        runErrorCallbacks(std::views::single(runner));
+                    }
                     break;
                 default: // Single frame or error
                     this->finishedRunners.push_front(runner);
@@ -377,117 +786,327 @@ void ISOTP::createRunnerForMessage(const STmin stM, const uint8_t bs, const Fram
         }
     }
 }
-void ISOTP::runStepCanActive()
+uint32_t ISOTP::runStepCanActive()
 {
-    // Get the configuration used in this runStep.
-    this->configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    std::unordered_set<typeof(N_AI::N_TA)> acceptedFunctionalN_TAs = this->acceptedFunctionalN_TAs;
-    STmin                                  stMin                   = this->stMin;
-    uint8_t                                blockSize               = this->blockSize;
-    this->configMutex->signal();
-
     // The second part of the runStep is to check if there are any runners in notStartedRunners, and move them
     // to activeRunners. ISO 15765-2 specifies that there should not be more than one message with the same N_AI
     // being transmitted or received at the same time. If that happens, leave the message in the
     // notStartedRunners queue until the current message with this N_AI is processed.
     startRunners();
 
-    // The third part of the runStep is to check if a message is available, read it and check if this ISOTP
-    // object is interested in it.
-    FrameStatus frameStatus;
-    CANFrame    frame;
-    getFrameIfAvailable(frameStatus, frame);
+    if (!this->runnersMutex->wait(ISOTP_MaxTimeToWaitForRunnersSync_MS))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire the runners mutex, skipping this runStep");
+        return 0;
+    }
 
-    this->runnersMutex->wait(ISOTP_MaxTimeToWaitForRunnersSync_MS);
+    // Get the configuration used in this runStep. It is read in place: a setter publishes a new snapshot instead of
+    // modifying this one.
+    const ConfigSnapshot* cfg = acquireConfig();
 
-    // The fourth part of the runStep is to walk through all activeRunners checking if they need to run. If
-    // they do, run them passing them the frame if it applies.
-    runRunners(frameStatus, frame);
+    // The third part of the runStep is to read the available frames (up to maxFramesPerStep), check if this ISOTP
+    // object is interested in them, and dispatch each one to the runner awaiting it, or start a new runner to handle
+    // it if no one is.
+    processAvailableFrames(*cfg);
+    const bool pollAcks = cfg->pollAcksInRunStep;
+    releaseConfig();
 
-    // The fifth part of the runStep is to check if a runner processed a message, and if no one did, start a
-    // new runner to handle it.
-    createRunnerForMessage(stMin, blockSize, frameStatus, frame);
+    // The fourth part of the runStep is to run the activeRunners whose next run time has passed without a frame
+    // (timeouts, STmin, pending frames to send...).
+    runRunners();
 
-    // The sixth part of the runStep is to run any ack callback.
-    canMessageAckQueue->runAvailableAckCallbacks();
+    // The fifth part of the runStep is to run any ack callback, storing first the ACKs the CANInterface has if they
+    // are polled here.
+    if (pollAcks && !this->workersRunning) // The TX worker is the only one that polls them while it runs.
+    {
+        this->canMessageAckQueue->runStep();
+    }
+    runAckCallbacks();
 
-    // The seventh part of the runStep is to run the callbacks for the finished runners and remove them from
+    // The sixth part of the runStep is to run the callbacks for the finished runners and remove them from
     // activeRunners and finishedRunners.
     runFinishedRunnerCallbacks();
 
+    // The last part of the runStep is to find out how long the caller can wait until the next one.
+    const uint32_t timeUntilNextRun = getTimeUntilNextRun();
+
     this->runnersMutex->signal();
+
+    return timeUntilNextRun;
 }
 
-void ISOTP::runStepCanInactive()
+uint32_t ISOTP::getTimeUntilNextRun()
 {
-    this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    if (this->canInterface.frameAvailable() > 0)
+    {
+        return 0; // Frames left unread because of maxFramesPerStep.
+    }
+
+    uint32_t nextRunTime;
+    if (!this->activeRunnersScheduler.getNextDeadline(nextRunTime))
+    {
+        return ISOTP_MaxWaitForWork_MS; // Nothing to do until a frame arrives or a message is queued.
+    }
 
-    runErrorCallbacks(this->notStartedRunners);
-    this->notStartedRunners.clear();
+    // A runner runs once the time is past its next run time.
+    const uint32_t now = this->osInterface.osMillis();
+    if (now > nextRunTime)
+    {
+        return 0;
+    }
+    return MIN(nextRunTime - now + 1, ISOTP_MaxWaitForWork_MS);
+}
 
-    this->notStartedRunnersMutex->signal();
+void ISOTP::runStepCanInactive()
+{
     this->runnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
 
+    takeSubmittedRunners();
+    std::list<N_USData_Runner*> pendingRunners;
+    this->notStartedRunners.takeAll(pendingRunners);
+    runErrorCallbacks(pendingRunners);
+
     runErrorCallbacks(this->activeRunners | std::views::values);
     this->activeRunners.clear();
+    this->activeRunnersDispatchIndex.clear();
+    this->activeRunnersScheduler.clear();
 
     runFinishedRunnerCallbacks();
 
     this->runnersMutex->signal();
 }
 
-void ISOTP::runStep()
+uint32_t ISOTP::runStep()
 {
-    // The first part of the runStep is to check if the CAN is active, and more than ISOTP_RunPeriod_MS has passed
+    // The first part of the runStep is to check if the CAN is active, and at least ISOTP_RunPeriod_MS has passed
     // since the last run.
-    if (const uint32_t millis = this->osInterface.osMillis(); millis - this->lastRunTime > ISOTP_RunPeriod_MS)
+    const uint32_t millis = this->osInterface.osMillis();
+    if (millis - this->lastRunTime < ISOTP_RunPeriod_MS)
     {
-        this->lastRunTime = millis;
+        return ISOTP_RunPeriod_MS - (millis - this->lastRunTime);
+    }
+    this->lastRunTime = millis;
+
+    if (this->canInterface.active())
+    {
+        return this->runStepCanActive();
+    }
 
-        if (this->canInterface.active())
+    this->runStepCanInactive(); // TODO: avoid calling this function always, do it only once until can is active again.
+    return ISOTP_MaxWaitForWork_MS;
+}
+
+bool ISOTP::waitForWork(const uint32_t timeoutMs)
+{
+    return this->rxWakeupSignal.wait(MIN(timeoutMs, ISOTP_MaxWaitForWork_MS));
+}
+
+bool ISOTP::setThreadInterface(ThreadInterface& threadInterface)
+{
+    if (!this->rxWakeupSignal.setSemaphore(threadInterface) || !this->txWakeupSignal.setSemaphore(threadInterface) ||
+        !this->callbackWakeupSignal.setSemaphore(threadInterface))
+    {
+        OSInterfaceLogError(this->tag, "Failed to create the wakeup semaphores");
+        return false;
+    }
+    return true;
+}
+
+void ISOTP::runUntil(const uint32_t deadline)
+{
+    // The differences are signed so the deadline is honoured across the wrap of osMillis().
+    while (static_cast<int32_t>(deadline - this->osInterface.osMillis()) > 0)
+    {
+        // Store every ACK the CANInterface has, their callbacks are run by the runStep.
+        this->canMessageAckQueue->runStep();
+
+        const uint32_t timeUntilNextRun  = runStep();
+        const int32_t  timeUntilDeadline = static_cast<int32_t>(deadline - this->osInterface.osMillis());
+        if (timeUntilNextRun > 0 && timeUntilDeadline > 0)
         {
-            this->runStepCanActive();
+            waitForWork(MIN(timeUntilNextRun, static_cast<uint32_t>(timeUntilDeadline)));
         }
-        else
+    }
+}
+
+void ISOTP::wakeup()
+{
+    notifyRxWorker();
+    notifyTxWorker();
+}
+
+void ISOTP::notifyRxWorker()
+{
+    this->rxWakeupSignal.notify();
+}
+
+void ISOTP::notifyTxWorker()
+{
+    this->txWakeupSignal.notify();
+}
+
+void ISOTP::notifyCallbackWorker()
+{
+    this->callbackWakeupSignal.notify();
+}
+
+void ISOTP::wakeupCallback(void* context)
+{
+    static_cast<ISOTP*>(context)->wakeup();
+}
+
+bool ISOTP::start(ThreadInterface& threadInterface, const ISOTP_WorkersConfig config)
+{
+    if (this->workersRunning.exchange(true))
+    {
+        OSInterfaceLogWarning(this->tag, "The workers are already running");
+        return false;
+    }
+
+    if (!setThreadInterface(threadInterface))
+    {
+        this->workersRunning = false;
+        return false;
+    }
+
+    this->rxWorker = threadInterface.createThread(rxWorkerEntry, this, config.rxPriority, "ISOTP-RX");
+    this->txWorker = threadInterface.createThread(txWorkerEntry, this, config.txPriority, "ISOTP-TX");
+    this->callbackWorker =
+        threadInterface.createThread(callbackWorkerEntry, this, config.callbackPriority, "ISOTP-Callbacks");
+    if (this->rxWorker == nullptr || this->txWorker == nullptr || this->callbackWorker == nullptr)
+    {
+        OSInterfaceLogError(this->tag, "Failed to create the worker threads");
+        this->workersRunning = false;
+        wakeup();
+        notifyCallbackWorker();
+        joinWorker(this->rxWorker);
+        joinWorker(this->txWorker);
+        joinWorker(this->callbackWorker);
+        return false;
+    }
+
+    OSInterfaceLogInfo(this->tag, "Workers started");
+    return true;
+}
+
+void ISOTP::stop()
+{
+    if (!this->workersRunning.exchange(false))
+    {
+        return;
+    }
+
+    wakeup();
+    notifyCallbackWorker();
+    joinWorker(this->rxWorker);
+    joinWorker(this->txWorker);
+    joinWorker(this->callbackWorker);
+
+    // Deliver the callbacks the callback worker did not get to.
+    runCompletedRunnerCallbacks();
+
+    OSInterfaceLogInfo(this->tag, "Workers stopped");
+}
+
+bool ISOTP::isStarted() const
+{
+    return this->workersRunning;
+}
+
+void ISOTP::joinWorker(ThreadInterface_Thread*& worker)
+{
+    if (worker != nullptr)
+    {
+        worker->join();
+        delete worker;
+        worker = nullptr;
+    }
+}
+
+void ISOTP::rxWorkerEntry(void* context)
+{
+    static_cast<ISOTP*>(context)->rxWorkerLoop();
+}
+
+void ISOTP::txWorkerEntry(void* context)
+{
+    static_cast<ISOTP*>(context)->txWorkerLoop();
+}
+
+void ISOTP::callbackWorkerEntry(void* context)
+{
+    static_cast<ISOTP*>(context)->callbackWorkerLoop();
+}
+
+void ISOTP::rxWorkerLoop()
+{
+    while (this->workersRunning)
+    {
+        const uint32_t timeoutMs = runStep();
+        // The ACKs are polled by the TX worker only, which wakes this one up when it stores any.
+        if (this->canMessageAckQueue->waitingForAcks())
         {
-            this->runStepCanInactive(); // TODO: avoid calling this function always, do it only once until can is active
-                                        // again.
+            notifyTxWorker();
         }
+        waitForWork(timeoutMs);
     }
 }
-void ISOTP::canMessageACKQueueRunStep() const
+
+void ISOTP::txWorkerLoop()
 {
-    static uint32_t ACKlastRunTime = 0;
-    if (this->osInterface.osMillis() - ACKlastRunTime > ISOTP_RunPeriod_ACKQueue_MS)
+    while (this->workersRunning)
     {
-        ACKlastRunTime = this->osInterface.osMillis();
-        if (canMessageAckQueue != nullptr)
+        // Store every ACK the CANInterface has and let the RX worker run their callbacks.
+        if (this->canMessageAckQueue->runStep())
         {
-            canMessageAckQueue->runStep();
+            notifyRxWorker();
         }
+
+        // Notified by the CANInterface and by the RX worker when it writes frames.
+        this->txWakeupSignal.wait(this->canMessageAckQueue->waitingForAcks() ? ISOTP_AckPollPeriod_MS
+                                                                              : ISOTP_MaxWaitForWork_MS);
     }
 }
 
-bool ISOTP::updateRunners()
+void ISOTP::callbackWorkerLoop()
 {
-    notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    while (this->workersRunning)
+    {
+        runCompletedRunnerCallbacks();
 
-    for (const auto runner : notStartedRunners)
+        // Notified by the RX worker when it completes runners.
+        this->callbackWakeupSignal.wait(ISOTP_MaxWaitForWork_MS);
+    }
+}
+
+void ISOTP::canMessageACKQueueRunStep()
+{
+    if (this->osInterface.osMillis() - this->ackLastRunTime >= ISOTP_RunPeriod_ACKQueue_MS)
     {
-        if (!updateRunner(runner))
+        this->ackLastRunTime = this->osInterface.osMillis();
+        if (canMessageAckQueue != nullptr)
         {
-            return false;
+            canMessageAckQueue->runStep();
         }
     }
+}
 
-    notStartedRunnersMutex->signal();
+bool ISOTP::updateRunners()
+{
+    const ConfigSnapshot* cfg = acquireConfig();
+    const uint8_t         bs  = cfg->blockSize;
+    const STmin           stM = cfg->stMin;
+    releaseConfig();
 
+    // Only the active runners need it: runners that are not started yet are request runners, which do not use the
+    // STmin and block size of this ISOTP.
     runnersMutex->wait(ISOTP_MaxTimeToWaitForRunnersSync_MS);
 
     for (const auto runner : activeRunners | std::views::values)
     {
-        if (!updateRunner(runner))
+        if (!updateRunner(runner, bs, stM))
         {
+            runnersMutex->signal();
             return false;
         }
     }
@@ -495,17 +1114,17 @@ bool ISOTP::updateRunners()
     return true;
 }
 
-bool ISOTP::updateRunner(N_USData_Runner* runner) const
+bool ISOTP::updateRunner(N_USData_Runner* runner, const uint8_t bs, const STmin stM)
 {
     if (runner->getRunnerType() == N_USData_Runner::RunnerIndicationType)
     {
         const auto indicationRunner = dynamic_cast<N_USData_Indication_Runner*>(runner);
 
-        if (!indicationRunner->setBlockSize(blockSize))
+        if (!indicationRunner->setBlockSize(bs))
         {
             return false;
         }
-        return indicationRunner->setSTmin(stMin);
+        return indicationRunner->setSTmin(stM);
     }
     return true;
 }
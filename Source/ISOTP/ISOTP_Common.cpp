@@ -38,7 +38,12 @@ const char* N_ResultToString(const N_Result result)
 const char* STminToString(const STmin& stMin)
 {
     static char buffer[MAX_STMIN_STR_SIZE];
-    snprintf(buffer, MAX_STMIN_STR_SIZE, "%u%s", stMin.value, stMin.unit == ms ? " ms" : "00 us");
+    return STminToString(stMin, buffer, sizeof(buffer));
+}
+
+const char* STminToString(const STmin& stMin, char* buffer, const size_t bufferSize)
+{
+    snprintf(buffer, bufferSize, "%u%s", stMin.value, stMin.unit == ms ? " ms" : "00 us");
     return buffer;
 }
 
@@ -0,0 +1,272 @@
+#include "MemoryArena.h"
+
+#include <bit>
+#include "ISOTP_Common.h"
+
+MemoryArena::MemoryArena(bool& result, const uint32_t size, OSInterface& osInterface)
+{
+    result = false;
+
+    this->osInterface       = &osInterface;
+    this->mutex             = this->osInterface->osCreateMutex();
+    this->capacity          = size & ~(Alignment - 1);
+    this->memory            = nullptr;
+    this->nonEmptyFreeLists = 0;
+    this->usedBytes         = 0;
+    this->highWaterMark     = 0;
+    this->allocations       = 0;
+    this->failedAllocations = 0;
+
+    if (this->mutex == nullptr)
+    {
+        OSInterfaceLogError(TAG, "Failed to create the mutex");
+        this->capacity = 0;
+        return;
+    }
+
+    if (this->capacity < MinBlockSize)
+    {
+        // Too small to hold a single block, every allocation fails.
+        this->capacity = 0;
+        result         = true;
+        return;
+    }
+
+    this->memory = static_cast<uint8_t*>(this->osInterface->osMalloc(this->capacity));
+    if (this->memory == nullptr)
+    {
+        this->capacity = 0;
+        return;
+    }
+
+    // The whole arena starts as a single free block.
+    const auto block    = reinterpret_cast<BlockHeader*>(this->memory);
+    block->size         = this->capacity;
+    block->prevPhysSize = 0;
+    insertFreeBlock(block);
+
+    result = true;
+}
+
+MemoryArena::~MemoryArena()
+{
+    if (this->memory != nullptr)
+    {
+        this->osInterface->osFree(this->memory);
+    }
+    delete this->mutex;
+}
+
+uint32_t MemoryArena::listIndex(const uint32_t blockSize)
+{
+    return std::bit_width(blockSize) - 1;
+}
+
+MemoryArena::BlockHeader* MemoryArena::nextPhysBlock(const BlockHeader* block) const
+{
+    const uint8_t* next = reinterpret_cast<const uint8_t*>(block) + block->size;
+    if (next >= this->memory + this->capacity)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<BlockHeader*>(const_cast<uint8_t*>(next));
+}
+
+void MemoryArena::insertFreeBlock(BlockHeader* block)
+{
+    const uint32_t index = listIndex(block->size);
+
+    block->isFree   = true;
+    block->prevFree = nullptr;
+    block->nextFree = this->freeLists[index];
+    if (block->nextFree != nullptr)
+    {
+        block->nextFree->prevFree = block;
+    }
+    this->freeLists[index] = block;
+    this->nonEmptyFreeLists |= 1u << index;
+}
+
+void MemoryArena::removeFreeBlock(BlockHeader* block)
+{
+    const uint32_t index = listIndex(block->size);
+
+    if (block->prevFree != nullptr)
+    {
+        block->prevFree->nextFree = block->nextFree;
+    }
+    else
+    {
+        this->freeLists[index] = block->nextFree;
+        if (this->freeLists[index] == nullptr)
+        {
+            this->nonEmptyFreeLists &= ~(1u << index);
+        }
+    }
+    if (block->nextFree != nullptr)
+    {
+        block->nextFree->prevFree = block->prevFree;
+    }
+    block->isFree = false;
+}
+
+MemoryArena::BlockHeader* MemoryArena::findFreeBlock(const uint32_t blockSize)
+{
+    const uint32_t index = listIndex(blockSize);
+
+    // Any block of the lists of the next powers of two fits, so the first one of the smallest non-empty list is taken.
+    const uint32_t fittingIndex = std::has_single_bit(blockSize) ? index : index + 1;
+    if (fittingIndex < FreeLists)
+    {
+        const uint32_t fittingLists = this->nonEmptyFreeLists & (~0u << fittingIndex);
+        if (fittingLists != 0)
+        {
+            return this->freeLists[std::countr_zero(fittingLists)];
+        }
+    }
+
+    // Otherwise, a block of the same power of two may still be large enough.
+    for (BlockHeader* block = this->freeLists[index]; block != nullptr; block = block->nextFree)
+    {
+        if (block->size >= blockSize)
+        {
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+void* MemoryArena::allocate(const size_t size)
+{
+    if (!this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return nullptr;
+    }
+
+    if (size > this->capacity)
+    {
+        this->failedAllocations++;
+        this->mutex->signal();
+        return nullptr;
+    }
+    const uint64_t requiredSize = HeaderSize + (size == 0 ? 1 : size);
+    const auto     blockSize    = static_cast<uint32_t>((requiredSize + Alignment - 1) & ~(Alignment - 1));
+
+    BlockHeader* block = blockSize <= this->capacity ? findFreeBlock(blockSize) : nullptr;
+    if (block == nullptr)
+    {
+        this->failedAllocations++;
+        this->mutex->signal();
+        return nullptr;
+    }
+    removeFreeBlock(block);
+
+    // Give back the end of the block if it can hold another one.
+    if (block->size - blockSize >= MinBlockSize)
+    {
+        const auto remainder    = reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(block) + blockSize);
+        remainder->size         = block->size - blockSize;
+        remainder->prevPhysSize = blockSize;
+        block->size             = blockSize;
+
+        BlockHeader* next = nextPhysBlock(remainder);
+        if (next != nullptr)
+        {
+            next->prevPhysSize = remainder->size;
+        }
+        insertFreeBlock(remainder);
+    }
+
+    this->usedBytes += block->size;
+    this->allocations++;
+    if (this->usedBytes > this->highWaterMark)
+    {
+        this->highWaterMark = this->usedBytes;
+    }
+    this->mutex->signal();
+
+    return reinterpret_cast<uint8_t*>(block) + HeaderSize;
+}
+
+void MemoryArena::free(void* block)
+{
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    if (!this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(TAG, "Failed to acquire mutex, block %p is leaked", block);
+        return;
+    }
+
+    auto header = reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(block) - HeaderSize);
+    this->usedBytes -= header->size;
+    this->allocations--;
+
+    // Merge it with the free blocks around it, so the arena does not end up split in blocks too small to be used.
+    BlockHeader* next = nextPhysBlock(header);
+    if (next != nullptr && next->isFree)
+    {
+        removeFreeBlock(next);
+        header->size += next->size;
+    }
+    if (header->prevPhysSize != 0)
+    {
+        const auto prev = reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(header) - header->prevPhysSize);
+        if (prev->isFree)
+        {
+            removeFreeBlock(prev);
+            prev->size += header->size;
+            header = prev;
+        }
+    }
+
+    next = nextPhysBlock(header);
+    if (next != nullptr)
+    {
+        next->prevPhysSize = header->size;
+    }
+    insertFreeBlock(header);
+    this->mutex->signal();
+}
+
+MemoryArena::Stats MemoryArena::getStats()
+{
+    Stats stats{};
+    if (!this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return stats;
+    }
+
+    stats.capacity          = this->capacity;
+    stats.usedBytes         = this->usedBytes;
+    stats.highWaterMark     = this->highWaterMark;
+    stats.allocations       = this->allocations;
+    stats.failedAllocations = this->failedAllocations;
+
+    uint32_t largestBlock = 0;
+    for (const BlockHeader* list : this->freeLists)
+    {
+        for (const BlockHeader* block = list; block != nullptr; block = block->nextFree)
+        {
+            stats.freeBytes += block->size;
+            stats.freeBlocks++;
+            if (block->size > largestBlock)
+            {
+                largestBlock = block->size;
+            }
+        }
+    }
+    this->mutex->signal();
+
+    if (largestBlock != 0)
+    {
+        stats.largestFreeBlock = largestBlock - HeaderSize;
+        stats.fragmentation =
+            static_cast<uint8_t>(100 - static_cast<uint64_t>(largestBlock) * 100 / stats.freeBytes);
+    }
+
+    return stats;
+}
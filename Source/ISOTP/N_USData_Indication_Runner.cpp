@@ -2,88 +2,198 @@
 #include <cassert>
 #include <cstring>
 
-N_USData_Indication_Runner::N_USData_Indication_Runner(bool& result, const N_AI nAi,
-                                                       Atomic_int64_t& availableMemoryForRunners,
-                                                       const uint8_t blockSize, const STmin stMin,
-                                                       OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue)
+N_USData_Indication_Runner::N_USData_Indication_Runner(bool& result, Atomic_int64_t& availableMemoryForRunners,
+                                                       OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue,
+                                                       MemoryArena* messageArena) :
+    timerN_Ar(osInterface), timerN_Br(osInterface), timerN_Cr(osInterface)
 {
     result = false;
 
     this->availableMemoryForRunners = &availableMemoryForRunners;
     this->osInterface               = &osInterface;
+    this->messageArena              = messageArena;
+    this->CanMessageACKQueue        = &canMessageACKQueue;
+    this->nAi                       = {};
+    this->mType                     = Mtype_Unknown;
+    this->messageData               = nullptr;
+    this->messageLength             = 0;
+    this->internalStatus            = ERROR;
+    this->result                    = NOT_STARTED;
 
-    if (this->availableMemoryForRunners->subIfResIsGreaterThanZero(N_USDATA_INDICATION_RUNNER_TAG_SIZE))
-    {
-        this->tag = static_cast<char*>(this->osInterface->osMalloc(N_USDATA_INDICATION_RUNNER_TAG_SIZE));
-        if (this->tag == nullptr)
-        {
-            return;
-        }
-        snprintf(this->tag, N_USDATA_INDICATION_RUNNER_TAG_SIZE, "%s%s", N_USDATA_INDICATION_RUNNER_STATIC_TAG,
-                 nAiToString(nAi));
-    }
-    else
+    // The mutex is kept while the runner is recycled, only the message changes with reset().
+    this->mutex = osInterface.osCreateMutex();
+    if (this->mutex == nullptr)
     {
+        OSInterfaceLogError(getTAG(), AT "Failed to create mutex");
         return;
     }
 
-    OSInterfaceLogDebug(tag, "Creating N_USData_Indication_Runner with tag %s", this->tag);
+    result = true;
+}
+
+N_USData_Indication_Runner::N_USData_Indication_Runner(bool& result, const N_AI nAi,
+                                                       Atomic_int64_t& availableMemoryForRunners,
+                                                       const uint8_t blockSize, const STmin stMin,
+                                                       OSInterface& osInterface,
+                                                       CANMessageACKQueue& canMessageACKQueue) :
+    N_USData_Indication_Runner(result, availableMemoryForRunners, osInterface, canMessageACKQueue)
+{
+    if (result)
+    {
+        result = reset(nAi, blockSize, stMin);
+    }
+}
 
-    this->mType              = Mtype_Unknown;
-    this->CanMessageACKQueue = &canMessageACKQueue;
-    this->messageData        = nullptr;
-    this->messageLength      = 0;
-    this->result             = NOT_STARTED;
-    this->lastRunTime        = 0;
+bool N_USData_Indication_Runner::reset(const N_AI nAi, const uint8_t blockSize, const STmin stMin,
+                                       const N_USData_ReceiveBufferProvider rxBufferProvider,
+                                       const N_USData_StreamingSink         streamingSink)
+{
+    release();
+
+    this->nAi              = nAi;
+    this->rxBufferProvider = rxBufferProvider;
+    this->streamingSink    = streamingSink;
+    this->streaming        = false;
+    this->chunkSize        = 0;
+    this->chunkFill        = 0;
+    OSInterfaceLogDebug(getTAG(), "Starting N_USData_Indication_Runner");
+
+    this->mType          = Mtype_Unknown;
+    this->messageData    = nullptr;
+    this->messageLength  = 0;
+    this->result         = NOT_STARTED;
+    this->lastRunTime    = 0;
     this->sequenceNumber = 1; // The first sequence number that is being sent is 1. (0 is reserved for the first frame)
 
-    this->mutex = osInterface.osCreateMutex();
-    if (this->mutex == nullptr)
+    this->internalStatus        = NOT_RUNNING;
+    this->stMin                 = stMin;
+    this->blockSize             = blockSize;
+    this->effectiveBlockSize    = blockSize;
+    this->effectiveStMin        = stMin;
+    this->messageOffset         = 0;
+    this->cfReceivedInThisBlock = 0;
+    this->frameToHoldValid      = false;
+
+    this->timerN_Ar.clearTimer();
+    this->timerN_Br.clearTimer();
+    this->timerN_Cr.clearTimer();
+
+    return true;
+}
+
+void N_USData_Indication_Runner::release()
+{
+    if (this->messageData != nullptr)
     {
-        OSInterfaceLogError(tag, AT "Failed to create mutex");
-        return;
+        if (this->messageDataProvided)
+        {
+            this->rxBufferProvider.releaseBuffer(this->messageData, static_cast<uint32_t>(this->messageLength),
+                                                 this->rxBufferProvider.context);
+            this->messageDataProvided = false;
+        }
+        else
+        {
+            freeMessageData();
+            availableMemoryForRunners->add(messageDataSize * static_cast<int64_t>(sizeof(uint8_t)));
+        }
+        this->messageData = nullptr;
     }
+}
 
-    this->internalStatus            = NOT_RUNNING;
-    this->nAi                       = nAi;
-    this->stMin                     = stMin;
-    this->blockSize                 = blockSize;
-    this->effectiveBlockSize        = blockSize;
-    this->effectiveStMin            = stMin;
-    this->availableMemoryForRunners = &availableMemoryForRunners;
-    this->osInterface               = &osInterface;
-    this->messageData               = nullptr;
-    this->messageOffset             = 0;
-    this->cfReceivedInThisBlock     = 0;
+bool N_USData_Indication_Runner::acquireMessageData(const uint32_t size)
+{
+    this->messageDataSize = size;
 
-    this->timerN_Ar = new Timer_N(osInterface);
-    this->timerN_Br = new Timer_N(osInterface);
-    this->timerN_Cr = new Timer_N(osInterface);
+    // A streamed message only needs a buffer for one chunk, the application gets the data in onChunk.
+    if (this->rxBufferProvider.getBuffer != nullptr && !this->streaming)
+    {
+        this->messageData = this->rxBufferProvider.getBuffer(this->nAi, static_cast<uint32_t>(this->messageLength),
+                                                             this->rxBufferProvider.context);
+        if (this->messageData != nullptr)
+        {
+            // The buffer belongs to the application, so it is not charged to availableMemoryForRunners.
+            this->messageDataProvided = true;
+            return true;
+        }
+        OSInterfaceLogDebug(getTAG(), "No buffer provided for message length %ld, allocating it", messageLength);
+    }
 
-    result = true;
+    if (!this->availableMemoryForRunners->subIfResIsGreaterThanZero(size * static_cast<int64_t>(sizeof(uint8_t))))
+    {
+        return false;
+    }
+    this->messageData = allocateMessageData(size);
+    if (this->messageData == nullptr)
+    {
+        availableMemoryForRunners->add(size * static_cast<int64_t>(sizeof(uint8_t)));
+        return false;
+    }
+    return true;
 }
 
-// Be careful with the destructor. All the pointers used in the destructor need to be initialized to nullptr. Otherwise,
-// the destructor may attempt a free on an invalid pointer.
-N_USData_Indication_Runner::~N_USData_Indication_Runner()
+bool N_USData_Indication_Runner::storeMessageData(const uint8_t* data, uint32_t length)
 {
-    OSInterfaceLogDebug(tag, "Deleting runner");
+    if (!this->streaming)
+    {
+        memcpy(&this->messageData[this->messageOffset], data, length);
+        this->messageOffset += length;
+        return true;
+    }
 
-    if (this->messageData != nullptr)
+    while (length > 0)
     {
-        osInterface->osFree(this->messageData);
-        availableMemoryForRunners->add(messageLength * static_cast<int64_t>(sizeof(uint8_t)));
+        const uint32_t size = MIN(length, this->chunkSize - this->chunkFill);
+        memcpy(&this->messageData[this->chunkFill], data, size);
+        data += size;
+        length -= size;
+        this->chunkFill += size;
+        this->messageOffset += size;
+
+        if (this->chunkFill == this->chunkSize || this->messageOffset == this->messageLength)
+        {
+            const uint32_t chunkOffset = this->messageOffset - this->chunkFill;
+            OSInterfaceLogVerbose(getTAG(), "Giving chunk with %u bytes at offset %u to the streaming sink",
+                                  this->chunkFill, chunkOffset);
+            if (!this->streamingSink.onChunk(this->nAi, chunkOffset, this->messageData, this->chunkFill,
+                                             this->streamingSink.context))
+            {
+                return false;
+            }
+            this->chunkFill = 0;
+        }
     }
+    return true;
+}
 
-    if (this->tag != nullptr)
+uint8_t* N_USData_Indication_Runner::allocateMessageData(const uint32_t length) const
+{
+    if (this->messageArena != nullptr)
+    {
+        return static_cast<uint8_t*>(this->messageArena->allocate(length * sizeof(uint8_t)));
+    }
+    return static_cast<uint8_t*>(this->osInterface->osMalloc(length * sizeof(uint8_t)));
+}
+
+void N_USData_Indication_Runner::freeMessageData() const
+{
+    if (this->messageArena != nullptr)
+    {
+        this->messageArena->free(this->messageData);
+    }
+    else
     {
-        osInterface->osFree(this->tag);
-        availableMemoryForRunners->add(N_USDATA_INDICATION_RUNNER_TAG_SIZE);
+        this->osInterface->osFree(this->messageData);
     }
+}
+
+// Be careful with the destructor. All the pointers used in the destructor need to be initialized to nullptr. Otherwise,
+// the destructor may attempt a free on an invalid pointer.
+N_USData_Indication_Runner::~N_USData_Indication_Runner()
+{
+    OSInterfaceLogDebug(getTAG(), "Deleting runner");
+
+    release();
 
-    delete timerN_Ar;
-    delete timerN_Br;
-    delete timerN_Cr;
     delete mutex;
 }
 
@@ -110,9 +220,11 @@ N_Result N_USData_Indication_Runner::runStep(CANFrame* receivedFrame)
         returnErrorWithLog(N_ERROR, "Failed to acquire mutex");
     }
 
-    OSInterfaceLogVerbose(tag, "Running step with internalStatus = %s (%d) and frame %s",
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogVerbose(getTAG(), "Running step with internalStatus = %s (%d) and frame %s",
                           internalStatusToString(internalStatus), internalStatus,
-                          receivedFrame != nullptr ? frameToString(*receivedFrame) : "null");
+                          receivedFrame != nullptr ? frameToString(*receivedFrame, frameStr, sizeof(frameStr))
+                                                   : "null");
 
     N_Result res = checkTimeouts();
 
@@ -147,7 +259,7 @@ N_Result N_USData_Indication_Runner::runStep_internal(const CANFrame* receivedFr
             res = runStep_holdFrame(receivedFrame);
             break;
         case MESSAGE_RECEIVED:
-            OSInterfaceLogDebug(tag, "Message received successfully");
+            OSInterfaceLogDebug(getTAG(), "Message received successfully");
             result = N_OK; // If the message is successfully received, return N_OK to allow ISOTP to call the callback.
             res    = result;
             break;
@@ -155,7 +267,7 @@ N_Result N_USData_Indication_Runner::runStep_internal(const CANFrame* receivedFr
             res = result;
             break;
         default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
+            OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
                                 internalStatus);
             result = N_ERROR;
             updateInternalStatus(ERROR);
@@ -175,8 +287,11 @@ N_Result N_USData_Indication_Runner::runStep_holdFrame(const CANFrame* receivedF
         returnErrorWithLog(N_ERROR, "Received frame is null");
     }
 
-    OSInterfaceLogWarning(tag, "Received frame while waiting for ACK in %s (%d). Storing it for later use Frame: %s",
-                          internalStatusToString(internalStatus), internalStatus, frameToString(*receivedFrame));
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogWarning(getTAG(),
+                          "Received frame while waiting for ACK in %s (%d). Storing it for later use Frame: %s",
+                          internalStatusToString(internalStatus), internalStatus,
+                          frameToString(*receivedFrame, frameStr, sizeof(frameStr)));
 
     if (frameToHoldValid)
     {
@@ -212,14 +327,11 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
         {
             messageLength = receivedFrame->data[0] & 0b00001111;
 
-            if (messageLength <= MAX_SF_MESSAGE_LENGTH &&
-                this->availableMemoryForRunners->subIfResIsGreaterThanZero(this->messageLength *
-                                                                           static_cast<int64_t>(sizeof(uint8_t))))
+            if (messageLength <= MAX_SF_MESSAGE_LENGTH && acquireMessageData(messageLength))
             {
-                messageData = static_cast<uint8_t*>(osInterface->osMalloc(this->messageLength * sizeof(uint8_t)));
                 memcpy(messageData, &receivedFrame->data[1], messageLength);
 
-                OSInterfaceLogInfo(tag, "Received message with length %ld (SF)", messageLength);
+                OSInterfaceLogInfo(getTAG(), "Received message with length %ld (SF)", messageLength);
                 result = N_OK;
                 return result;
             }
@@ -231,7 +343,7 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
         }
         case FF_CODE:
         {
-            timerN_Br->startTimer();
+            timerN_Br.startTimer();
             if (nAi.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional)
             {
                 returnErrorWithLog(N_UNEXP_PDU, "Received FF frame with N_TAtype %s", N_TAtypeToString(nAi.N_TAtype));
@@ -254,31 +366,31 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
                 returnErrorWithLog(N_ERROR, "FF frame with length %ld is too small", messageLength);
             }
 
-            OSInterfaceLogDebug(tag, "Received FF frame with full message length = %ld", messageLength);
+            OSInterfaceLogDebug(getTAG(), "Received FF frame with full message length = %ld", messageLength);
 
             int64_t availableMemory;
             availableMemoryForRunners->get(&availableMemory);
 
-            if (availableMemoryForRunners->subIfResIsGreaterThanZero(
-                    this->messageLength * static_cast<int64_t>(sizeof(uint8_t)))) // Check if there is enough memory
+            uint32_t bufferSize = messageLength;
+            if (streamingSink.onChunk != nullptr && messageLength >= streamingSink.minMessageLength)
             {
-                this->messageData = static_cast<uint8_t*>(osInterface->osMalloc(messageLength * sizeof(uint8_t)));
-
-                if (this->messageData == nullptr)
-                {
-                    returnErrorWithLog(N_ERROR, "Not enough memory for message length %ld. Available memory is %ld",
-                                       messageLength, availableMemory);
-                }
+                streaming  = true;
+                chunkSize  = streamingSink.chunkSize != 0 ? streamingSink.chunkSize
+                             : effectiveBlockSize != 0     ? effectiveBlockSize * MAX_CF_MESSAGE_LENGTH
+                                                           : MAX_CF_MESSAGE_LENGTH;
+                chunkSize  = MIN(chunkSize, messageLength);
+                bufferSize = chunkSize;
+                OSInterfaceLogDebug(getTAG(), "Streaming the message in chunks of %u bytes", chunkSize);
+            }
 
-                if (messageLength < MIN_FF_DL_WITH_ESCAPE_SEQUENCE)
-                {
-                    memcpy(messageData, &receivedFrame->data[2], 6);
-                    messageOffset = 6;
-                }
-                else
+            if (acquireMessageData(bufferSize)) // Check if there is enough memory
+            {
+                const bool stored = messageLength < MIN_FF_DL_WITH_ESCAPE_SEQUENCE
+                                        ? storeMessageData(&receivedFrame->data[2], 6)
+                                        : storeMessageData(&receivedFrame->data[6], 2);
+                if (!stored)
                 {
-                    memcpy(messageData, &receivedFrame->data[6], 2);
-                    messageOffset = 2;
+                    returnErrorWithLog(N_ERROR, "The streaming sink aborted the reception");
                 }
 
                 updateInternalStatus(SEND_FC);
@@ -304,16 +416,17 @@ N_Result N_USData_Indication_Runner::runStep_FC_CTS(const CANFrame* receivedFram
         returnErrorWithLog(N_ERROR, "Received frame is not null");
     }
 
-    timerN_Br->stopTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_Br stopped before sending FC frame in %u ms", timerN_Br->getElapsedTime_ms());
+    timerN_Br.stopTimer();
+    OSInterfaceLogVerbose(getTAG(), "Timer N_Br stopped before sending FC frame in %u ms",
+                          timerN_Br.getElapsedTime_ms());
 
     if (sendFCFrame(CONTINUE_TO_SEND) != N_OK)
     {
         returnErrorWithLog(N_ERROR, "Flow control frame could not be sent");
     }
 
-    timerN_Ar->startTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_Ar started after sending FC frame");
+    timerN_Ar.startTimer();
+    OSInterfaceLogVerbose(getTAG(), "Timer N_Ar started after sending FC frame");
 
     result = IN_PROGRESS;
     return result;
@@ -344,7 +457,7 @@ N_Result N_USData_Indication_Runner::runStep_CF(const CANFrame* receivedFrame)
                            messageSequenceNumber, sequenceNumber);
     }
 
-    sequenceNumber++;
+    sequenceNumber = (sequenceNumber + 1) & 0b00001111; // The SN wraps around from 15 to 0.
 
     if (receivedFrame->data_length_code <= 1)
     {
@@ -357,19 +470,21 @@ N_Result N_USData_Indication_Runner::runStep_CF(const CANFrame* receivedFrame)
             messageLength - messageOffset); // Copy the minimum between the remaining bytes and the received bytes (1st
                                             // byte is used to transport metadata).
 
-    memcpy(&messageData[messageOffset], &receivedFrame->data[1], bytesToCopy);
+    if (!storeMessageData(&receivedFrame->data[1], bytesToCopy))
+    {
+        returnErrorWithLog(N_ERROR, "The streaming sink aborted the reception");
+    }
 
-    messageOffset += bytesToCopy;
     cfReceivedInThisBlock++;
 
-    OSInterfaceLogDebug(tag, "Received CF #%d in block with %d data bytes", cfReceivedInThisBlock, bytesToCopy);
+    OSInterfaceLogDebug(getTAG(), "Received CF #%d in block with %d data bytes", cfReceivedInThisBlock, bytesToCopy);
 
     if (messageOffset == messageLength)
     {
-        timerN_Cr->stopTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_Cr stopped after receiving CF frame in %u ms",
-                              timerN_Cr->getElapsedTime_ms());
-        OSInterfaceLogInfo(tag, "Received message with length %ld (MF)", messageLength);
+        timerN_Cr.stopTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_Cr stopped after receiving CF frame in %u ms",
+                              timerN_Cr.getElapsedTime_ms());
+        OSInterfaceLogInfo(getTAG(), "Received message with length %ld (MF)", messageLength);
         result = N_OK;
         updateInternalStatus(MESSAGE_RECEIVED);
     }
@@ -377,21 +492,21 @@ N_Result N_USData_Indication_Runner::runStep_CF(const CANFrame* receivedFrame)
     {
         if (effectiveBlockSize == cfReceivedInThisBlock)
         {
-            timerN_Cr->stopTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cr stopped after receiving CF frame in %u ms",
-                                  timerN_Cr->getElapsedTime_ms());
-            timerN_Br->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Br started after receiving CF frame");
+            timerN_Cr.stopTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cr stopped after receiving CF frame in %u ms",
+                                  timerN_Cr.getElapsedTime_ms());
+            timerN_Br.startTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Br started after receiving CF frame");
 
             cfReceivedInThisBlock = 0;
-            OSInterfaceLogDebug(tag, "CF block size reached.");
+            OSInterfaceLogDebug(getTAG(), "CF block size reached.");
 
             updateInternalStatus(SEND_FC);
         }
         else
         {
-            timerN_Cr->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cr started after receiving CF frame");
+            timerN_Cr.startTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cr started after receiving CF frame");
         }
         result = IN_PROGRESS;
     }
@@ -422,8 +537,9 @@ N_Result N_USData_Indication_Runner::sendFCFrame(const FlowStatus fs)
 
     fcFrame.data_length_code = FC_MESSAGE_LENGTH;
 
-    OSInterfaceLogDebug(tag, "Sending FC frame with flow status %d, block size %d and STmin %s", fs, effectiveBlockSize,
-                        STminToString(stMin));
+    char stMinStr[MAX_STMIN_STR_SIZE];
+    OSInterfaceLogDebug(getTAG(), "Sending FC frame with flow status %d, block size %d and STmin %s", fs,
+                        effectiveBlockSize, STminToString(stMin, stMinStr, sizeof(stMinStr)));
 
     if (CanMessageACKQueue->writeFrame(*this, fcFrame))
     {
@@ -431,26 +547,26 @@ N_Result N_USData_Indication_Runner::sendFCFrame(const FlowStatus fs)
         return N_OK;
     }
 
-    OSInterfaceLogError(tag, "FC frame could not be sent");
+    OSInterfaceLogError(getTAG(), "FC frame could not be sent");
     return N_ERROR;
 }
 
 N_Result N_USData_Indication_Runner::checkTimeouts()
 {
-    uint32_t N_Br_performance = timerN_Br->getElapsedTime_ms() + timerN_Ar->getElapsedTime_ms();
+    uint32_t N_Br_performance = timerN_Br.getElapsedTime_ms() + timerN_Ar.getElapsedTime_ms();
     if (N_Br_performance > N_Br_TIMEOUT_MS)
     {
-        OSInterfaceLogWarning(tag, "N_Br performance not met. Elapsed time is %u ms and required is %u",
+        OSInterfaceLogWarning(getTAG(), "N_Br performance not met. Elapsed time is %u ms and required is %u",
                               N_Br_performance, N_Br_TIMEOUT_MS);
     }
-    if (timerN_Ar->getElapsedTime_ms() > N_Ar_TIMEOUT_MS)
+    if (timerN_Ar.getElapsedTime_ms() > N_Ar_TIMEOUT_MS)
     {
-        returnErrorWithLog(N_TIMEOUT_A, "Elapsed time is %u ms and timeout is %u", timerN_Ar->getElapsedTime_ms(),
+        returnErrorWithLog(N_TIMEOUT_A, "Elapsed time is %u ms and timeout is %u", timerN_Ar.getElapsedTime_ms(),
                            N_Ar_TIMEOUT_MS);
     }
-    if (timerN_Cr->getElapsedTime_ms() > N_Cr_TIMEOUT_MS)
+    if (timerN_Cr.getElapsedTime_ms() > N_Cr_TIMEOUT_MS)
     {
-        returnErrorWithLog(N_TIMEOUT_Cr, "Elapsed time is %u ms and timeout is %u", timerN_Cr->getElapsedTime_ms(),
+        returnErrorWithLog(N_TIMEOUT_Cr, "Elapsed time is %u ms and timeout is %u", timerN_Cr.getElapsedTime_ms(),
                            N_Cr_TIMEOUT_MS);
     }
     return N_OK;
@@ -458,25 +574,25 @@ N_Result N_USData_Indication_Runner::checkTimeouts()
 
 uint32_t N_USData_Indication_Runner::getNextTimeoutTime() const
 {
-    int32_t timeoutAr = timerN_Ar->isTimerRunning()
-                            ? (N_Ar_TIMEOUT_MS - static_cast<int32_t>(timerN_Ar->getElapsedTime_ms()))
+    int32_t timeoutAr = timerN_Ar.isTimerRunning()
+                            ? (N_Ar_TIMEOUT_MS - static_cast<int32_t>(timerN_Ar.getElapsedTime_ms()))
                             : MAX_TIMEOUT_MS;
-    int32_t timeoutCr = timerN_Cr->isTimerRunning()
-                            ? (N_Cr_TIMEOUT_MS - static_cast<int32_t>(timerN_Cr->getElapsedTime_ms()))
+    int32_t timeoutCr = timerN_Cr.isTimerRunning()
+                            ? (N_Cr_TIMEOUT_MS - static_cast<int32_t>(timerN_Cr.getElapsedTime_ms()))
                             : MAX_TIMEOUT_MS;
 
     int32_t minTimeout = MIN(timeoutAr, timeoutCr);
 
     if (minTimeout == timeoutAr)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Ar with %d ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Ar with %d ms remaining", minTimeout);
     }
     else if (minTimeout == timeoutCr)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Cr with %d ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Cr with %d ms remaining", minTimeout);
     }
 
-    OSInterfaceLogVerbose(tag, "Next timeout is in %u ms", minTimeout);
+    OSInterfaceLogVerbose(getTAG(), "Next timeout is in %u ms", minTimeout);
     return minTimeout + osInterface->osMillis();
 }
 
@@ -484,7 +600,7 @@ uint32_t N_USData_Indication_Runner::getNextRunTime()
 {
     if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return 0;
@@ -501,11 +617,11 @@ uint32_t N_USData_Indication_Runner::getNextRunTime()
             [[fallthrough]];
         case SEND_FC:
             nextRunTime = 0; // Execute as soon as possible
-            OSInterfaceLogDebug(tag, "Next run time is NOW because internalStatus is %s (%d)",
+            OSInterfaceLogDebug(getTAG(), "Next run time is NOW because internalStatus is %s (%d)",
                                 internalStatusToString(internalStatus), internalStatus);
             break;
         default:
-            OSInterfaceLogDebug(tag, "Next run time is in %ld ms because of next timeout",
+            OSInterfaceLogDebug(getTAG(), "Next run time is in %ld ms because of next timeout",
                                 static_cast<int64_t>(nextRunTime) - osInterface->osMillis());
             break;
     }
@@ -519,13 +635,13 @@ void N_USData_Indication_Runner::messageACKReceivedCallback(const CANInterface::
 {
     if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return;
     }
 
-    OSInterfaceLogDebug(tag, "Running messageACKReceivedCallback with internalStatus = %s (%d) and success = %s",
+    OSInterfaceLogDebug(getTAG(), "Running messageACKReceivedCallback with internalStatus = %s (%d) and success = %s",
                         internalStatusToString(internalStatus), internalStatus,
                         CANInterface::ackResultToString(success));
 
@@ -533,12 +649,12 @@ void N_USData_Indication_Runner::messageACKReceivedCallback(const CANInterface::
     {
         case AWAITING_FC_ACK:
         {
-            OSInterfaceLogDebug(tag, "Received FC ACK");
+            OSInterfaceLogDebug(getTAG(), "Received FC ACK");
             FC_ACKReceivedCallback(success);
         }
         break;
         default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
+            OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
                                 internalStatus);
             result = N_ERROR;
             updateInternalStatus(ERROR);
@@ -552,23 +668,25 @@ void N_USData_Indication_Runner::FC_ACKReceivedCallback(const CANInterface::ACKR
 {
     if (success == CANInterface::ACK_SUCCESS)
     {
-        timerN_Ar->stopTimer();
-        timerN_Br->clearTimer();
-        timerN_Cr->startTimer();
-        OSInterfaceLogDebug(tag, "FC ACK received");
+        timerN_Ar.stopTimer();
+        timerN_Br.clearTimer();
+        timerN_Cr.startTimer();
+        OSInterfaceLogDebug(getTAG(), "FC ACK received");
 
         updateInternalStatus(AWAITING_CF);
 
         if (frameToHoldValid)
         {
-            OSInterfaceLogDebug(tag, "Processing held frame: %s", frameToString(frameToHold));
+            char frameStr[MAX_FRAME_STR_SIZE];
+            OSInterfaceLogDebug(getTAG(), "Processing held frame: %s",
+                                frameToString(frameToHold, frameStr, sizeof(frameStr)));
             frameToHoldValid = false; // Reset the held frame after processing.
             runStep_internal(&frameToHold);
         }
     }
     else
     {
-        OSInterfaceLogError(tag, "FC ACK failed with result %d", success);
+        OSInterfaceLogError(getTAG(), "FC ACK failed with result %d", success);
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -580,7 +698,7 @@ bool N_USData_Indication_Runner::setBlockSize(const uint8_t blockSize)
     {
         this->blockSize = blockSize;
         mutex->signal();
-        OSInterfaceLogInfo(tag, "Block size set to %d", blockSize);
+        OSInterfaceLogInfo(getTAG(), "Block size set to %d", blockSize);
         return true;
     }
     return false;
@@ -592,7 +710,8 @@ bool N_USData_Indication_Runner::setSTmin(const STmin stMin)
     {
         this->stMin = stMin;
         mutex->signal();
-        OSInterfaceLogInfo(tag, "STmin set to %s", STminToString(stMin));
+        char stMinStr[MAX_STMIN_STR_SIZE];
+        OSInterfaceLogInfo(getTAG(), "STmin set to %s", STminToString(stMin, stMinStr, sizeof(stMinStr)));
         return true;
     }
     return false;
@@ -603,9 +722,14 @@ N_AI N_USData_Indication_Runner::getN_AI() const
     return nAi;
 }
 
+N_AI N_USData_Indication_Runner::getInboundN_AI() const
+{
+    return nAi;
+}
+
 uint8_t* N_USData_Indication_Runner::getMessageData() const
 {
-    return messageData;
+    return streaming ? nullptr : messageData; // A streamed message was given to the sink, it is not kept.
 }
 
 uint32_t N_USData_Indication_Runner::getMessageLength() const
@@ -628,9 +752,9 @@ N_USData_Indication_Runner::RunnerType N_USData_Indication_Runner::getRunnerType
     return RunnerIndicationType;
 }
 
-const char* N_USData_Indication_Runner::getTAG() const
+const char* N_USData_Indication_Runner::formatTag(char* buffer, const size_t bufferSize) const
 {
-    return this->tag;
+    return formatRunnerTag(buffer, bufferSize, N_USDATA_INDICATION_RUNNER_STATIC_TAG, this->nAi);
 }
 
 bool N_USData_Indication_Runner::isThisFrameForMe(const CANFrame& frame) const
@@ -638,7 +762,9 @@ bool N_USData_Indication_Runner::isThisFrameForMe(const CANFrame& frame) const
     bool res = getN_AI().N_AI == frame.identifier.N_AI;
     res &= awaitingFrame(frame);
 
-    OSInterfaceLogDebug(tag, "isThisFrameForMe() = %s for frame %s", res ? "true" : "false", frameToString(frame));
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogDebug(getTAG(), "isThisFrameForMe() = %s for frame %s", res ? "true" : "false",
+                        frameToString(frame, frameStr, sizeof(frameStr)));
     return res;
 }
 
@@ -1,4 +1,5 @@
 #include "N_USData_Request_Runner.h"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <ctime>
@@ -6,144 +7,312 @@
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
 
-N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
-                                                 Atomic_int64_t& availableMemoryForRunners, const Mtype mType,
-                                                 const uint8_t* messageData, const uint32_t messageLength,
-                                                 OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue)
+N_USData_Request_Runner::N_USData_Request_Runner(bool& result, Atomic_int64_t& availableMemoryForRunners,
+                                                 OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue,
+                                                 MemoryArena* messageArena) :
+    timerN_As(osInterface), timerN_Bs(osInterface), timerN_Cs(osInterface)
 {
     result = false;
 
     this->availableMemoryForRunners = &availableMemoryForRunners;
     this->osInterface               = &osInterface;
+    this->messageArena              = messageArena;
+    this->CanMessageACKQueue        = &canMessageACKQueue;
+    this->nAi                       = {};
+    this->mType                     = Mtype_Unknown;
+    this->messageData               = nullptr;
+    this->messageLength             = 0;
+    this->internalStatus            = ERROR;
+    this->result                    = NOT_STARTED;
 
-    if (this->availableMemoryForRunners->subIfResIsGreaterThanZero(N_USDATA_REQUEST_RUNNER_TAG_SIZE))
-    {
-        this->tag = static_cast<char*>(this->osInterface->osMalloc(N_USDATA_REQUEST_RUNNER_TAG_SIZE));
-        if (this->tag == nullptr)
-        {
-            return;
-        }
-        snprintf(this->tag, N_USDATA_REQUEST_RUNNER_TAG_SIZE, "%s%s", N_USDATA_REQUEST_RUNNER_STATIC_TAG,
-                 nAiToString(nAi));
-    }
-    else
+    // The mutex is kept while the runner is recycled, only the message changes with reset().
+    this->mutex = osInterface.osCreateMutex();
+    if (this->mutex == nullptr)
     {
+        OSInterfaceLogError(getTAG(), AT "Failed to create mutex");
         return;
     }
 
-    OSInterfaceLogDebug(tag, "Creating N_USData_Request_Runner with tag %s", this->tag);
-
-    this->nAi                = nAi;
-    this->mType              = Mtype_Unknown;
-    this->CanMessageACKQueue = &canMessageACKQueue;
-    this->blockSize          = 0;
-    this->stMin              = DEFAULT_STMIN;
-    this->lastRunTime        = 0;
-    this->sequenceNumber = 1; // The first sequence number that is being sent is 1. (0 is reserved for the first frame)
+    result = true;
+}
 
-    this->mutex = osInterface.osCreateMutex();
-    if (this->mutex == nullptr)
+N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
+                                                 Atomic_int64_t& availableMemoryForRunners, const Mtype mType,
+                                                 const uint8_t* messageData, const uint32_t messageLength,
+                                                 OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue) :
+    N_USData_Request_Runner(result, availableMemoryForRunners, osInterface, canMessageACKQueue)
+{
+    if (result)
     {
-        OSInterfaceLogError(tag, AT "Failed to create mutex");
-        return;
+        result = reset(nAi, mType, messageData, messageLength);
     }
+}
 
-    this->internalStatus            = ERROR;
-    this->result                    = NOT_STARTED;
-    this->messageOffset             = 0;
-    this->messageData               = nullptr;
-    this->messageLength             = messageLength;
-    this->availableMemoryForRunners = &availableMemoryForRunners;
-    this->cfSentInThisBlock         = 0;
-
-    this->timerN_As = new Timer_N(osInterface);
-    this->timerN_Bs = new Timer_N(osInterface);
-    this->timerN_Cs = new Timer_N(osInterface);
+bool N_USData_Request_Runner::reset(const N_AI nAi, const Mtype mType, const uint8_t* messageData,
+                                    const uint32_t messageLength)
+{
+    clearState(nAi, messageLength);
 
     if (this->availableMemoryForRunners->subIfResIsGreaterThanZero(this->messageLength *
                                                                    static_cast<int64_t>(sizeof(uint8_t))) &&
         messageData != nullptr)
     {
-        this->messageData = static_cast<uint8_t*>(osInterface.osMalloc(this->messageLength * sizeof(uint8_t)));
-
         if (this->messageLength == 0)
         {
-            this->messageData = static_cast<uint8_t*>(osInterface.osMalloc(1 * sizeof(uint8_t)));
+            this->messageData = allocateMessageData(1);
             if (this->messageData != nullptr)
             {
                 this->messageData[0] = '\0';
             }
         }
+        else
+        {
+            this->messageData = allocateMessageData(this->messageLength);
+        }
         if (this->messageData == nullptr)
         {
+            availableMemoryForRunners->add(this->messageLength * static_cast<int64_t>(sizeof(uint8_t)));
             int64_t availableMemory;
-            availableMemoryForRunners.get(&availableMemory);
-            OSInterfaceLogError(tag, "Not enough memory for message length %u. Available memory is %ld", messageLength,
-                                availableMemory);
+            availableMemoryForRunners->get(&availableMemory);
+            OSInterfaceLogError(getTAG(), "Not enough memory for message length %u. Available memory is %ld",
+                                messageLength, availableMemory);
         }
         else
         {
             memcpy(this->messageData, messageData, this->messageLength);
-            this->mType = mType;
-
-            if (this->nAi.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional &&
-                this->messageLength > MAX_SF_MESSAGE_LENGTH)
-            {
-                OSInterfaceLogError(tag, "Message length %u is too long for N_TAtype %s", messageLength,
-                                    N_TAtypeToString(this->nAi.N_TAtype));
-            }
-            else
-            {
-                this->nAi = nAi;
-
-                if (messageLength <= MAX_SF_MESSAGE_LENGTH)
-                {
-                    OSInterfaceLogDebug(tag, "Message type is Single Frame");
-                    internalStatus = NOT_RUNNING_SF;
-                }
-                else
-                {
-                    OSInterfaceLogDebug(tag, "Message type is Multiple Frame");
-                    internalStatus = NOT_RUNNING_FF;
-                }
-
-                result = true;
-            }
+            this->segments[0]  = {this->messageData, static_cast<uint32_t>(this->messageLength)};
+            this->segmentCount = 1;
+            return prepare(mType);
         }
     }
     else
     {
         int64_t availableMemory;
-        availableMemoryForRunners.get(&availableMemory);
-        OSInterfaceLogError(tag, "Not enough memory for message length %u. Available memory is %ld", messageLength,
+        availableMemoryForRunners->get(&availableMemory);
+        OSInterfaceLogError(getTAG(), "Not enough memory for message length %u. Available memory is %ld", messageLength,
                             availableMemory);
     }
+    return false;
 }
 
-// Be careful with the destructor. All the pointers used in the destructor need to be initialized to nullptr. Otherwise,
-// the destructor may attempt a free on an invalid pointer.
-N_USData_Request_Runner::~N_USData_Request_Runner()
+bool N_USData_Request_Runner::reset(const N_AI nAi, const Mtype mType, const uint8_t* messageData,
+                                    const uint32_t messageLength, const N_USData_release_cb_t releaseCallback,
+                                    void* releaseContext)
+{
+    const N_USData_Segment segment = {messageData, messageLength};
+    return reset(nAi, mType, &segment, 1, releaseCallback, releaseContext);
+}
+
+bool N_USData_Request_Runner::reset(const N_AI nAi, const Mtype mType, const N_USData_Segment* segments,
+                                    const uint8_t segmentCount, const N_USData_release_cb_t releaseCallback,
+                                    void* releaseContext)
 {
-    OSInterfaceLogDebug(tag, "Deleting runner");
+    clearState(nAi, 0);
+
+    if (segments == nullptr || segmentCount == 0 || segmentCount > ISOTP_MaxMessageSegments ||
+        releaseCallback == nullptr)
+    {
+        OSInterfaceLogError(getTAG(), "A lent message needs 1 to %u segments and a release callback",
+                            ISOTP_MaxMessageSegments);
+        return false;
+    }
+
+    int64_t messageLength = 0;
+    for (uint8_t i = 0; i < segmentCount; i++)
+    {
+        if (segments[i].data == nullptr)
+        {
+            OSInterfaceLogError(getTAG(), "Segment %u of the lent message has no data", i);
+            return false;
+        }
+        messageLength += segments[i].length;
+        this->segments[i] = segments[i];
+    }
+    if (messageLength > UINT32_MAX)
+    {
+        OSInterfaceLogError(getTAG(), "The segments of the lent message are too long");
+        return false;
+    }
+
+    // The runner only reads the message, so the buffers of the caller are used as they are.
+    this->messageLength   = messageLength;
+    this->segmentCount    = segmentCount;
+    this->messageData     = const_cast<uint8_t*>(segments[0].data);
+    this->releaseCallback = releaseCallback;
+    this->releaseContext  = releaseContext;
+    if (!prepare(mType))
+    {
+        forgetLentMessage();
+        return false;
+    }
+    return true;
+}
+
+bool N_USData_Request_Runner::reset(const N_AI nAi, const Mtype mType, const uint32_t messageLength,
+                                    const N_USData_source_cb_t source, void* sourceContext)
+{
+    clearState(nAi, messageLength);
+
+    if (source == nullptr)
+    {
+        OSInterfaceLogError(getTAG(), "A message sent from a data source needs a source function");
+        return false;
+    }
+
+    this->source        = source;
+    this->sourceContext = sourceContext;
+    return prepare(mType);
+}
+
+void N_USData_Request_Runner::clearState(const N_AI nAi, const uint32_t messageLength)
+{
+    release();
+
+    this->nAi = nAi;
+    OSInterfaceLogDebug(getTAG(), "Starting N_USData_Request_Runner");
 
+    this->mType          = Mtype_Unknown;
+    this->blockSize      = 0;
+    this->stMin          = DEFAULT_STMIN;
+    this->lastRunTime    = 0;
+    this->sequenceNumber = 1; // The first sequence number that is being sent is 1. (0 is reserved for the first frame)
+
+    this->internalStatus    = ERROR;
+    this->result            = NOT_STARTED;
+    this->messageOffset     = 0;
+    this->messageData       = nullptr;
+    this->messageLength     = messageLength;
+    this->segmentCount      = 0;
+    this->segmentIndex      = 0;
+    this->segmentOffset     = 0;
+    this->source            = nullptr;
+    this->sourceContext     = nullptr;
+    this->cfSentInThisBlock = 0;
+    this->frameToHoldValid  = false;
+
+    this->timerN_As.clearTimer();
+    this->timerN_Bs.clearTimer();
+    this->timerN_Cs.clearTimer();
+}
+
+bool N_USData_Request_Runner::prepare(const Mtype mType)
+{
+    this->mType = mType;
+
+    if (this->nAi.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional && this->messageLength > MAX_SF_MESSAGE_LENGTH)
+    {
+        OSInterfaceLogError(getTAG(), "Message length %u is too long for N_TAtype %s",
+                            static_cast<uint32_t>(this->messageLength), N_TAtypeToString(this->nAi.N_TAtype));
+        return false;
+    }
+
+    if (this->messageLength <= MAX_SF_MESSAGE_LENGTH)
+    {
+        OSInterfaceLogDebug(getTAG(), "Message type is Single Frame");
+        internalStatus = NOT_RUNNING_SF;
+    }
+    else
+    {
+        OSInterfaceLogDebug(getTAG(), "Message type is Multiple Frame");
+        internalStatus = NOT_RUNNING_FF;
+    }
+    return true;
+}
+
+void N_USData_Request_Runner::release()
+{
     if (this->messageData != nullptr)
     {
-        osInterface->osFree(this->messageData);
-        availableMemoryForRunners->add(messageLength * static_cast<int64_t>(sizeof(uint8_t)));
+        if (this->releaseCallback != nullptr)
+        {
+            this->releaseCallback(this->messageData, static_cast<uint32_t>(this->messageLength), this->releaseContext);
+            this->releaseCallback = nullptr;
+            this->releaseContext  = nullptr;
+        }
+        else
+        {
+            freeMessageData();
+            availableMemoryForRunners->add(messageLength * static_cast<int64_t>(sizeof(uint8_t)));
+        }
+        this->messageData = nullptr;
     }
+}
 
-    if (this->tag != nullptr)
+void N_USData_Request_Runner::forgetLentMessage()
+{
+    if (this->releaseCallback != nullptr)
     {
-        osInterface->osFree(this->tag);
-        availableMemoryForRunners->add(N_USDATA_REQUEST_RUNNER_TAG_SIZE);
+        this->messageData     = nullptr;
+        this->releaseCallback = nullptr;
+        this->releaseContext  = nullptr;
     }
+}
+
+uint8_t* N_USData_Request_Runner::allocateMessageData(const uint32_t length) const
+{
+    if (this->messageArena != nullptr)
+    {
+        return static_cast<uint8_t*>(this->messageArena->allocate(length * sizeof(uint8_t)));
+    }
+    return static_cast<uint8_t*>(this->osInterface->osMalloc(length * sizeof(uint8_t)));
+}
+
+void N_USData_Request_Runner::freeMessageData() const
+{
+    if (this->messageArena != nullptr)
+    {
+        this->messageArena->free(this->messageData);
+    }
+    else
+    {
+        this->osInterface->osFree(this->messageData);
+    }
+}
+
+// Be careful with the destructor. All the pointers used in the destructor need to be initialized to nullptr. Otherwise,
+// the destructor may attempt a free on an invalid pointer.
+N_USData_Request_Runner::~N_USData_Request_Runner()
+{
+    OSInterfaceLogDebug(getTAG(), "Deleting runner");
+
+    release();
 
-    delete timerN_As;
-    delete timerN_Bs;
-    delete timerN_Cs;
     delete mutex;
 }
 
+bool N_USData_Request_Runner::copyMessage(uint8_t* destination, uint32_t length)
+{
+    if (this->source != nullptr)
+    {
+        if (!this->source(this->messageOffset, destination, length, this->sourceContext))
+        {
+            OSInterfaceLogError(getTAG(), "The source failed to give %u bytes at offset %u", length,
+                                this->messageOffset);
+            return false;
+        }
+        this->messageOffset += length;
+        return true;
+    }
+
+    while (length > 0 && this->segmentIndex < this->segmentCount)
+    {
+        const N_USData_Segment& segment = this->segments[this->segmentIndex];
+        const uint32_t          size    = std::min(length, segment.length - this->segmentOffset);
+
+        memcpy(destination, &segment.data[this->segmentOffset], size);
+        destination += size;
+        length -= size;
+        this->messageOffset += size;
+        this->segmentOffset += size;
+        if (this->segmentOffset == segment.length)
+        {
+            this->segmentIndex++;
+            this->segmentOffset = 0;
+        }
+    }
+    return true;
+}
+
 N_Result N_USData_Request_Runner::sendCFFrame()
 {
     CANFrame cfFrame   = NewCANFrameISOTP();
@@ -152,47 +321,49 @@ N_Result N_USData_Request_Runner::sendCFFrame()
     int64_t remainingBytes  = messageLength - messageOffset;
     uint8_t frameDataLength = remainingBytes > MAX_CF_MESSAGE_LENGTH ? MAX_CF_MESSAGE_LENGTH : remainingBytes;
 
-    cfFrame.data[0] = (CF_CODE << 4) | (sequenceNumber & 0b00001111);       // (0b0010xxxx) | SN (0bxxxxllll)
-    memcpy(&cfFrame.data[1], &messageData[messageOffset], frameDataLength); // Payload data
-    messageOffset += frameDataLength;
+    cfFrame.data[0] = (CF_CODE << 4) | (sequenceNumber & 0b00001111); // (0b0010xxxx) | SN (0bxxxxllll)
+    if (!copyMessage(&cfFrame.data[1], frameDataLength))               // Payload data
+    {
+        returnErrorWithLog(N_ERROR, "CF frame data could not be read");
+    }
 
     cfFrame.data_length_code = frameDataLength + 1; // 1 byte for N_PCI_SF
 
-    OSInterfaceLogDebug(tag, "Sending CF #%d in block with %d data bytes", cfSentInThisBlock + 1, frameDataLength);
+    OSInterfaceLogDebug(getTAG(), "Sending CF #%d in block with %d data bytes", cfSentInThisBlock + 1, frameDataLength);
 
     if (CanMessageACKQueue->writeFrame(*this, cfFrame))
     {
         cfSentInThisBlock++;
         sequenceNumber++;
-        timerN_As->startTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As started after sending CF");
+        timerN_As.startTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As started after sending CF");
 
         updateInternalStatus(AWAITING_CF_ACK);
         result = IN_PROGRESS;
         return result;
     }
 
-    OSInterfaceLogError(tag, "CF frame could not be sent");
+    OSInterfaceLogError(getTAG(), "CF frame could not be sent");
     result = N_ERROR;
     return result;
 }
 
 N_Result N_USData_Request_Runner::checkTimeouts()
 {
-    uint32_t N_Cs_performance = timerN_Cs->getElapsedTime_ms() + timerN_As->getElapsedTime_ms();
+    uint32_t N_Cs_performance = timerN_Cs.getElapsedTime_ms() + timerN_As.getElapsedTime_ms();
     if (N_Cs_performance > N_Cs_TIMEOUT_MS)
     {
-        OSInterfaceLogWarning(tag, "N_Cs performance not met. Elapsed time is %u ms and required is %u",
+        OSInterfaceLogWarning(getTAG(), "N_Cs performance not met. Elapsed time is %u ms and required is %u",
                               N_Cs_performance, N_Cs_TIMEOUT_MS);
     }
-    if (timerN_As->getElapsedTime_ms() > N_As_TIMEOUT_MS)
+    if (timerN_As.getElapsedTime_ms() > N_As_TIMEOUT_MS)
     {
-        returnErrorWithLog(N_TIMEOUT_A, "Elapsed time is %u ms and timeout is %u", timerN_As->getElapsedTime_ms(),
+        returnErrorWithLog(N_TIMEOUT_A, "Elapsed time is %u ms and timeout is %u", timerN_As.getElapsedTime_ms(),
                            N_As_TIMEOUT_MS);
     }
-    if (timerN_Bs->getElapsedTime_ms() > N_Bs_TIMEOUT_MS)
+    if (timerN_Bs.getElapsedTime_ms() > N_Bs_TIMEOUT_MS)
     {
-        returnErrorWithLog(N_TIMEOUT_Bs, "Elapsed time is %u ms and timeout is %u", timerN_Bs->getElapsedTime_ms(),
+        returnErrorWithLog(N_TIMEOUT_Bs, "Elapsed time is %u ms and timeout is %u", timerN_Bs.getElapsedTime_ms(),
                            N_Bs_TIMEOUT_MS);
     }
     return N_OK;
@@ -223,16 +394,18 @@ N_Result N_USData_Request_Runner::runStep(CANFrame* receivedFrame)
         returnErrorWithLog(N_ERROR, "Failed to acquire mutex");
     }
 
-    OSInterfaceLogVerbose(tag, "Running step with internalStatus = %s (%d) and frame %s",
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogVerbose(getTAG(), "Running step with internalStatus = %s (%d) and frame %s",
                           internalStatusToString(internalStatus), internalStatus,
-                          receivedFrame != nullptr ? frameToString(*receivedFrame) : "null");
+                          receivedFrame != nullptr ? frameToString(*receivedFrame, frameStr, sizeof(frameStr))
+                                                   : "null");
 
     N_Result res = checkTimeouts();
 
     if (res != N_OK)
     {
         mutex->signal();
-        OSInterfaceLogError(tag, "Timeout occurred: %s", N_ResultToString(res));
+        OSInterfaceLogError(getTAG(), "Timeout occurred: %s", N_ResultToString(res));
         return res;
     }
 
@@ -264,7 +437,7 @@ N_Result N_USData_Request_Runner::runStep_internal(const CANFrame* receivedFrame
             res = runStep_FC(receivedFrame);
             break;
         case MESSAGE_SENT:
-            OSInterfaceLogDebug(tag, "Message sent successfully");
+            OSInterfaceLogDebug(getTAG(), "Message sent successfully");
             result = N_OK; // If the message is successfully sent, return N_OK to allow ISOTP to call the callback.
             res    = result;
             break;
@@ -277,7 +450,7 @@ N_Result N_USData_Request_Runner::runStep_internal(const CANFrame* receivedFrame
             res = result;
             break;
         default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
+            OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
                                 internalStatus);
             result = N_ERROR;
             updateInternalStatus(ERROR);
@@ -297,8 +470,11 @@ N_Result N_USData_Request_Runner::runStep_holdFrame(const CANFrame* receivedFram
         returnErrorWithLog(N_ERROR, "Received frame is null");
     }
 
-    OSInterfaceLogWarning(tag, "Received frame while waiting for ACK in %s (%d). Storing it for later use Frame: %s",
-                          internalStatusToString(internalStatus), internalStatus, frameToString(*receivedFrame));
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogWarning(getTAG(),
+                          "Received frame while waiting for ACK in %s (%d). Storing it for later use Frame: %s",
+                          internalStatusToString(internalStatus), internalStatus,
+                          frameToString(*receivedFrame, frameStr, sizeof(frameStr)));
 
     if (frameToHoldValid)
     {
@@ -314,8 +490,8 @@ N_Result N_USData_Request_Runner::runStep_holdFrame(const CANFrame* receivedFram
 
 N_Result N_USData_Request_Runner::runStep_CF(const CANFrame* receivedFrame)
 {
-    timerN_Cs->stopTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_Cs stopped before sending CF in %u ms", timerN_Cs->getElapsedTime_ms());
+    timerN_Cs.stopTimer();
+    OSInterfaceLogVerbose(getTAG(), "Timer N_Cs stopped before sending CF in %u ms", timerN_Cs.getElapsedTime_ms());
     if (receivedFrame != nullptr)
     {
         returnErrorWithLog(N_ERROR, "Received frame is not null");
@@ -335,13 +511,13 @@ N_Result N_USData_Request_Runner::runStep_FF(const CANFrame* receivedFrame)
     CANFrame ffFrame   = NewCANFrameISOTP();
     ffFrame.identifier = nAi;
 
+    bool dataRead;
     if (messageLength < MIN_FF_DL_WITH_ESCAPE_SEQUENCE)
     {
         ffFrame.data[0] = FF_CODE << 4 | messageLength >> 8; // N_PCI_FF (0b0001xxxx) | messageLength (0bxxxxllll)
         ffFrame.data[1] = messageLength & 0b11111111;        // messageLength LSB
 
-        memcpy(&ffFrame.data[2], messageData, 6); // Payload data
-        messageOffset = 6;
+        dataRead = copyMessage(&ffFrame.data[2], 6); // Payload data
     }
     else
     {
@@ -355,18 +531,22 @@ N_Result N_USData_Request_Runner::runStep_FF(const CANFrame* receivedFrame)
         ffFrame.data[4] = messageLength >> 8 & 0b11111111;
         ffFrame.data[5] = messageLength & 0b11111111;
 
-        memcpy(&ffFrame.data[6], messageData, 2); // Payload data
-        messageOffset = 2;
+        dataRead = copyMessage(&ffFrame.data[6], 2); // Payload data
     }
 
-    OSInterfaceLogDebug(tag, "Sending FF frame with data length %u", messageOffset);
+    if (!dataRead)
+    {
+        returnErrorWithLog(N_ERROR, "FF frame data could not be read");
+    }
+
+    OSInterfaceLogDebug(getTAG(), "Sending FF frame with data length %u", messageOffset);
 
     ffFrame.data_length_code = CAN_FRAME_MAX_DLC;
 
     if (CanMessageACKQueue->writeFrame(*this, ffFrame))
     {
-        timerN_As->startTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As started after sending FF frame");
+        timerN_As.startTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As started after sending FF frame");
 
         updateInternalStatus(AWAITING_FF_ACK);
         result = IN_PROGRESS;
@@ -383,25 +563,28 @@ N_Result N_USData_Request_Runner::runStep_SF(const CANFrame* receivedFrame)
         returnErrorWithLog(N_ERROR, "received frame is not null");
     }
 
-    timerN_As->startTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_As started before sending SF frame");
+    timerN_As.startTimer();
+    OSInterfaceLogVerbose(getTAG(), "Timer N_As started before sending SF frame");
 
     CANFrame sfFrame   = NewCANFrameISOTP();
     sfFrame.identifier = nAi;
 
-    sfFrame.data[0] = messageLength;                      // N_PCI_SF (0b0000xxxx) | messageLength (0bxxxxllll)
-    memcpy(&sfFrame.data[1], messageData, messageLength); // Payload data
+    sfFrame.data[0] = messageLength;                  // N_PCI_SF (0b0000xxxx) | messageLength (0bxxxxllll)
+    if (!copyMessage(&sfFrame.data[1], messageLength)) // Payload data
+    {
+        returnErrorWithLog(N_ERROR, "SF frame data could not be read");
+    }
 
     sfFrame.data_length_code = messageLength + 1; // 1 byte for N_PCI_SF
 
     if (CanMessageACKQueue->writeFrame(*this, sfFrame))
     {
-        OSInterfaceLogDebug(tag, "Sending SF frame with data length %ld", messageLength);
+        OSInterfaceLogDebug(getTAG(), "Sending SF frame with data length %ld", messageLength);
         updateInternalStatus(AWAITING_SF_ACK);
         result = IN_PROGRESS;
         return result;
     }
-    OSInterfaceLogError(tag, "SF frame could not be sent");
+    OSInterfaceLogError(getTAG(), "SF frame could not be sent");
     result = N_ERROR;
     return result;
 }
@@ -420,16 +603,16 @@ N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, cons
     {
         case CONTINUE_TO_SEND:
         {
-            OSInterfaceLogDebug(tag, "Received FC frame with flow status CONTINUE_TO_SEND");
+            OSInterfaceLogDebug(getTAG(), "Received FC frame with flow status CONTINUE_TO_SEND");
             blockSize         = bs;
             cfSentInThisBlock = 0;
             stMin             = stM;
 
-            timerN_Bs->stopTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Bs stopped after receiving FC frame in %u ms",
-                                  timerN_Bs->getElapsedTime_ms());
-            timerN_Cs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cs started after receiving FC frame");
+            timerN_Bs.stopTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Bs stopped after receiving FC frame in %u ms",
+                                  timerN_Bs.getElapsedTime_ms());
+            timerN_Cs.startTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cs started after receiving FC frame");
 
             result = IN_PROGRESS;
             updateInternalStatus(SEND_CF);
@@ -437,16 +620,16 @@ N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, cons
         }
         case WAIT:
         {
-            OSInterfaceLogDebug(tag, "Received FC frame with flow status WAIT");
+            OSInterfaceLogDebug(getTAG(), "Received FC frame with flow status WAIT");
             // Restart N_Bs timer
-            timerN_Bs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Bs started after receiving FC frame");
+            timerN_Bs.startTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Bs started after receiving FC frame");
             updateInternalStatus(AWAITING_FC);
             result = IN_PROGRESS;
             return result;
         }
         case OVERFLOW:
-            OSInterfaceLogDebug(tag, "Received FC frame with flow status OVERFLOW");
+            OSInterfaceLogDebug(getTAG(), "Received FC frame with flow status OVERFLOW");
             if (firstFC)
             {
                 returnError(N_BUFFER_OVFLW);
@@ -460,15 +643,15 @@ N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, cons
 
 uint32_t N_USData_Request_Runner::getNextTimeoutTime() const
 {
-    int32_t timeoutAs = timerN_As->isTimerRunning()
-                            ? (N_As_TIMEOUT_MS - static_cast<int32_t>(timerN_As->getElapsedTime_ms()))
+    int32_t timeoutAs = timerN_As.isTimerRunning()
+                            ? (N_As_TIMEOUT_MS - static_cast<int32_t>(timerN_As.getElapsedTime_ms()))
                             : MAX_TIMEOUT_MS;
-    int32_t timeoutBs = timerN_Bs->isTimerRunning()
-                            ? (N_Bs_TIMEOUT_MS - static_cast<int32_t>(timerN_Bs->getElapsedTime_ms()))
+    int32_t timeoutBs = timerN_Bs.isTimerRunning()
+                            ? (N_Bs_TIMEOUT_MS - static_cast<int32_t>(timerN_Bs.getElapsedTime_ms()))
                             : MAX_TIMEOUT_MS;
     int32_t timeoutCs =
-        timerN_Cs->isTimerRunning()
-            ? (static_cast<int32_t>(getStMinInMs(stMin)) - static_cast<int32_t>(timerN_Cs->getElapsedTime_ms()))
+        timerN_Cs.isTimerRunning()
+            ? (static_cast<int32_t>(getStMinInMs(stMin)) - static_cast<int32_t>(timerN_Cs.getElapsedTime_ms()))
             : MAX_TIMEOUT_MS;
 
     int32_t minTimeoutAsBs = MIN(timeoutAs, timeoutBs);
@@ -476,15 +659,15 @@ uint32_t N_USData_Request_Runner::getNextTimeoutTime() const
 
     if (minTimeout == timeoutAs)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_As with %d ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_As with %d ms remaining", minTimeout);
     }
     else if (minTimeout == timeoutBs)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Bs with %d ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Bs with %d ms remaining", minTimeout);
     }
     else if (minTimeout == timeoutCs)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Cs with %d ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Cs with %d ms remaining", minTimeout);
     }
 
     return minTimeout + osInterface->osMillis();
@@ -494,7 +677,7 @@ uint32_t N_USData_Request_Runner::getNextRunTime()
 {
     if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return 0;
@@ -511,11 +694,11 @@ uint32_t N_USData_Request_Runner::getNextRunTime()
             [[fallthrough]];
         case NOT_RUNNING_FF:
             nextRunTime = 0; // Execute as soon as possible
-            OSInterfaceLogDebug(tag, "Next run time is NOW because internalStatus is %s (%d)",
+            OSInterfaceLogDebug(getTAG(), "Next run time is NOW because internalStatus is %s (%d)",
                                 internalStatusToString(internalStatus), internalStatus);
             break;
         default:
-            OSInterfaceLogDebug(tag, "Next run time is in %ld ms because of next timeout",
+            OSInterfaceLogDebug(getTAG(), "Next run time is in %ld ms because of next timeout",
                                 static_cast<int64_t>(nextRunTime) - osInterface->osMillis());
             break;
     }
@@ -529,13 +712,13 @@ void N_USData_Request_Runner::messageACKReceivedCallback(const CANInterface::ACK
 {
     if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return;
     }
 
-    OSInterfaceLogDebug(tag, "Running messageACKReceivedCallback with internalStatus = %s (%d) and success = %s",
+    OSInterfaceLogDebug(getTAG(), "Running messageACKReceivedCallback with internalStatus = %s (%d) and success = %s",
                         internalStatusToString(internalStatus), internalStatus,
                         CANInterface::ackResultToString(success));
 
@@ -543,24 +726,24 @@ void N_USData_Request_Runner::messageACKReceivedCallback(const CANInterface::ACK
     {
         case AWAITING_SF_ACK:
         {
-            OSInterfaceLogDebug(tag, "Received SF ACK");
+            OSInterfaceLogDebug(getTAG(), "Received SF ACK");
             SF_ACKReceivedCallback(success);
             break;
         }
         case AWAITING_FF_ACK:
         {
-            OSInterfaceLogDebug(tag, "Received FF ACK");
+            OSInterfaceLogDebug(getTAG(), "Received FF ACK");
             FF_ACKReceivedCallback(success);
             break;
         }
         case AWAITING_CF_ACK:
         {
-            OSInterfaceLogDebug(tag, "Received CF ACK");
+            OSInterfaceLogDebug(getTAG(), "Received CF ACK");
             CF_ACKReceivedCallback(success);
             break;
         }
         default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
+            OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%d)", internalStatusToString(internalStatus),
                                 internalStatus);
             result = N_ERROR;
             updateInternalStatus(ERROR);
@@ -574,15 +757,15 @@ void N_USData_Request_Runner::SF_ACKReceivedCallback(const CANInterface::ACKResu
 {
     if (success == CANInterface::ACK_SUCCESS)
     {
-        timerN_As->stopTimer();
-        timerN_Cs->clearTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving SF ACK in %u ms",
-                              timerN_As->getElapsedTime_ms());
+        timerN_As.stopTimer();
+        timerN_Cs.clearTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving SF ACK in %u ms",
+                              timerN_As.getElapsedTime_ms());
         updateInternalStatus(MESSAGE_SENT);
     }
     else
     {
-        OSInterfaceLogError(tag, "SF ACK failed with result %d", success);
+        OSInterfaceLogError(getTAG(), "SF ACK failed with result %d", success);
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -592,25 +775,27 @@ void N_USData_Request_Runner::FF_ACKReceivedCallback(const CANInterface::ACKResu
 {
     if (success == CANInterface::ACK_SUCCESS)
     {
-        timerN_As->stopTimer();
-        timerN_Cs->clearTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving FF ACK in %u ms",
-                              timerN_As->getElapsedTime_ms());
-        timerN_Bs->startTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_Bs started after receiving FF ACK");
+        timerN_As.stopTimer();
+        timerN_Cs.clearTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving FF ACK in %u ms",
+                              timerN_As.getElapsedTime_ms());
+        timerN_Bs.startTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_Bs started after receiving FF ACK");
 
         updateInternalStatus(AWAITING_FirstFC);
 
         if (frameToHoldValid)
         {
             frameToHoldValid = false; // Reset the held frame after processing.
-            OSInterfaceLogDebug(tag, "Processing held frame: %s", frameToString(frameToHold));
+            char frameStr[MAX_FRAME_STR_SIZE];
+            OSInterfaceLogDebug(getTAG(), "Processing held frame: %s",
+                                frameToString(frameToHold, frameStr, sizeof(frameStr)));
             runStep_internal(&frameToHold);
         }
     }
     else
     {
-        OSInterfaceLogError(tag, "FF ACK failed with result %d", success);
+        OSInterfaceLogError(getTAG(), "FF ACK failed with result %d", success);
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -620,43 +805,45 @@ void N_USData_Request_Runner::CF_ACKReceivedCallback(const CANInterface::ACKResu
 {
     if (success == CANInterface::ACK_SUCCESS)
     {
-        timerN_As->stopTimer();
-        timerN_Cs->clearTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving CF ACK in %u ms",
-                              timerN_As->getElapsedTime_ms());
+        timerN_As.stopTimer();
+        timerN_Cs.clearTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving CF ACK in %u ms",
+                              timerN_As.getElapsedTime_ms());
 
         if (messageOffset == messageLength)
         {
-            timerN_As->stopTimer();
-            timerN_Cs->clearTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving CF ACK in %u ms",
-                                  timerN_As->getElapsedTime_ms());
+            timerN_As.stopTimer();
+            timerN_Cs.clearTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving CF ACK in %u ms",
+                                  timerN_As.getElapsedTime_ms());
             updateInternalStatus(MESSAGE_SENT);
         }
         else if (cfSentInThisBlock == blockSize)
         {
-            timerN_Bs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Bs started after receiving CF ACK");
+            timerN_Bs.startTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Bs started after receiving CF ACK");
 
             updateInternalStatus(AWAITING_FC);
 
             if (frameToHoldValid)
             {
                 frameToHoldValid = false; // Reset the held frame after processing.
-                OSInterfaceLogDebug(tag, "Processing held frame: %s", frameToString(frameToHold));
+                char frameStr[MAX_FRAME_STR_SIZE];
+                OSInterfaceLogDebug(getTAG(), "Processing held frame: %s",
+                                    frameToString(frameToHold, frameStr, sizeof(frameStr)));
                 runStep_internal(&frameToHold);
             }
         }
         else
         {
-            timerN_Cs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cs started after receiving CF ACK");
+            timerN_Cs.startTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cs started after receiving CF ACK");
             updateInternalStatus(SEND_CF);
         }
     }
     else
     {
-        OSInterfaceLogError(tag, "CF ACK failed with result %d", success);
+        OSInterfaceLogError(getTAG(), "CF ACK failed with result %d", success);
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -707,7 +894,8 @@ N_Result N_USData_Request_Runner::parseFCFrame(const CANFrame* receivedFrame, Fl
     }
     else // Reserved values -> max stMin value
     {
-        OSInterfaceLogWarning(tag, "FC frame has reserved STmin value %d. Defaulting to 127", receivedFrame->data[2]);
+        OSInterfaceLogWarning(getTAG(), "FC frame has reserved STmin value %d. Defaulting to 127",
+                              receivedFrame->data[2]);
         stM.unit  = ms;
         stM.value = 127;
     }
@@ -720,6 +908,14 @@ N_AI N_USData_Request_Runner::getN_AI() const
     return nAi;
 }
 
+N_AI N_USData_Request_Runner::getInboundN_AI() const
+{
+    N_AI inboundN_AI = nAi;
+    inboundN_AI.N_TA = nAi.N_SA;
+    inboundN_AI.N_SA = nAi.N_TA;
+    return inboundN_AI;
+}
+
 uint8_t* N_USData_Request_Runner::getMessageData() const
 {
     return messageData;
@@ -745,9 +941,9 @@ N_USData_Request_Runner::RunnerType N_USData_Request_Runner::getRunnerType() con
     return RunnerRequestType;
 }
 
-const char* N_USData_Request_Runner::getTAG() const
+const char* N_USData_Request_Runner::formatTag(char* buffer, const size_t bufferSize) const
 {
-    return this->tag;
+    return formatRunnerTag(buffer, bufferSize, N_USDATA_REQUEST_RUNNER_STATIC_TAG, this->nAi);
 }
 
 bool N_USData_Request_Runner::isThisFrameForMe(const CANFrame& frame) const
@@ -762,7 +958,9 @@ bool N_USData_Request_Runner::isThisFrameForMe(const CANFrame& frame) const
     res &= runnerN_AI.N_SA == frameN_AI.N_TA;
     res &= awaitingFrame(frame);
 
-    OSInterfaceLogDebug(tag, "isThisFrameForMe() = %s for frame %s", res ? "true" : "false", frameToString(frame));
+    char frameStr[MAX_FRAME_STR_SIZE];
+    OSInterfaceLogDebug(getTAG(), "isThisFrameForMe() = %s for frame %s", res ? "true" : "false",
+                        frameToString(frame, frameStr, sizeof(frameStr)));
     return res;
 }
 
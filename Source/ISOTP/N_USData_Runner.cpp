@@ -1,4 +1,5 @@
 #include "N_USData_Runner.h"
+#include <cstdio>
 
 const char* N_USData_Runner::runnerTypeToString(RunnerType type)
 {
@@ -48,3 +49,19 @@ const char* N_USData_Runner::flowStatusToString(FlowStatus status)
             return "Unknown Flow Status";
     }
 }
+
+const char* N_USData_Runner::getTAG() const
+{
+    thread_local char buffer[MAX_RUNNER_TAG_SIZE];
+    return formatTag(buffer, sizeof(buffer));
+}
+
+const char* N_USData_Runner::formatRunnerTag(char* buffer, const size_t bufferSize, const char* staticTag,
+                                             const N_AI& nAi)
+{
+    char nAiStr[MAX_N_AI_STR_SIZE];
+
+    snprintf(buffer, bufferSize, "%s%s", staticTag, nAiToString(nAi, nAiStr, sizeof(nAiStr)));
+
+    return buffer;
+}
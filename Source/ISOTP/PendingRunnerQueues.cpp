@@ -0,0 +1,87 @@
+#include "PendingRunnerQueues.h"
+
+void PendingRunnerQueues::markReady(const typeof(N_AI::N_AI) key, Queue& queue)
+{
+    if (!queue.busy && !queue.ready && !queue.runners.empty())
+    {
+        queue.ready = true;
+        this->readyN_AIs.push_back(key);
+    }
+}
+
+void PendingRunnerQueues::push(N_USData_Runner* runner)
+{
+    const typeof(N_AI::N_AI) key   = runner->getN_AI().N_AI;
+    Queue&                   queue = this->queues.try_emplace(key, Queue{{}, false, false}).first->second;
+
+    queue.runners.push_back(runner);
+    this->runnerCount++;
+    markReady(key, queue);
+}
+
+N_USData_Runner* PendingRunnerQueues::popReady()
+{
+    while (!this->readyN_AIs.empty())
+    {
+        const typeof(N_AI::N_AI) key = this->readyN_AIs.front();
+        this->readyN_AIs.pop_front();
+
+        const auto it = this->queues.find(key);
+        if (it == this->queues.end())
+        {
+            continue;
+        }
+        Queue& queue = it->second;
+        queue.ready  = false;
+        if (queue.busy || queue.runners.empty())
+        {
+            continue; // The N_AI was acquired after becoming ready, it is made ready again when released.
+        }
+
+        N_USData_Runner* runner = queue.runners.front();
+        queue.runners.pop_front();
+        queue.busy = true;
+        this->runnerCount--;
+        return runner;
+    }
+    return nullptr;
+}
+
+void PendingRunnerQueues::acquire(const N_AI& nAi)
+{
+    this->queues.try_emplace(nAi.N_AI, Queue{{}, false, false}).first->second.busy = true;
+}
+
+void PendingRunnerQueues::release(const N_AI& nAi)
+{
+    const auto it = this->queues.find(nAi.N_AI);
+    if (it == this->queues.end())
+    {
+        return;
+    }
+
+    Queue& queue = it->second;
+    queue.busy   = false;
+    if (queue.runners.empty())
+    {
+        this->queues.erase(it);
+        return;
+    }
+    markReady(nAi.N_AI, queue);
+}
+
+void PendingRunnerQueues::takeAll(std::list<N_USData_Runner*>& runners)
+{
+    for (auto& queue : this->queues)
+    {
+        runners.insert(runners.end(), queue.second.runners.begin(), queue.second.runners.end());
+    }
+    this->queues.clear();
+    this->readyN_AIs.clear();
+    this->runnerCount = 0;
+}
+
+size_t PendingRunnerQueues::size() const
+{
+    return this->runnerCount;
+}
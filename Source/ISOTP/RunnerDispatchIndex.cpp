@@ -0,0 +1,83 @@
+#include "RunnerDispatchIndex.h"
+
+uint32_t RunnerDispatchIndex::getDispatchKey(const N_AI& nAi)
+{
+    N_AI key;
+    key.N_AI          = 0;
+    key.N_NFA_Header  = nAi.N_NFA_Header;
+    key.N_NFA_Padding = nAi.N_NFA_Padding;
+    key.N_TAtype      = nAi.N_TAtype;
+    key.N_TA          = nAi.N_TA;
+    key.N_SA          = nAi.N_SA;
+    return key.N_AI;
+}
+
+N_USData_Runner*& RunnerDispatchIndex::getSlotEntry(Slot& slot, const N_USData_Runner::RunnerType runnerType)
+{
+    return runnerType == N_USData_Runner::RunnerRequestType ? slot.requestRunner : slot.indicationRunner;
+}
+
+bool RunnerDispatchIndex::insert(N_USData_Runner* runner)
+{
+    auto [it, inserted] = index.try_emplace(getDispatchKey(runner->getInboundN_AI()), Slot{nullptr, nullptr});
+
+    N_USData_Runner*& entry = getSlotEntry(it->second, runner->getRunnerType());
+    if (entry != nullptr)
+    {
+        return entry == runner;
+    }
+    entry = runner;
+    runnerCount++;
+    return true;
+}
+
+void RunnerDispatchIndex::erase(const N_USData_Runner* runner)
+{
+    const auto it = index.find(getDispatchKey(runner->getInboundN_AI()));
+    if (it == index.end())
+    {
+        return;
+    }
+
+    if (N_USData_Runner*& entry = getSlotEntry(it->second, runner->getRunnerType()); entry == runner)
+    {
+        entry = nullptr;
+        runnerCount--;
+    }
+
+    if (it->second.requestRunner == nullptr && it->second.indicationRunner == nullptr)
+    {
+        index.erase(it);
+    }
+}
+
+N_USData_Runner* RunnerDispatchIndex::find(const CANFrame& frame) const
+{
+    const auto it = index.find(getDispatchKey(frame.identifier));
+    if (it == index.end())
+    {
+        return nullptr;
+    }
+
+    // FCs are only received by request runners, any other frame is only received by indication runners.
+    const auto       frameCode = static_cast<N_USData_Runner::FrameCode>(frame.data[0] >> 4);
+    N_USData_Runner* runner =
+        frameCode == N_USData_Runner::FC_CODE ? it->second.requestRunner : it->second.indicationRunner;
+
+    if (runner != nullptr && runner->isThisFrameForMe(frame))
+    {
+        return runner;
+    }
+    return nullptr;
+}
+
+size_t RunnerDispatchIndex::size() const
+{
+    return runnerCount;
+}
+
+void RunnerDispatchIndex::clear()
+{
+    index.clear();
+    runnerCount = 0;
+}
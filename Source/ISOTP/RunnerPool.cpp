@@ -0,0 +1,160 @@
+#include "RunnerPool.h"
+
+RunnerPool::RunnerPool(bool& result, const size_t capacity, Atomic_int64_t& availableMemoryForRunners,
+                       OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue, MemoryArena* messageArena) :
+    idleRequestRunners(capacity), idleIndicationRunners(capacity)
+{
+    result = false;
+
+    this->capacity                  = capacity;
+    this->availableMemoryForRunners = &availableMemoryForRunners;
+    this->osInterface               = &osInterface;
+    this->canMessageACKQueue        = &canMessageACKQueue;
+    this->messageArena              = messageArena;
+
+    for (size_t i = 0; i < capacity; i++)
+    {
+        bool runnerCreated;
+        auto requestRunner = new N_USData_Request_Runner(runnerCreated, availableMemoryForRunners, osInterface,
+                                                         canMessageACKQueue, messageArena);
+        if (!runnerCreated)
+        {
+            OSInterfaceLogError(TAG, "Failed to create request runner %zu of %zu", i + 1, capacity);
+            delete requestRunner;
+            return;
+        }
+        this->idleRequestRunners.push(requestRunner);
+
+        auto indicationRunner = new N_USData_Indication_Runner(runnerCreated, availableMemoryForRunners, osInterface,
+                                                               canMessageACKQueue, messageArena);
+        if (!runnerCreated)
+        {
+            OSInterfaceLogError(TAG, "Failed to create indication runner %zu of %zu", i + 1, capacity);
+            delete indicationRunner;
+            return;
+        }
+        this->idleIndicationRunners.push(indicationRunner);
+    }
+
+    result = true;
+}
+
+RunnerPool::~RunnerPool()
+{
+    N_USData_Request_Runner* requestRunner;
+    while (this->idleRequestRunners.pop(requestRunner))
+    {
+        delete requestRunner;
+    }
+    N_USData_Indication_Runner* indicationRunner;
+    while (this->idleIndicationRunners.pop(indicationRunner))
+    {
+        delete indicationRunner;
+    }
+}
+
+template <typename T> T* RunnerPool::takeIdleRunner(BoundedMPMCQueue<T*>& idleRunners)
+{
+    T* runner;
+    if (!idleRunners.pop(runner))
+    {
+        OSInterfaceLogWarning(TAG, "All the %zu runners of the pool are in use", this->capacity);
+        return nullptr;
+    }
+    return runner;
+}
+
+template <typename T> void RunnerPool::putIdleRunner(BoundedMPMCQueue<T*>& idleRunners, T* runner)
+{
+    runner->release();
+    // Every runner comes from the pool, so it always has room for it.
+    if (!idleRunners.push(runner))
+    {
+        OSInterfaceLogError(TAG, "No room to give back a runner that does not come from the pool, deleting it");
+        delete runner;
+    }
+}
+
+N_USData_Request_Runner* RunnerPool::acquireRequestRunner(const N_AI nAi, const Mtype mType,
+                                                          const uint8_t* messageData, const uint32_t messageLength)
+{
+    N_USData_Request_Runner* runner = takeIdleRunner(this->idleRequestRunners);
+    if (runner != nullptr && !runner->reset(nAi, mType, messageData, messageLength))
+    {
+        putIdleRunner(this->idleRequestRunners, runner);
+        return nullptr;
+    }
+    return runner;
+}
+
+N_USData_Request_Runner* RunnerPool::acquireRequestRunner(const N_AI nAi, const Mtype mType,
+                                                          const uint8_t* messageData, const uint32_t messageLength,
+                                                          const N_USData_release_cb_t releaseCallback,
+                                                          void*                       releaseContext)
+{
+    const N_USData_Segment segment = {messageData, messageLength};
+    return acquireRequestRunner(nAi, mType, &segment, 1, releaseCallback, releaseContext);
+}
+
+N_USData_Request_Runner* RunnerPool::acquireRequestRunner(const N_AI nAi, const Mtype mType,
+                                                          const N_USData_Segment* segments, const uint8_t segmentCount,
+                                                          const N_USData_release_cb_t releaseCallback,
+                                                          void*                       releaseContext)
+{
+    N_USData_Request_Runner* runner = takeIdleRunner(this->idleRequestRunners);
+    if (runner != nullptr && !runner->reset(nAi, mType, segments, segmentCount, releaseCallback, releaseContext))
+    {
+        putIdleRunner(this->idleRequestRunners, runner);
+        return nullptr;
+    }
+    return runner;
+}
+
+N_USData_Request_Runner* RunnerPool::acquireRequestRunner(const N_AI nAi, const Mtype mType,
+                                                          const uint32_t             messageLength,
+                                                          const N_USData_source_cb_t source, void* sourceContext)
+{
+    N_USData_Request_Runner* runner = takeIdleRunner(this->idleRequestRunners);
+    if (runner != nullptr && !runner->reset(nAi, mType, messageLength, source, sourceContext))
+    {
+        putIdleRunner(this->idleRequestRunners, runner);
+        return nullptr;
+    }
+    return runner;
+}
+
+N_USData_Indication_Runner* RunnerPool::acquireIndicationRunner(const N_AI nAi, const uint8_t blockSize,
+                                                                const STmin                          stMin,
+                                                                const N_USData_ReceiveBufferProvider rxBufferProvider,
+                                                                const N_USData_StreamingSink         streamingSink)
+{
+    N_USData_Indication_Runner* runner = takeIdleRunner(this->idleIndicationRunners);
+    if (runner != nullptr && !runner->reset(nAi, blockSize, stMin, rxBufferProvider, streamingSink))
+    {
+        putIdleRunner(this->idleIndicationRunners, runner);
+        return nullptr;
+    }
+    return runner;
+}
+
+void RunnerPool::release(N_USData_Runner* runner)
+{
+    if (runner->getRunnerType() == N_USData_Runner::RunnerRequestType)
+    {
+        putIdleRunner(this->idleRequestRunners, static_cast<N_USData_Request_Runner*>(runner));
+    }
+    else
+    {
+        putIdleRunner(this->idleIndicationRunners, static_cast<N_USData_Indication_Runner*>(runner));
+    }
+}
+
+size_t RunnerPool::getIdleRequestRunners() const
+{
+    return this->idleRequestRunners.size();
+}
+
+size_t RunnerPool::getIdleIndicationRunners() const
+{
+    return this->idleIndicationRunners.size();
+}
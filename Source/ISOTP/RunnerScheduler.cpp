@@ -0,0 +1,94 @@
+#include "RunnerScheduler.h"
+
+#include <algorithm>
+
+// Stale entries are tolerated up to this many on top of the valid ones before the heap is rebuilt.
+constexpr size_t RunnerScheduler_MaxStaleEntries = 64;
+
+bool RunnerScheduler::isLater(const Entry& a, const Entry& b)
+{
+    // Used as the heap comparator, so the earliest deadline ends on top. Ties go to the oldest entry.
+    return a.deadline != b.deadline ? a.deadline > b.deadline : a.sequence > b.sequence;
+}
+
+bool RunnerScheduler::isStale(const Entry& entry) const
+{
+    const auto it = scheduledSequences.find(entry.runner);
+    return it == scheduledSequences.end() || it->second != entry.sequence;
+}
+
+void RunnerScheduler::schedule(N_USData_Runner* runner, const uint32_t deadline)
+{
+    const uint64_t sequence    = nextSequence++;
+    scheduledSequences[runner] = sequence;
+
+    heap.push_back({deadline, sequence, runner});
+    std::push_heap(heap.begin(), heap.end(), isLater);
+
+    if (heap.size() > 2 * scheduledSequences.size() + RunnerScheduler_MaxStaleEntries)
+    {
+        compact();
+    }
+}
+
+void RunnerScheduler::remove(const N_USData_Runner* runner)
+{
+    scheduledSequences.erase(runner);
+}
+
+N_USData_Runner* RunnerScheduler::popDue(const uint32_t now)
+{
+    discardStaleTop();
+    if (heap.empty() || now <= heap.front().deadline)
+    {
+        return nullptr;
+    }
+
+    N_USData_Runner* runner = heap.front().runner;
+    std::pop_heap(heap.begin(), heap.end(), isLater);
+    heap.pop_back();
+    scheduledSequences.erase(runner);
+    return runner;
+}
+
+bool RunnerScheduler::getNextDeadline(uint32_t& deadline)
+{
+    discardStaleTop();
+    if (heap.empty())
+    {
+        return false;
+    }
+    deadline = heap.front().deadline;
+    return true;
+}
+
+bool RunnerScheduler::isScheduled(const N_USData_Runner* runner) const
+{
+    return scheduledSequences.contains(runner);
+}
+
+size_t RunnerScheduler::size() const
+{
+    return scheduledSequences.size();
+}
+
+void RunnerScheduler::clear()
+{
+    heap.clear();
+    scheduledSequences.clear();
+}
+
+void RunnerScheduler::discardStaleTop()
+{
+    while (!heap.empty() && isStale(heap.front()))
+    {
+        std::pop_heap(heap.begin(), heap.end(), isLater);
+        heap.pop_back();
+    }
+}
+
+void RunnerScheduler::compact()
+{
+    std::erase_if(heap, [this](const Entry& entry) { return isStale(entry); });
+    std::make_heap(heap.begin(), heap.end(), isLater);
+}
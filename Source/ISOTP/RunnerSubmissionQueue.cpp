@@ -0,0 +1,21 @@
+#include "RunnerSubmissionQueue.h"
+
+RunnerSubmissionQueue::RunnerSubmissionQueue(const size_t capacity) : queue(capacity)
+{
+}
+
+bool RunnerSubmissionQueue::push(N_USData_Runner* runner)
+{
+    return this->queue.push(runner);
+}
+
+N_USData_Runner* RunnerSubmissionQueue::pop()
+{
+    N_USData_Runner* runner = nullptr;
+    return this->queue.pop(runner) ? runner : nullptr;
+}
+
+size_t RunnerSubmissionQueue::capacity() const
+{
+    return this->queue.capacity();
+}
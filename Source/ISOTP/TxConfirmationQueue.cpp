@@ -0,0 +1,27 @@
+#include "TxConfirmationQueue.h"
+
+TxConfirmationQueue::TxConfirmationQueue(const size_t capacity) : queue(capacity)
+{
+}
+
+bool TxConfirmationQueue::push(const CANInterface::TxToken token, const CANInterface::ACKResult ack)
+{
+    return this->queue.push({token, ack});
+}
+
+bool TxConfirmationQueue::pop(CANInterface::TxToken& token, CANInterface::ACKResult& ack)
+{
+    TxConfirmation confirmation{};
+    if (!this->queue.pop(confirmation))
+    {
+        return false;
+    }
+    token = confirmation.token;
+    ack   = confirmation.ack;
+    return true;
+}
+
+size_t TxConfirmationQueue::capacity() const
+{
+    return this->queue.capacity();
+}
@@ -0,0 +1,74 @@
+#include "WakeupSignal.h"
+
+#include "ISOTP_Common.h"
+
+WakeupSignal::WakeupSignal(OSInterface& osInterface) : osInterface(osInterface)
+{
+    this->semaphore.store(nullptr);
+    this->pending.store(false);
+}
+
+WakeupSignal::~WakeupSignal()
+{
+    delete this->semaphore.load();
+}
+
+bool WakeupSignal::setSemaphore(ThreadInterface& threadInterface)
+{
+    if (this->semaphore.load() != nullptr)
+    {
+        return true;
+    }
+    ThreadInterface_Semaphore* created = threadInterface.createSemaphore();
+    if (created == nullptr)
+    {
+        return false;
+    }
+    this->semaphore.store(created);
+
+    // A notification made before the store did not give it.
+    if (this->pending.load())
+    {
+        created->signal();
+    }
+    return true;
+}
+
+void WakeupSignal::notify()
+{
+    // Only the notification that sets the flag gives the semaphore, the waiter has not taken it yet otherwise.
+    if (!this->pending.exchange(true))
+    {
+        if (ThreadInterface_Semaphore* sem = this->semaphore.load(); sem != nullptr)
+        {
+            sem->signal();
+        }
+    }
+}
+
+bool WakeupSignal::wait(const uint32_t timeoutMs)
+{
+    if (ThreadInterface_Semaphore* sem = this->semaphore.load(); sem != nullptr)
+    {
+        if (!sem->wait(timeoutMs))
+        {
+            return false;
+        }
+        // The notifications made until the flag is cleared are consumed here, and the exchange makes their work
+        // visible to the caller.
+        this->pending.exchange(false);
+        return true;
+    }
+
+    const uint32_t start = this->osInterface.osMillis();
+    while (!this->pending.exchange(false))
+    {
+        const uint32_t elapsed = this->osInterface.osMillis() - start;
+        if (elapsed >= timeoutMs)
+        {
+            return false;
+        }
+        this->osInterface.osSleep(MIN(WakeupSignal_PollPeriod_MS, timeoutMs - elapsed));
+    }
+    return true;
+}
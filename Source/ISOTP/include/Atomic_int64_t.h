@@ -1,11 +1,21 @@
 #ifndef ATOMIC_UINT32_H
 #define ATOMIC_UINT32_H
 
+#include <atomic>
 #include <cstdint>
 #include "OSInterface.h"
 
 constexpr uint32_t DEFAULT_Atomic_int64_t_TIMEOUT = 100;
 
+// Platforms with lock-free 64-bit atomics do not need the mutex (and never time out). Can be forced from the build.
+#ifndef ATOMIC_INT64_T_LOCK_FREE
+#if ATOMIC_LLONG_LOCK_FREE == 2
+#define ATOMIC_INT64_T_LOCK_FREE 1
+#else
+#define ATOMIC_INT64_T_LOCK_FREE 0
+#endif
+#endif
+
 class Atomic_int64_t
 {
 public:
@@ -18,9 +28,14 @@ public:
     bool subIfResIsGreaterThanZero(int64_t amount, uint32_t timeout = DEFAULT_Atomic_int64_t_TIMEOUT);
 
 private:
+#if ATOMIC_INT64_T_LOCK_FREE
+    std::atomic<int64_t> internalValue;
+    OSInterface*         osInterface;
+#else
     int64_t            internalValue;
     OSInterface*       osInterface;
     OSInterface_Mutex* mutex;
+#endif
 };
 
 #endif // ATOMIC_UINT32_H
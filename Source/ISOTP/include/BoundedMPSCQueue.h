@@ -0,0 +1,134 @@
+#ifndef BOUNDEDMPSCQUEUE_H
+#define BOUNDEDMPSCQUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+/**
+ * Bounded lock-free multi-producer/single-consumer queue of values of type T.
+ *
+ * It is a ring of cells, each one with a sequence number that tells whether it is free for the producer of a given
+ * position or filled for the consumer of that position. Producers claim a position with a single compare-and-swap and
+ * never wait for each other or for the consumer: a full queue makes push() fail instead of blocking.
+ *
+ * @tparam T The type of the queued values. It is copied in and out of the cells, so it should be small and trivially
+ * copyable.
+ */
+template <typename T>
+class BoundedMPSCQueue
+{
+public:
+    /**
+     * @brief Creates an empty queue.
+     * @param capacity The maximum number of queued values. It is rounded up to a power of two.
+     */
+    explicit BoundedMPSCQueue(size_t capacity);
+
+    BoundedMPSCQueue(const BoundedMPSCQueue&)            = delete;
+    BoundedMPSCQueue& operator=(const BoundedMPSCQueue&) = delete;
+
+    /**
+     * @brief Adds a value to the queue. Can be called from any thread.
+     * @param value The value to add.
+     * @return True if the value was added, false if the queue is full.
+     */
+    bool push(const T& value);
+
+    /**
+     * @brief Removes the oldest value from the queue. Must only be called from one thread at a time.
+     * @param value Set to the oldest value.
+     * @return True if a value was removed, false if the queue is empty.
+     */
+    [[nodiscard]] bool pop(T& value);
+
+    [[nodiscard]] size_t capacity() const;
+
+private:
+    using Cell = struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T                   value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t                  mask;
+    // Producers and the consumer update different positions, keep them in different cache lines.
+    alignas(64) std::atomic<size_t> pushPosition;
+    alignas(64) size_t popPosition;
+};
+
+template <typename T>
+BoundedMPSCQueue<T>::BoundedMPSCQueue(const size_t capacity)
+{
+    const size_t size = std::bit_ceil(capacity < 2 ? 2 : capacity);
+    this->cells       = std::make_unique<Cell[]>(size);
+    this->mask        = size - 1;
+    for (size_t i = 0; i < size; i++)
+    {
+        this->cells[i].sequence.store(i, std::memory_order_relaxed);
+        this->cells[i].value = T{};
+    }
+    this->pushPosition.store(0, std::memory_order_relaxed);
+    this->popPosition = 0;
+}
+
+template <typename T>
+bool BoundedMPSCQueue<T>::push(const T& value)
+{
+    size_t position = this->pushPosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Cell&           cell     = this->cells[position & this->mask];
+        const size_t    sequence = cell.sequence.load(std::memory_order_acquire);
+        const ptrdiff_t diff     = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+        if (diff == 0)
+        {
+            // The cell is free for this position, claim it (on failure, position is updated to the current one).
+            if (this->pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.value = value;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false; // The consumer has not freed the cell of the previous lap yet: the queue is full.
+        }
+        else
+        {
+            position = this->pushPosition.load(std::memory_order_relaxed); // Another producer claimed it.
+        }
+    }
+}
+
+template <typename T>
+bool BoundedMPSCQueue<T>::pop(T& value)
+{
+    Cell&           cell     = this->cells[this->popPosition & this->mask];
+    const size_t    sequence = cell.sequence.load(std::memory_order_acquire);
+    const ptrdiff_t diff     = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(this->popPosition + 1);
+
+    if (diff < 0)
+    {
+        return false; // Empty, or the producer of this position has not finished writing it yet.
+    }
+
+    value      = cell.value;
+    cell.value = T{};
+    // Free the cell for the producer of the next lap.
+    cell.sequence.store(this->popPosition + this->mask + 1, std::memory_order_release);
+    this->popPosition++;
+    return true;
+}
+
+template <typename T>
+size_t BoundedMPSCQueue<T>::capacity() const
+{
+    return this->mask + 1;
+}
+
+#endif // BOUNDEDMPSCQUEUE_H
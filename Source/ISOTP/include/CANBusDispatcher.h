@@ -0,0 +1,115 @@
+#ifndef CANBUSDISPATCHER_H
+#define CANBUSDISPATCHER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include "CANInterface.h"
+#include "OSInterface.h"
+
+constexpr size_t CANBusDispatcher_MaxQueuedFrames     = 64; // Frames kept for a connection that is not read.
+constexpr size_t CANBusDispatcher_PendingAcksCapacity = 64; // Frames written and still waiting for their ACK.
+
+/**
+ * Shares one CANInterface between several ISOTP instances, each with its own N_SA.
+ *
+ * Each instance gets a virtual CANInterface from getCANInterface(). The frames read from the bus are routed to the
+ * connection of their N_TA through a 256-entry table (functional frames are given to every connection), so every
+ * frame is read once and no instance steals the frames of another one. The frames written through a connection go to
+ * the shared bus, and their ACKs are given back to the connection that wrote them, matched by the TX token of the
+ * shared CANInterface (so drivers that confirm out of order are supported).
+ *
+ * The bus is read when a connection asks for frames or ACKs, so the instances drive it as they would drive their own
+ * CANInterface, from one or several threads.
+ *
+ * @note The frames written by a connection are not looped back to the other connections of the same dispatcher.
+ * @note The tokens of the frames waiting for their ACK must be different modulo CANBusDispatcher_PendingAcksCapacity
+ * (see CANMessageACKQueue).
+ */
+class CANBusDispatcher
+{
+public:
+    /**
+     * @param canInterface The shared CANInterface. It must outlive the dispatcher, which registers its wakeup callback
+     * (unless another user already did) and unregisters it when destroyed.
+     * @param osInterface The OSInterface used to create the mutex of the dispatcher.
+     * @param tag The tag used for logging.
+     */
+    CANBusDispatcher(CANInterface& canInterface, OSInterface& osInterface, const char* tag = TAG);
+
+    ~CANBusDispatcher();
+
+    CANBusDispatcher(const CANBusDispatcher&)            = delete;
+    CANBusDispatcher& operator=(const CANBusDispatcher&) = delete;
+
+    /**
+     * @brief Returns the virtual CANInterface of the ISOTP instance with the given N_SA, creating it on the first call.
+     * It is owned by the dispatcher and valid until the dispatcher is deleted.
+     * @param nSA The N_SA of the ISOTP instance, the physical frames with it as N_TA are routed to this connection.
+     * @return The virtual CANInterface, or nullptr if the dispatcher could not be locked.
+     */
+    CANInterface* getCANInterface(typeof(N_AI::N_SA) nSA);
+
+    constexpr static const char* TAG = "ISOTP-CANBusDispatcher";
+
+private:
+    class Connection : public CANInterface
+    {
+    public:
+        explicit Connection(CANBusDispatcher& dispatcher);
+
+        uint32_t  frameAvailable() override;
+        bool      readFrame(CANFrame* frame) override;
+        bool      writeFrame(CANFrame* frame) override;
+        bool      active() override;
+        ACKResult getWriteFrameACK() override;
+        bool      writeFrameWithToken(CANFrame* frame, TxToken& token) override;
+        ACKResult getWriteFrameACKWithToken(TxToken& token) override;
+
+        void wakeup() const;
+        bool confirm(TxToken token, ACKResult ack) const;
+
+    private:
+        friend class CANBusDispatcher;
+
+        [[nodiscard]] bool lock() const;
+        void               unlock() const;
+
+        CANBusDispatcher*                         dispatcher;
+        std::deque<CANFrame>                      frames; // Guarded by dispatcher->mutex.
+        std::deque<std::pair<TxToken, ACKResult>> acks;   // Guarded by dispatcher->mutex.
+    };
+
+    /**
+     * @brief Reads the frames and ACKs available in the bus and gives them to their connections.
+     * @note mutex must be held.
+     */
+    void pump();
+
+    using PendingAck = struct PendingAck
+    {
+        Connection*           connection; // nullptr if the slot is free.
+        CANInterface::TxToken token;
+    };
+
+    PendingAck& slotOf(CANInterface::TxToken token);
+
+    void route(const CANFrame& frame);
+    void deliver(Connection& connection, const CANFrame& frame) const;
+
+    static void wakeupCallback(void* context);
+
+    const char*   tag;
+    CANInterface* canInterface;
+
+    // Written once per N_SA, read without the mutex by wakeupCallback(), which the driver may call while the mutex is
+    // held (e.g. from writeFrame()).
+    std::array<std::atomic<Connection*>, 256> connections{};
+
+    OSInterface_Mutex*                                           mutex;
+    std::array<PendingAck, CANBusDispatcher_PendingAcksCapacity> pendingAcks; // Indexed by token % capacity.
+};
+
+#endif // CANBUSDISPATCHER_H
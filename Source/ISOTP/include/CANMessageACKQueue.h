@@ -1,36 +1,102 @@
 #ifndef CANMESSAGEACKQUEUE_H
 #define CANMESSAGEACKQUEUE_H
 
-#include <list>
+#include <array>
+#include <cstddef>
+#include <vector>
 #include "CANInterface.h"
 #include "OSInterface.h"
+#include "TxConfirmationQueue.h"
 
 class N_USData_Runner;
 
+constexpr size_t CANMessageACKQueue_Capacity = 64; // Frames written and still waiting for their ACK callback.
+
+/**
+ * Matches the ACKs of the written frames to the runners that wrote them.
+ *
+ * The frames are written with CANInterface::writeFrameWithToken() and stored in a fixed-capacity table indexed by their
+ * token, so an ACK finds its frame in O(1) whatever the order the driver confirms them in. The ACKed tokens are kept in
+ * a ring in ACK order, and their callbacks are run in that order.
+ *
+ * The ACKs pushed by the CANInterface (see CANInterface::setTxConfirmationCallback()) are queued without locking and
+ * stored with the polled ones, so a runner gets its ACK in the next runAvailableAckCallbacks() after the driver
+ * confirms the frame, without waiting for runStep().
+ *
+ * @note The tokens of the frames waiting for their ACK must be different modulo CANMessageACKQueue_Capacity. It is the
+ * case for the default tokens of CANInterface, and for drivers that use the index of a TX mailbox as token.
+ */
 class CANMessageACKQueue
 {
 public:
     explicit CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag = TAG);
     ~CANMessageACKQueue();
 
-    void runStep();
+    /**
+     * @brief Stores the ACKs pushed by the CANInterface and polls it for the rest, for their runners.
+     * @return True if an ACK was received, false otherwise.
+     */
+    bool runStep();
+
+    /**
+     * @brief Tells whether some written frames are still waiting for their ACK, so the CANInterface must be polled.
+     * @return True if a frame is waiting for its ACK, false otherwise (or if the mutex could not be acquired).
+     */
+    [[nodiscard]] bool waitingForAcks() const;
 
     void runAvailableAckCallbacks();
 
+    /**
+     * @brief Runs the available ACK callbacks and reports which runners received one.
+     * @param ackedRunners The runners whose ACK callback has run are appended to it, in order.
+     */
+    void runAvailableAckCallbacks(std::vector<N_USData_Runner*>& ackedRunners);
+
+    /**
+     * @brief Writes a frame and stores its runner until the ACK of the frame is received.
+     * @return True if the frame was written, false if the queue is full or the CANInterface did not write it.
+     */
     bool writeFrame(N_USData_Runner& runner, CANFrame& frame);
 
     bool removeFromQueue(N_AI runnerNAi);
 
+    /**
+     * @brief Forgets the frames of a runner that are waiting for their ACK, freeing their slots. It must be called
+     * before the runner is reused or deleted, even if the ACKs of its frames never arrive (e.g. the bus went inactive).
+     * The frames of other runners with the same N_AI are kept.
+     * @return True if frames of the runner were waiting for their ACK, false otherwise.
+     */
+    bool removeFromQueue(const N_USData_Runner& runner);
+
     constexpr static const char* TAG = "ISOTP-CANMessageACKQueue";
 
 private:
-    bool runNextAvailableAckCallback();
-    void saveAck(CANInterface::ACKResult ack);
+    using PendingFrame = struct PendingFrame
+    {
+        N_USData_Runner*        runner; // nullptr if the slot is free.
+        CANInterface::TxToken   token;
+        CANInterface::ACKResult ack;
+    };
+
+    N_USData_Runner* runNextAvailableAckCallback();
+    void             saveAck(CANInterface::TxToken token, CANInterface::ACKResult ack);
+    PendingFrame&    slotOf(CANInterface::TxToken token);
+    bool             storePushedAcks();
+
+    // Frees the slots of the pending frames whose runner isRemoved. False if the mutex could not be acquired.
+    template <typename Predicate> bool removeFrames(Predicate isRemoved, size_t& removed);
+
+    static bool txConfirmationCallback(void* context, CANInterface::TxToken token, CANInterface::ACKResult ack);
 
-    const char*                                                     tag;
-    OSInterface_Mutex*                                              mutex;
-    std::list<std::pair<N_USData_Runner*, CANInterface::ACKResult>> messageQueue;
-    CANInterface*                                                   canInterface;
+    const char*                                                    tag;
+    OSInterface_Mutex*                                             mutex;
+    std::array<PendingFrame, CANMessageACKQueue_Capacity>          pendingFrames; // Indexed by token % capacity.
+    size_t                                                         pendingCount;
+    std::array<CANInterface::TxToken, CANMessageACKQueue_Capacity> ackedTokens; // Ring of the ACKed tokens, in order.
+    size_t                                                         ackedHead;
+    size_t                                                         ackedCount;
+    TxConfirmationQueue                                            pushedAcks; // Filled by txConfirmationCallback.
+    CANInterface*                                                  canInterface;
 };
 
 #endif // CANMESSAGEACKQUEUE_H
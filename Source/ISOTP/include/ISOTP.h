@@ -1,14 +1,24 @@
 #ifndef ISOTP_H
 #define ISOTP_H
 
+#include <atomic>
+#include <bitset>
 #include <list>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
 #include "ISOTP_Common.h"
+#include "MemoryArena.h"
 #include "N_USData_Runner.h"
+#include "PendingRunnerQueues.h"
+#include "RunnerDispatchIndex.h"
+#include "RunnerPool.h"
+#include "RunnerScheduler.h"
+#include "RunnerSubmissionQueue.h"
+#include "ThreadInterface.h"
+#include "WakeupSignal.h"
 
 #define ISOTP_N_AI_CONFIG(_N_TAtype, _N_TA, _N_SA)                                                                     \
     {.N_NFA_Header = 0b110, .N_NFA_Padding = 0b00, .N_TAtype = (_N_TAtype), .N_TA = (_N_TA), .N_SA = (_N_SA)}
@@ -18,6 +28,24 @@ constexpr uint32_t ISOTP_RunPeriod_MS                   = 0;
 constexpr uint32_t ISOTP_RunPeriod_ACKQueue_MS          = 0;
 constexpr STmin    ISOTP_DefaultSTmin                   = {20, ms};
 constexpr uint8_t  ISOTP_DefaultBlockSize               = 0; // 0 means that all CFs are sent without waiting for an FC.
+constexpr uint32_t ISOTP_DefaultMaxFramesPerStep        = 16; // 0 means all the frames available when the step starts.
+constexpr uint32_t ISOTP_MaxWaitForWork_MS              = 100; // So CANInterfaces that never notify are still polled.
+constexpr uint32_t ISOTP_AckPollPeriod_MS               = 1; // Of the TX worker while frames wait for their ACK.
+constexpr size_t   ISOTP_SubmissionQueueCapacity        = 64; // Requests not yet taken by the run loop.
+constexpr size_t   ISOTP_DefaultRunnerPoolCapacity      = ISOTP_SubmissionQueueCapacity; // Runners of each type.
+
+/**
+ * Configuration of the worker threads started by ISOTP::start().
+ * The priorities are given as is to ThreadInterface::createThread(): 0 keeps the default of the platform.
+ */
+using ISOTP_WorkersConfig = struct ISOTP_WorkersConfig
+{
+    int rxPriority;       // Priority of the thread that reads the frames and runs the runners.
+    int txPriority;       // Priority of the thread that polls the ACKs of the written frames.
+    int callbackPriority; // Priority of the thread that runs the user callbacks.
+};
+
+constexpr ISOTP_WorkersConfig ISOTP_DefaultWorkersConfig = {.rxPriority = 0, .txPriority = 0, .callbackPriority = 0};
 
 /**
  * This function is used to confirm the sending of a message.
@@ -29,7 +57,10 @@ using N_USData_confirm_cb_t = void (*)(N_AI nAi, N_Result nResult, Mtype mtype);
 
 /**
  * This function is used to indicate the reception of a message.
- * @warning The messageData is only valid during the callback, if you need to keep the data, copy it elsewhere.
+ * @warning The messageData is only valid during the callback, if you need to keep the data, copy it elsewhere. If it
+ * is a buffer of the application (see ISOTP::setReceiveBufferProvider()), it is given back right after the callback
+ * instead, so it can be kept without a copy. For a streamed message (see ISOTP::setStreamingSink()), it is the
+ * completion of the reception: messageData is nullptr, as the data was already given to the sink.
  * @param nAi The N_AI of the message.
  * @param messageData The message data of the message.
  * @param messageLength The length of the message data.
@@ -62,37 +93,239 @@ public:
      * The message will be sent as soon as possible, but there is no guarantee on the timing.
      * @note If the request is issued to an N_AI that is currently being processed, the message will be queued and
      * processed once the conflicting message is processed.
+     * @note Each request uses a runner of the pool until it is confirmed, so at most runnerPoolCapacity requests (see
+     * the constructor, ISOTP_DefaultRunnerPoolCapacity by default) can be queued or in progress at once.
      * @param nTa The N_TA to send the message to.
      * @param nTaType The N_TAtype of the N_TA.
      * @param messageData The message data to send.
      * @param length The length of the message data.
      * @param mType The Mtype of the message.
      *
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message, for example
+     * because all the runners of the pool are in use.
+     */
+    bool N_USData_request(typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType, const uint8_t* messageData, uint32_t length,
+                          Mtype mType = Mtype_Diagnostics);
+
+    /**
+     * This function is used to queue a message to be sent to an N_TA from one of the physical N_SAs accepted by the
+     * current ISOTP object (see addAcceptedPhysicalN_SA()).
+     * @param nSa The N_SA to send the message from. It must be an accepted physical N_SA, so the Flow Control frames of
+     * the receiver reach this object.
+     * @param nTa The N_TA to send the message to.
+     * @param nTaType The N_TAtype of the N_TA.
+     * @param messageData The message data to send.
+     * @param length The length of the message data.
+     * @param mType The Mtype of the message.
+     * @note As for the overload without nSa, at most runnerPoolCapacity requests can be queued or in progress at once.
+     *
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message, for example
+     * because all the runners of the pool are in use.
+     */
+    bool N_USData_request(typeof(N_AI::N_SA) nSa, typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType,
+                          const uint8_t* messageData, uint32_t length, Mtype mType = Mtype_Diagnostics);
+
+    /**
+     * This function is used to queue a message to be sent to an N_TA from the current ISOTP object N_SA without copying
+     * it (see the overload with nSa below).
      * @returns true if the request was queued successfully and false if it failed to enqueue the message.
      */
     bool N_USData_request(typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType, const uint8_t* messageData, uint32_t length,
+                          N_USData_release_cb_t releaseCallback, void* releaseContext, Mtype mType = Mtype_Diagnostics);
+
+    /**
+     * This function is used to queue a message to be sent without copying it: the caller lends the buffer until
+     * releaseCallback is called, after N_USData_confirm_cb. Lending a buffer only to free it in releaseCallback
+     * transfers its ownership.
+     * The message does not use the memory given to the constructor for the runners.
+     * @param nSa The N_SA to send the message from. It must be an accepted physical N_SA.
+     * @param nTa The N_TA to send the message to.
+     * @param nTaType The N_TAtype of the N_TA.
+     * @param messageData The message data to send. It must not be modified until releaseCallback is called.
+     * @param length The length of the message data.
+     * @param releaseCallback The function called (from the thread running the callbacks) when the buffer is not used
+     * anymore.
+     * @param releaseContext The context passed to releaseCallback.
+     * @param mType The Mtype of the message.
+     *
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message. If it
+     * returns false, releaseCallback is not called and the caller keeps the buffer.
+     */
+    bool N_USData_request(typeof(N_AI::N_SA) nSa, typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType,
+                          const uint8_t* messageData, uint32_t length, N_USData_release_cb_t releaseCallback,
+                          void* releaseContext, Mtype mType = Mtype_Diagnostics);
+
+    /**
+     * This function is used to queue a message made of several segments (e.g. a header and its payload blocks) to be
+     * sent to an N_TA from the current ISOTP object N_SA, without copying them (see the overload with nSa below).
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message.
+     */
+    bool N_USData_request(typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType, const N_USData_Segment* segments,
+                          uint8_t segmentCount, N_USData_release_cb_t releaseCallback, void* releaseContext,
                           Mtype mType = Mtype_Diagnostics);
 
+    /**
+     * This function is used to queue a message made of several segments (e.g. a header and its payload blocks) to be
+     * sent without copying them: the frames are packed straight from the segments, across their boundaries.
+     * The segment list itself is copied, but the caller lends the data of the segments until releaseCallback is
+     * called, after N_USData_confirm_cb, with the first segment as messageData.
+     * The message does not use the memory given to the constructor for the runners.
+     * @param nSa The N_SA to send the message from. It must be an accepted physical N_SA.
+     * @param nTa The N_TA to send the message to.
+     * @param nTaType The N_TAtype of the N_TA.
+     * @param segments The segments of the message, in order. They must not be modified until releaseCallback is called.
+     * @param segmentCount The number of segments, from 1 to ISOTP_MaxMessageSegments.
+     * @param releaseCallback The function called (from the thread running the callbacks) when the segments are not used
+     * anymore.
+     * @param releaseContext The context passed to releaseCallback.
+     * @param mType The Mtype of the message.
+     *
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message. If it
+     * returns false, releaseCallback is not called and the caller keeps the segments.
+     */
+    bool N_USData_request(typeof(N_AI::N_SA) nSa, typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType,
+                          const N_USData_Segment* segments, uint8_t segmentCount, N_USData_release_cb_t releaseCallback,
+                          void* releaseContext, Mtype mType = Mtype_Diagnostics);
+
+    /**
+     * This function is used to queue a message pulled from a data source to be sent to an N_TA from the current ISOTP
+     * object N_SA (see the overload with nSa below).
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message.
+     */
+    bool N_USData_request(typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType, uint32_t length, N_USData_source_cb_t source,
+                          void* sourceContext, Mtype mType = Mtype_Diagnostics);
+
+    /**
+     * This function is used to queue a message whose bytes are produced on demand (read from flash, decompressed...):
+     * the bytes of each frame are pulled from source right before the frame is sent, so the message is never held in
+     * memory and does not use the memory given to the constructor.
+     * source is called from the thread running runStep(), and sourceContext must stay valid until
+     * N_USData_confirm_cb is called for the message.
+     * @param nSa The N_SA to send the message from. It must be an accepted physical N_SA.
+     * @param nTa The N_TA to send the message to.
+     * @param nTaType The N_TAtype of the N_TA.
+     * @param length The length of the message, known up front.
+     * @param source The function that writes the next bytes of the message. If it fails, the transmission is aborted
+     * and N_USData_confirm_cb is called with N_ERROR.
+     * @param sourceContext The context passed to source.
+     * @param mType The Mtype of the message.
+     * @note As for the overload without nSa, at most runnerPoolCapacity requests can be queued or in progress at once.
+     *
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message, for example
+     * because all the runners of the pool are in use.
+     */
+    bool N_USData_request(typeof(N_AI::N_SA) nSa, typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType, uint32_t length,
+                          N_USData_source_cb_t source, void* sourceContext, Mtype mType = Mtype_Diagnostics);
+
     /**
      * This function is used to run the DoCAN service.
      * It needs to be called periodically to allow the DoCAN service to run.
      * There are no limitations on the frequency of this function, timing is handled internally.
+     * @return The time in ms until the next internal deadline (timeouts, STmin...), or 0 if there is work pending right
+     * now. It is never greater than ISOTP_MaxWaitForWork_MS, so it can be passed directly to waitForWork().
      */
-    void runStep();
+    uint32_t runStep();
+
+    /**
+     * This function is used to sleep until there is work for the DoCAN service: the CANInterface notifies a received
+     * frame or an ACK, a message is queued with N_USData_request(), or wakeup() is called.
+     * It sleeps on a semaphore of the ThreadInterface given with setThreadInterface() or start(). Without one, it
+     * checks for work every WakeupSignal_PollPeriod_MS.
+     * @param timeoutMs The maximum time to sleep, usually the value returned by runStep(). It is capped to
+     * ISOTP_MaxWaitForWork_MS so CANInterfaces that do not notify are still polled.
+     * @return True if it was woken up by an event, false if the timeout expired.
+     */
+    bool waitForWork(uint32_t timeoutMs);
+
+    /**
+     * This function is used to give the semaphores of the platform to waitForWork() and the worker threads, so they
+     * sleep until they are woken up. start() calls it.
+     * @warning It must not be called while a thread is in waitForWork() or runUntil().
+     * @param threadInterface The ThreadInterface the semaphores are created with.
+     * @return True if the semaphores were created, false otherwise.
+     */
+    bool setThreadInterface(ThreadInterface& threadInterface);
+
+    /**
+     * This function is used to run the DoCAN service (both runStep() and the ACK queue) until a deadline, sleeping
+     * with waitForWork() while there is nothing to do.
+     * @param deadline The timestamp to return at, derived from OSInterface::osMillis().
+     */
+    void runUntil(uint32_t deadline);
+
+    /**
+     * This function is used to wake up a thread sleeping in waitForWork(). It can be called from any thread.
+     */
+    void wakeup();
+
+    /**
+     * This function is used to run the DoCAN service in its own worker threads, instead of calling runStep() and
+     * canMessageACKQueueRunStep() periodically:
+     * - The RX worker reads and dispatches the frames and runs the runners, sleeping with waitForWork() in between.
+     * - The TX worker is the only one that polls the ACKs of the written frames, every ISOTP_AckPollPeriod_MS while
+     *   some are missing. It wakes up the RX worker to run their runners. The ACKs pushed by the CANInterface do not
+     *   wait for it.
+     * - The callback worker calls N_USData_confirm_cb and N_USData_indication_cb, so slow callbacks delay neither the
+     *   frame handling nor the ACKs (N_USData_FF_indication_cb is still called by the RX worker).
+     * @note While the workers are running, runStep(), runUntil() and canMessageACKQueueRunStep() must not be called,
+     * and runStep() does not poll the ACKs even if setPollAcksInRunStep() was set.
+     * @param threadInterface The threads of the platform the workers are created with.
+     * @param config The priorities of the worker threads.
+     * @return True if the workers were started, false if they were already running, or they or their semaphores could
+     * not be created.
+     */
+    bool start(ThreadInterface& threadInterface, ISOTP_WorkersConfig config = ISOTP_DefaultWorkersConfig);
+
+    /**
+     * This function is used to stop the worker threads started by start(). It waits for them to finish, and calls the
+     * callbacks of the runners that already finished before returning. It does nothing if the workers are not running.
+     */
+    void stop();
+
+    /**
+     * This function is used to check if the worker threads started by start() are running.
+     * @return True if the workers are running, false otherwise.
+     */
+    bool isStarted() const;
 
     /**
      * This function is used to run the DoCAN service.
-     * It needs to be called periodically to allow the DoCAN service to run.
-     * There are no limitations on the frequency of this function, timing is handled internally.
+     * It needs to be called periodically to allow the DoCAN service to run, unless the ACKs are polled by runStep()
+     * (see setPollAcksInRunStep()).
+     * There are no limitations on the frequency of this function, timing is handled internally (per ISOTP object).
      */
-    void canMessageACKQueueRunStep() const;
+    void canMessageACKQueueRunStep();
 
     /**
-     * This function is used to get the N_SA for this ISOTP object.
+     * This function is used to get the N_SA for this ISOTP object, the one given to the constructor. It is the N_SA
+     * of the requests that do not choose one.
      * @return The N_SA for this ISOTP object.
      */
     typeof(N_AI::N_SA) getN_SA() const;
 
+    /**
+     * This function is used to add a N_SA into the physical accepted N_SAs for this ISOTP object.
+     * From this point on, the physical messages with this N_TA are received by this object, and messages can be sent
+     * from it with N_USData_request(). The N_SA given to the constructor is always accepted.
+     * @param nSA The N_SA to add for this ISOTP object.
+     */
+    void addAcceptedPhysicalN_SA(typeof(N_AI::N_SA) nSA);
+
+    /**
+     * This function is used to remove a N_SA from the physical accepted N_SAs for this ISOTP object.
+     * Messages that are being received or sent with this N_SA are not affected, but their later frames are discarded.
+     * @param nSA The N_SA to remove for this ISOTP object.
+     * @return True if the N_SA was removed, false if it was not accepted or it is the N_SA given to the constructor.
+     */
+    bool removeAcceptedPhysicalN_SA(typeof(N_AI::N_SA) nSA);
+
+    /**
+     * This function is used to check if a N_SA is in the physical accepted N_SAs for this ISOTP object.
+     * @param nSA The N_SA to check for in this ISOTP object.
+     * @return True if the N_SA is in the physical accepted N_SAs, false otherwise.
+     */
+    bool hasAcceptedPhysicalN_SA(typeof(N_AI::N_SA) nSA);
+
     /**
      * This function is used to add a N_TA into the functional accepted N_TAs for this ISOTP object.
      * From this point on, all messages sent or received by this object will have this N_TA.
@@ -146,10 +379,96 @@ public:
      */
     bool setSTmin(STmin stMin);
 
+    /**
+     * This function is used to get the maximum number of frames read from the CAN bus in a single runStep.
+     * @return The maximum number of frames read in a single runStep, 0 means all the frames available.
+     */
+    uint32_t getMaxFramesPerStep() const;
+
+    /**
+     * This function is used to set the maximum number of frames read from the CAN bus in a single runStep.
+     * Every frame read is dispatched to its runner (or to a new one) in the same runStep, so this value bounds the
+     * duration of a runStep when a peer is bursting frames.
+     * @param maxFrames The maximum number of frames to read in a single runStep. If 0, the runStep reads the number of
+     * frames reported by CANInterface::frameAvailable() when it starts.
+     */
+    void setMaxFramesPerStep(uint32_t maxFrames);
+
+    /**
+     * This function is used to check if runStep() polls the ACKs of the written frames itself.
+     * @return True if runStep() polls the ACKs, false if canMessageACKQueueRunStep() has to be called.
+     */
+    bool getPollAcksInRunStep() const;
+
+    /**
+     * This function is used to make runStep() poll the ACKs of the written frames before running their callbacks, so
+     * a single periodic call handles the received frames, the transmissions and the ACKs.
+     * @param pollAcks If true, runStep() stores every ACK the CANInterface has. If false (the default), the ACKs are
+     * stored by canMessageACKQueueRunStep(), runUntil() or the workers.
+     */
+    void setPollAcksInRunStep(bool pollAcks);
+
+    /**
+     * This function is used to get the functions that provide the buffers of the received messages.
+     * @return The provider, with a nullptr getBuffer if the library allocates every message.
+     */
+    N_USData_ReceiveBufferProvider getReceiveBufferProvider() const;
+
+    /**
+     * This function is used to reassemble the received messages straight into buffers of the application.
+     * getBuffer is called with the N_AI and the length of a message when its SF or FF is received. The message is
+     * received into the returned buffer, which does not use the memory given to the constructor, and passed to
+     * N_USData_indication_cb as messageData. releaseBuffer gives the buffer back after N_USData_indication_cb (also if
+     * the reception failed). If getBuffer returns nullptr, the message is allocated by the library as usual.
+     * The messages already being received keep the provider they started with.
+     * @param provider The provider. A nullptr getBuffer makes the library allocate every message again.
+     * @return True if the provider was set, false if it has a getBuffer but no releaseBuffer.
+     */
+    bool setReceiveBufferProvider(N_USData_ReceiveBufferProvider provider);
+
+    /**
+     * This function is used to get the configuration of the streaming reception.
+     * @return The streaming sink, with a nullptr onChunk if no message is streamed.
+     */
+    N_USData_StreamingSink getStreamingSink() const;
+
+    /**
+     * This function is used to receive the long messages in streaming mode, so they never have to fit in memory.
+     * The data of a multi-frame message of at least sink.minMessageLength bytes is given to sink.onChunk in chunks of
+     * sink.chunkSize bytes (the last one may be shorter) as its frames arrive. Only a buffer of one chunk is used from
+     * the memory given to the constructor. onChunk is called from the thread running runStep(), so it should return
+     * quickly. Once the message is complete (or its reception fails or is aborted by onChunk), N_USData_indication_cb
+     * is called with a nullptr messageData.
+     * The messages already being received keep the sink they started with.
+     * @param sink The streaming sink. A nullptr onChunk disables the streaming reception.
+     */
+    void setStreamingSink(N_USData_StreamingSink sink);
+
+    /**
+     * This function is used to get the usage statistics of the memory arena reserved for the messages.
+     * @param stats The statistics of the arena.
+     * @return True if the statistics were retrieved, false if this ISOTP object does not use a memory arena.
+     */
+    bool getMemoryArenaStats(MemoryArena::Stats& stats) const;
+
+    /**
+     * @param nSA The N_SA of this ISOTP object. More physical N_SAs can be added with addAcceptedPhysicalN_SA().
+     * @param canInterface The CANInterface of this ISOTP object. It must outlive it: the ISOTP object registers its
+     * wakeup callback, and unregisters it when destroyed. If another user of the CANInterface already registered one,
+     * the CANInterface is polled every ISOTP_MaxWaitForWork_MS instead (see CANBusDispatcher to share one).
+     * @param totalAvailableMemoryForRunners The memory the messages being sent or received may use at once.
+     * @param useMemoryArena If true, totalAvailableMemoryForRunners is reserved up front in a MemoryArena and the
+     * messages are allocated from it instead of with osMalloc(). If the arena can not be reserved, osMalloc() is used.
+     * @param runnerPoolCapacity The number of runners of each type created up front. It is the maximum number of
+     * messages sent (queued or in progress) and of messages received at once: N_USData_request() fails and the
+     * first frames of new messages are discarded while all the runners of their type are in use. By default, as many
+     * requests as the submission queue holds (ISOTP_SubmissionQueueCapacity) can be queued.
+     */
     ISOTP(typeof(N_AI::N_SA) nSA, uint32_t totalAvailableMemoryForRunners, N_USData_confirm_cb_t N_USData_confirm_cb,
           N_USData_indication_cb_t N_USData_indication_cb, N_USData_FF_indication_cb_t N_USData_FF_indication_cb,
           OSInterface& osInterface, CANInterface& canInterface, uint8_t blockSize = ISOTP_DefaultBlockSize,
-          STmin stMin = ISOTP_DefaultSTmin, const char* tag = TAG);
+          STmin stMin = ISOTP_DefaultSTmin, const char* tag = TAG, bool useMemoryArena = false,
+          size_t runnerPoolCapacity = ISOTP_DefaultRunnerPoolCapacity);
 
     const char* getTag() const;
 
@@ -163,6 +482,20 @@ private:
         frameProcessed
     };
 
+    // Version of the mutable configuration. A published snapshot is never modified: setters publish a new one. Any
+    // thread reads it without locking between acquireConfig() and releaseConfig().
+    using ConfigSnapshot = struct ConfigSnapshot
+    {
+        std::bitset<UINT8_MAX + 1>     acceptedPhysicalN_SAs;   // Indexed by N_SA (the N_TA of the received frames).
+        std::bitset<UINT8_MAX + 1>     acceptedFunctionalN_TAs; // Indexed by N_TA.
+        uint8_t                        blockSize;
+        STmin                          stMin;
+        uint32_t                       maxFramesPerStep;
+        bool                           pollAcksInRunStep;
+        N_USData_ReceiveBufferProvider rxBufferProvider;
+        N_USData_StreamingSink         streamingSink;
+    };
+
     const char* tag;
     char*       queueTag;
 
@@ -171,42 +504,94 @@ private:
     CANInterface& canInterface;
 
     // Synchronization & mutual exclusion
-    OSInterface_Mutex* configMutex;
-    OSInterface_Mutex* notStartedRunnersMutex;
+    OSInterface_Mutex* configMutex; // Serializes the setters and protects retiredConfigs.
     OSInterface_Mutex* runnersMutex;
+    WakeupSignal       rxWakeupSignal; // Wakes up waitForWork().
+
+    // Worker threads (see start()).
+    ThreadInterface_Thread*     rxWorker;
+    ThreadInterface_Thread*     txWorker;
+    ThreadInterface_Thread*     callbackWorker;
+    std::atomic<bool>           workersRunning;
+    WakeupSignal                txWakeupSignal;
+    WakeupSignal                callbackWakeupSignal;
+    OSInterface_Mutex*          completedRunnersMutex;
+    std::list<N_USData_Runner*> completedRunners; // Finished runners whose callbacks are run by the callback worker.
 
     // Internal configuration (constant)
     N_USData_confirm_cb_t       N_USData_confirm_cb;
     N_USData_indication_cb_t    N_USData_indication_cb;
     N_USData_FF_indication_cb_t N_USData_FF_indication_cb;
+    typeof(N_AI::N_SA)          nSA; // The default N_SA, always in acceptedPhysicalN_SAs. Read without a lock.
 
     // Internal configuration (mutable)
-    typeof(N_AI::N_SA)                     nSA;
-    std::unordered_set<typeof(N_AI::N_TA)> acceptedFunctionalN_TAs;
-    uint8_t                                blockSize;
-    STmin                                  stMin{};
+    std::atomic<const ConfigSnapshot*> config;
+    // Threads reading a snapshot, so the setters do not free the ones they replace under their feet.
+    mutable std::atomic<uint32_t>      configReaders;
+    std::list<const ConfigSnapshot*>   retiredConfigs; // Replaced snapshots that may still be read.
 
     // Internal data
     Atomic_int64_t                                           availableMemoryForRunners;
     uint32_t                                                 lastRunTime;
-    std::list<N_USData_Runner*>                              notStartedRunners;
+    uint32_t                                                 ackLastRunTime; // Of canMessageACKQueueRunStep.
+    RunnerSubmissionQueue                                    submittedRunners;  // Filled by N_USData_request.
+    PendingRunnerQueues                                      notStartedRunners; // Only used by the run loop.
     std::unordered_map<typeof(N_AI::N_AI), N_USData_Runner*> activeRunners;
+    RunnerDispatchIndex                                      activeRunnersDispatchIndex;
+    RunnerScheduler                                          activeRunnersScheduler;
+    std::vector<N_USData_Runner*>                            dueRunners;   // Scratch buffer of runRunners.
+    std::vector<N_USData_Runner*>                            ackedRunners; // Scratch buffer of runAckCallbacks.
     std::list<N_USData_Runner*>                              finishedRunners;
     CANMessageACKQueue*                                      canMessageAckQueue;
+    MemoryArena*                                             messageArena; // nullptr if the messages use osMalloc().
+    RunnerPool*                                              runnerPool;
 
     // Functions
     bool populateQueueTag();
+    bool submitRequest(N_USData_Request_Runner* runner, N_AI nAi);
 
-    bool updateRunners();
-    bool updateRunner(N_USData_Runner* runner) const;
+    static void wakeupCallback(void* context);
+    void        notifyRxWorker();
+    void        notifyTxWorker();
+    void        notifyCallbackWorker();
 
-    void runRunners(FrameStatus& frameStatus, CANFrame& frame);
-    void createRunnerForMessage(STmin stM, uint8_t bs, FrameStatus frameStatus, CANFrame& frame);
-    void runStepCanActive();
+    static void rxWorkerEntry(void* context);
+    static void txWorkerEntry(void* context);
+    static void callbackWorkerEntry(void* context);
+    void        rxWorkerLoop();
+    void        txWorkerLoop();
+    void        callbackWorkerLoop();
+    void        joinWorker(ThreadInterface_Thread*& worker);
+
+    /**
+     * @brief Gets the current configuration snapshot. It stays valid until releaseConfig() is called, from any number
+     * of threads at once.
+     */
+    const ConfigSnapshot* acquireConfig() const;
+    void                  releaseConfig() const;
+    void                  freeRetiredConfigs();
+
+    template <typename F> void updateConfig(F&& update);
+
+    bool        updateRunners();
+    static bool updateRunner(N_USData_Runner* runner, uint8_t bs, STmin stM);
+
+    void scheduleRunner(N_USData_Runner* runner);
+    void runRunners();
+    void runAckCallbacks();
+    void dispatchFrame(const ConfigSnapshot& cfg, CANFrame& frame);
+    void processAvailableFrames(const ConfigSnapshot& cfg);
+    void createRunnerForMessage(const ConfigSnapshot& cfg, FrameStatus frameStatus, CANFrame& frame);
     void runStepCanInactive();
+    void takeSubmittedRunners();
     void startRunners();
-    void getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame) const;
+    void getFrameIfAvailable(const ConfigSnapshot& cfg, FrameStatus& frameStatus, CANFrame& frame) const;
     void runFinishedRunnerCallbacks();
+    void runRunnerCallbacks(N_USData_Runner* runner);
+    void runCompletedRunnerCallbacks();
+
+    uint32_t runStepCanActive();
+    uint32_t getTimeUntilNextRun();
 
     template <std::ranges::input_range R> void runErrorCallbacks(R&& runners);
 };
@@ -5,7 +5,59 @@
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+// Compile-time log threshold of ISOTP, set with the ISOTP_LOG_LEVEL CMake option. The OSInterfaceLog* calls above it
+// are removed, including the evaluation of their arguments.
+#define ISOTP_LOG_LEVEL_NONE    0
+#define ISOTP_LOG_LEVEL_ERROR   1
+#define ISOTP_LOG_LEVEL_WARNING 2
+#define ISOTP_LOG_LEVEL_INFO    3
+#define ISOTP_LOG_LEVEL_DEBUG   4
+#define ISOTP_LOG_LEVEL_VERBOSE 5
+
+#ifndef ISOTP_LOG_LEVEL
+#define ISOTP_LOG_LEVEL ISOTP_LOG_LEVEL_VERBOSE
+#endif
+
+#include <cstddef>
 #include <cstdint>
+#include "CANInterface.h"
+#include "OSInterface.h"
+
+// The call sits in a dead branch, so the compiler drops it but the arguments still count as used.
+inline void ISOTP_DiscardLog(const char*, const char*, ...)
+{
+}
+
+#define ISOTP_DISCARDED_LOG(tag, format, ...)                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (false)                                                                                                     \
+        {                                                                                                              \
+            ISOTP_DiscardLog(tag, format, ##__VA_ARGS__);                                                              \
+        }                                                                                                              \
+    }                                                                                                                  \
+    while (false)
+
+#if ISOTP_LOG_LEVEL < ISOTP_LOG_LEVEL_VERBOSE
+#undef OSInterfaceLogVerbose
+#define OSInterfaceLogVerbose(tag, format, ...) ISOTP_DISCARDED_LOG(tag, format, ##__VA_ARGS__)
+#endif
+#if ISOTP_LOG_LEVEL < ISOTP_LOG_LEVEL_DEBUG
+#undef OSInterfaceLogDebug
+#define OSInterfaceLogDebug(tag, format, ...) ISOTP_DISCARDED_LOG(tag, format, ##__VA_ARGS__)
+#endif
+#if ISOTP_LOG_LEVEL < ISOTP_LOG_LEVEL_INFO
+#undef OSInterfaceLogInfo
+#define OSInterfaceLogInfo(tag, format, ...) ISOTP_DISCARDED_LOG(tag, format, ##__VA_ARGS__)
+#endif
+#if ISOTP_LOG_LEVEL < ISOTP_LOG_LEVEL_WARNING
+#undef OSInterfaceLogWarning
+#define OSInterfaceLogWarning(tag, format, ...) ISOTP_DISCARDED_LOG(tag, format, ##__VA_ARGS__)
+#endif
+#if ISOTP_LOG_LEVEL < ISOTP_LOG_LEVEL_ERROR
+#undef OSInterfaceLogError
+#define OSInterfaceLogError(tag, format, ...) ISOTP_DISCARDED_LOG(tag, format, ##__VA_ARGS__)
+#endif
 
 constexpr uint32_t ISOTP_MaxTimeToWaitForSync_MS = 100;
 
@@ -25,6 +77,80 @@ using STmin = struct SeparationTimeMin
 
 using Mtype = enum Mtype { Mtype_Diagnostics, Mtype_Unknown };
 
+/**
+ * This function is called when the library stops using a message buffer lent to it, so its owner can reuse or free it.
+ * @param messageData The buffer lent to the library (the first segment for a message lent in segments).
+ * @param messageLength The length of the message.
+ * @param context The context given with the buffer.
+ */
+using N_USData_release_cb_t = void (*)(const uint8_t* messageData, uint32_t messageLength, void* context);
+
+/**
+ * This function is called when a message starts to be received (on its SF or FF) to get the buffer it is reassembled
+ * into, so the message is received straight into the memory of the application.
+ * @param nAi The N_AI of the message.
+ * @param messageLength The length of the message.
+ * @param context The context given with the function.
+ * @return A buffer of at least messageLength bytes, lent to the library until it is given back with the release
+ * callback, or nullptr to let the library allocate the message itself.
+ */
+using N_USData_rxBuffer_cb_t = uint8_t* (*)(N_AI nAi, uint32_t messageLength, void* context);
+
+/**
+ * The functions an application uses to provide the buffers of the received messages.
+ */
+using N_USData_ReceiveBufferProvider = struct N_USData_ReceiveBufferProvider
+{
+    N_USData_rxBuffer_cb_t getBuffer;     // nullptr if the library allocates every message.
+    N_USData_release_cb_t  releaseBuffer; // Gives back a buffer returned by getBuffer.
+    void*                  context;       // Passed to both functions.
+};
+
+/**
+ * This function is called with each chunk of a message received in streaming mode, in order, as its frames arrive.
+ * @param nAi The N_AI of the message.
+ * @param offset The position of the chunk in the message.
+ * @param chunk The data of the chunk. It is only valid during the call.
+ * @param chunkLength The length of the chunk.
+ * @param context The context given with the function.
+ * @return True to keep receiving the message, false to abort its reception.
+ */
+using N_USData_chunk_cb_t = bool (*)(N_AI nAi, uint32_t offset, const uint8_t* chunk, uint32_t chunkLength,
+                                     void* context);
+
+/**
+ * The configuration of the streaming reception: the long messages are given to onChunk in chunks instead of being
+ * kept whole until N_USData_indication_cb.
+ */
+using N_USData_StreamingSink = struct N_USData_StreamingSink
+{
+    N_USData_chunk_cb_t onChunk;          // nullptr if no message is streamed.
+    uint32_t            minMessageLength; // The multi-frame messages at least this long are streamed.
+    uint32_t            chunkSize;        // 0 for the data of a block of CFs (of one CF if the block size is 0).
+    void*               context;          // Passed to onChunk.
+};
+
+/**
+ * This function is called to get the next bytes of a message sent from a data source, as its frames are sent.
+ * @param offset The position of the requested bytes in the message. The bytes are requested in order, once.
+ * @param destination Where the bytes are written.
+ * @param length The number of bytes requested.
+ * @param context The context given with the function.
+ * @return True if the bytes were written, false to abort the transmission.
+ */
+using N_USData_source_cb_t = bool (*)(uint32_t offset, uint8_t* destination, uint32_t length, void* context);
+
+constexpr uint8_t ISOTP_MaxMessageSegments = 8; // Maximum number of segments of a message lent in segments.
+
+/**
+ * A part of a message lent in segments: the message is the concatenation of its segments, in order.
+ */
+using N_USData_Segment = struct N_USData_Segment
+{
+    const uint8_t* data;
+    uint32_t       length;
+};
+
 using N_Result = enum N_Result {
     NOT_STARTED = 0,
     IN_PROGRESS_FF, // Only used by N_USData_Indication_Runner to indicate that the FF was received in this step.
@@ -45,6 +171,9 @@ const char* N_ResultToString(N_Result result);
 
 const char* STminToString(const STmin& stMin);
 
+// Writes into a buffer provided by the caller (MAX_STMIN_STR_SIZE bytes), so it is safe to use from several threads.
+const char* STminToString(const STmin& stMin, char* buffer, size_t bufferSize);
+
 uint32_t getStMinInMs(STmin stMin);
 
 #endif // ISOTP_COMMON_H
@@ -0,0 +1,102 @@
+#ifndef MEMORYARENA_H
+#define MEMORYARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include "OSInterface.h"
+
+/**
+ * Memory reserved up front from which the message buffers of the runners are carved, so a long-running node does not
+ * fragment the heap of the platform and the allocation time does not depend on it.
+ *
+ * Every block starts with a header that links it to its physical neighbours, so a freed block is merged with the free
+ * blocks next to it. Free blocks are kept in segregated lists, one per power of two of their size, and a bitmap of the
+ * non-empty lists finds a block that fits without walking the arena (a simplified TLSF with a single level).
+ */
+class MemoryArena
+{
+public:
+    using Stats = struct Stats
+    {
+        uint32_t capacity;          // Size of the arena.
+        uint32_t usedBytes;         // Bytes taken by the allocated blocks, headers included.
+        uint32_t highWaterMark;     // Largest usedBytes since the arena was created.
+        uint32_t freeBytes;         // Bytes in the free blocks, headers included.
+        uint32_t largestFreeBlock;  // Largest allocation that can succeed right now.
+        uint32_t freeBlocks;        // Number of free blocks.
+        uint32_t allocations;       // Number of blocks currently allocated.
+        uint32_t failedAllocations; // Number of allocations that did not fit since the arena was created.
+        uint8_t  fragmentation;     // Percentage of the free bytes outside the largest free block.
+    };
+
+    /**
+     * @brief Reserves the arena.
+     * @param result Set to true if the arena was reserved, false otherwise (the arena or its mutex could not be
+     * created).
+     * @param size The size of the arena in bytes, headers included.
+     */
+    MemoryArena(bool& result, uint32_t size, OSInterface& osInterface);
+
+    ~MemoryArena();
+
+    MemoryArena(const MemoryArena&)            = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    /**
+     * @brief Allocates a block from the arena. Can be called from any thread.
+     * @param size The number of bytes needed (0 is allocated as 1).
+     * @return The block, aligned as one returned by OSInterface::osMalloc(), or nullptr if it does not fit or the arena
+     * could not be locked.
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Gives a block back to the arena. Can be called from any thread.
+     * @param block A block returned by allocate(), or nullptr.
+     */
+    void free(void* block);
+
+    /**
+     * @brief Gets the usage statistics of the arena.
+     * @return The statistics, all zero if the arena could not be locked.
+     */
+    [[nodiscard]] Stats getStats();
+
+    constexpr static const char* TAG = "ISOTP-MemoryArena";
+
+private:
+    using BlockHeader = struct BlockHeader
+    {
+        uint32_t     size;         // Size of the block, header included.
+        uint32_t     prevPhysSize; // Size of the block right before this one in the arena, 0 for the first one.
+        bool         isFree;
+        BlockHeader* nextFree; // Only valid while the block is free.
+        BlockHeader* prevFree; // Only valid while the block is free.
+    };
+
+    static constexpr uint32_t Alignment    = alignof(std::max_align_t);
+    static constexpr uint32_t HeaderSize   = (sizeof(BlockHeader) + Alignment - 1) & ~(Alignment - 1);
+    static constexpr uint32_t MinBlockSize = HeaderSize + Alignment;
+    static constexpr uint32_t FreeLists    = 32; // One per power of two of a uint32_t size.
+
+    static uint32_t listIndex(uint32_t blockSize);
+
+    [[nodiscard]] BlockHeader* nextPhysBlock(const BlockHeader* block) const;
+    void                       insertFreeBlock(BlockHeader* block);
+    void                       removeFreeBlock(BlockHeader* block);
+    BlockHeader*               findFreeBlock(uint32_t blockSize);
+
+    OSInterface* osInterface;
+    uint8_t*     memory;
+    uint32_t     capacity;
+
+    OSInterface_Mutex* mutex; // Protects everything below.
+    BlockHeader*       freeLists[FreeLists]{};
+    uint32_t           nonEmptyFreeLists; // Bit i is set if freeLists[i] is not empty.
+    uint32_t           usedBytes;
+    uint32_t           highWaterMark;
+    uint32_t           allocations;
+    uint32_t           failedAllocations;
+};
+
+#endif // MEMORYARENA_H
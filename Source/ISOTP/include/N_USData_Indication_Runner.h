@@ -3,22 +3,47 @@
 
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
+#include "MemoryArena.h"
 #include "N_USData_Runner.h"
 #include "Timer_N.h"
 
-constexpr char    N_USDATA_INDICATION_RUNNER_STATIC_TAG[] = "ISOTP_IndicationRunner_";
-constexpr int32_t N_USDATA_INDICATION_RUNNER_TAG_SIZE =
-    MAX_N_AI_STR_SIZE + sizeof(N_USDATA_INDICATION_RUNNER_STATIC_TAG);
+constexpr char N_USDATA_INDICATION_RUNNER_STATIC_TAG[] = "ISOTP_IndicationRunner_";
 
 // Class that handles the indication aka reception of a message
 class N_USData_Indication_Runner : public N_USData_Runner
 {
 public:
+    /**
+     * @brief Creates an idle runner, which needs a reset() to receive a message.
+     * @param result Set to true if the runner was created, false otherwise.
+     * @param messageArena The arena the message is allocated from, or nullptr to allocate it with osMalloc().
+     */
+    N_USData_Indication_Runner(bool& result, Atomic_int64_t& availableMemoryForRunners, OSInterface& osInterface,
+                               CANMessageACKQueue& canMessageACKQueue, MemoryArena* messageArena = nullptr);
+
     N_USData_Indication_Runner(bool& result, N_AI nAi, Atomic_int64_t& availableMemoryForRunners, uint8_t blockSize,
                                STmin stMin, OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue);
 
     ~N_USData_Indication_Runner() override;
 
+    /**
+     * @brief Prepares the runner to receive a new message, releasing the previous one.
+     * @param rxBufferProvider The functions that provide the buffer of the message. If it has no getBuffer, or
+     * getBuffer returns nullptr, the message is allocated by the runner and uses availableMemoryForRunners.
+     * @param streamingSink If the message is long enough for it, the message is given to its onChunk as it is received,
+     * and the runner only keeps (and charges to availableMemoryForRunners) a buffer of one chunk. getMessageData()
+     * returns nullptr for a streamed message.
+     * @return True if the runner is ready to receive the message, false otherwise.
+     */
+    bool reset(N_AI nAi, uint8_t blockSize, STmin stMin, N_USData_ReceiveBufferProvider rxBufferProvider = {},
+               N_USData_StreamingSink streamingSink = {});
+
+    /**
+     * @brief Frees the message of the runner and gives its memory back to availableMemoryForRunners, or gives a
+     * provided buffer back to the application with its release function.
+     */
+    void release();
+
     N_Result runStep(CANFrame* receivedFrame) override;
 
     [[nodiscard]] uint32_t getNextRunTime() override;
@@ -31,6 +56,8 @@ public:
 
     [[nodiscard]] N_AI getN_AI() const override;
 
+    [[nodiscard]] N_AI getInboundN_AI() const override;
+
     [[nodiscard]] uint8_t* getMessageData() const override;
 
     [[nodiscard]] uint32_t getMessageLength() const override;
@@ -41,7 +68,7 @@ public:
 
     [[nodiscard]] RunnerType getRunnerType() const override;
 
-    [[nodiscard]] const char* getTAG() const override;
+    [[nodiscard]] const char* formatTag(char* buffer, size_t bufferSize) const override;
 
     [[nodiscard]] bool isThisFrameForMe(const CANFrame& frame) const override;
 
@@ -58,6 +85,10 @@ private:
     [[nodiscard]] uint32_t getNextTimeoutTime() const;
     N_Result               checkTimeouts();
     [[nodiscard]] bool     awaitingFrame(const CANFrame& frame) const;
+    [[nodiscard]] bool     acquireMessageData(uint32_t size);
+    [[nodiscard]] bool     storeMessageData(const uint8_t* data, uint32_t length);
+    [[nodiscard]] uint8_t* allocateMessageData(uint32_t length) const;
+    void                   freeMessageData() const;
 
     using InternalStatus_t = enum { NOT_RUNNING, SEND_FC, AWAITING_FC_ACK, AWAITING_CF, MESSAGE_RECEIVED, ERROR };
 
@@ -66,6 +97,8 @@ private:
     N_AI     nAi;
     Mtype    mType;
     uint8_t* messageData{};
+    bool     messageDataProvided{}; // True if messageData was given by rxBufferProvider.
+    uint32_t messageDataSize{};     // The size of messageData: messageLength, or chunkSize if the message is streamed.
     int64_t  messageLength;
     uint8_t  blockSize;
     uint8_t  effectiveBlockSize;
@@ -75,7 +108,6 @@ private:
     N_Result result;
     uint32_t lastRunTime;
     uint8_t  sequenceNumber;
-    char*    tag{};
 
     OSInterface_Mutex* mutex{};
     InternalStatus_t   internalStatus;
@@ -83,13 +115,20 @@ private:
     uint32_t           messageOffset;
     int16_t            cfReceivedInThisBlock;
 
-    Timer_N* timerN_Ar{}; // Timer for sending a frame
-    Timer_N* timerN_Br{}; // Timer that holds the time since the last FF or CF to the next FC.
-    Timer_N* timerN_Cr{}; // Timer that holds the time since the last FC to the next FC.
+    Timer_N timerN_Ar; // Timer for sending a frame
+    Timer_N timerN_Br; // Timer that holds the time since the last FF or CF to the next FC.
+    Timer_N timerN_Cr; // Timer that holds the time since the last FC to the next FC.
 
     OSInterface*        osInterface;
+    MemoryArena*        messageArena;
     CANMessageACKQueue* CanMessageACKQueue{};
 
+    N_USData_ReceiveBufferProvider rxBufferProvider{};
+    N_USData_StreamingSink         streamingSink{};
+    bool                           streaming{}; // True if the message is given to streamingSink in chunks.
+    uint32_t                       chunkSize{};
+    uint32_t                       chunkFill{}; // Bytes of the current chunk in messageData.
+
     CANFrame frameToHold{};
     bool     frameToHoldValid{false};
 };
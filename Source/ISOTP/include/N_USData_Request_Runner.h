@@ -1,24 +1,85 @@
 #ifndef N_USDATA_REQUEST_RUNNER_H
 #define N_USDATA_REQUEST_RUNNER_H
 
+#include <array>
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
+#include "MemoryArena.h"
 #include "N_USData_Runner.h"
 #include "Timer_N.h"
 
-constexpr char    N_USDATA_REQUEST_RUNNER_STATIC_TAG[] = "ISOTP_RequestRunner_";
-constexpr int32_t N_USDATA_REQUEST_RUNNER_TAG_SIZE     = MAX_N_AI_STR_SIZE + sizeof(N_USDATA_REQUEST_RUNNER_STATIC_TAG);
+constexpr char N_USDATA_REQUEST_RUNNER_STATIC_TAG[] = "ISOTP_RequestRunner_";
 
 // Class that handles the request aka transmission of a message
 class N_USData_Request_Runner : public N_USData_Runner
 {
 public:
+    /**
+     * @brief Creates an idle runner, which needs a reset() to send a message.
+     * @param result Set to true if the runner was created, false otherwise.
+     * @param messageArena The arena the message is allocated from, or nullptr to allocate it with osMalloc().
+     */
+    N_USData_Request_Runner(bool& result, Atomic_int64_t& availableMemoryForRunners, OSInterface& osInterface,
+                            CANMessageACKQueue& canMessageACKQueue, MemoryArena* messageArena = nullptr);
+
     N_USData_Request_Runner(bool& result, N_AI nAi, Atomic_int64_t& availableMemoryForRunners, Mtype mType,
                             const uint8_t* messageData, uint32_t messageLength, OSInterface& osInterface,
                             CANMessageACKQueue& canMessageACKQueue);
 
     ~N_USData_Request_Runner() override;
 
+    /**
+     * @brief Prepares the runner to send a new message, releasing the previous one.
+     * @return True if the runner is ready to send the message, false otherwise.
+     */
+    bool reset(N_AI nAi, Mtype mType, const uint8_t* messageData, uint32_t messageLength);
+
+    /**
+     * @brief Prepares the runner to send a message from a buffer lent by the caller, releasing the previous one.
+     * The message is not copied and does not use availableMemoryForRunners. The buffer must not be modified until
+     * releaseCallback is called by release().
+     * @param releaseCallback The function called when the runner stops using the buffer. It is not called if this
+     * function fails.
+     * @param releaseContext The context passed to releaseCallback.
+     * @return True if the runner is ready to send the message, false otherwise.
+     */
+    bool reset(N_AI nAi, Mtype mType, const uint8_t* messageData, uint32_t messageLength,
+               N_USData_release_cb_t releaseCallback, void* releaseContext);
+
+    /**
+     * @brief Prepares the runner to send a message made of several segments lent by the caller, releasing the previous
+     * one. The frames are packed straight from the segments, across their boundaries.
+     * The segment list is copied (so it does not need to outlive this call), but the data of the segments must not be
+     * modified until releaseCallback is called by release(), with the first segment as messageData.
+     * @param segments The segments of the message, in order. Empty segments are allowed.
+     * @param segmentCount The number of segments, from 1 to ISOTP_MaxMessageSegments.
+     * @return True if the runner is ready to send the message, false otherwise.
+     */
+    bool reset(N_AI nAi, Mtype mType, const N_USData_Segment* segments, uint8_t segmentCount,
+               N_USData_release_cb_t releaseCallback, void* releaseContext);
+
+    /**
+     * @brief Prepares the runner to send a message whose bytes are pulled from a data source as the frames are sent,
+     * releasing the previous one. The message is never held in memory, so it does not use availableMemoryForRunners.
+     * @param messageLength The length of the message.
+     * @param source The function that writes the next bytes of the message into each frame.
+     * @param sourceContext The context passed to source.
+     * @return True if the runner is ready to send the message, false otherwise.
+     */
+    bool reset(N_AI nAi, Mtype mType, uint32_t messageLength, N_USData_source_cb_t source, void* sourceContext);
+
+    /**
+     * @brief Frees the message of the runner and gives its memory back to availableMemoryForRunners, or gives a lent
+     * buffer back to its owner with its release callback.
+     */
+    void release();
+
+    /**
+     * @brief Drops a lent buffer without calling its release callback, for a request that was not queued after all (so
+     * the caller still owns it). It does nothing for a copied message.
+     */
+    void forgetLentMessage();
+
     N_Result runStep(CANFrame* receivedFrame) override;
 
     [[nodiscard]] uint32_t getNextRunTime() override;
@@ -27,6 +88,8 @@ public:
 
     [[nodiscard]] N_AI getN_AI() const override;
 
+    [[nodiscard]] N_AI getInboundN_AI() const override;
+
     [[nodiscard]] uint8_t* getMessageData() const override;
 
     [[nodiscard]] uint32_t getMessageLength() const override;
@@ -37,7 +100,7 @@ public:
 
     [[nodiscard]] RunnerType getRunnerType() const override;
 
-    [[nodiscard]] const char* getTAG() const override;
+    [[nodiscard]] const char* formatTag(char* buffer, size_t bufferSize) const override;
 
     [[nodiscard]] bool isThisFrameForMe(const CANFrame& frame) const override;
 
@@ -57,7 +120,12 @@ private:
     [[nodiscard]] uint32_t getNextTimeoutTime() const;
     N_Result               checkTimeouts();
     N_Result               sendCFFrame();
+    [[nodiscard]] bool     copyMessage(uint8_t* destination, uint32_t length);
     [[nodiscard]] bool     awaitingFrame(const CANFrame& frame) const;
+    void                   clearState(N_AI nAi, uint32_t messageLength);
+    [[nodiscard]] bool     prepare(Mtype mType);
+    [[nodiscard]] uint8_t* allocateMessageData(uint32_t length) const;
+    void                   freeMessageData() const;
 
     using InternalStatus_t = enum {
         NOT_RUNNING_SF,
@@ -76,7 +144,18 @@ private:
 
     N_AI     nAi;
     Mtype    mType;
-    uint8_t* messageData{};
+    uint8_t* messageData{}; // Not modified by the runner, so it can be a lent buffer.
+
+    // The message as a list of segments (just messageData if it was not lent in segments), and the position of
+    // messageOffset in it.
+    std::array<N_USData_Segment, ISOTP_MaxMessageSegments> segments{};
+    uint8_t                                                segmentCount{};
+    uint8_t                                                segmentIndex{};
+    uint32_t                                               segmentOffset{};
+
+    N_USData_source_cb_t source{}; // Not nullptr if the message is pulled from a data source instead.
+    void*                sourceContext{};
+
     int64_t  messageLength;
     uint8_t  blockSize;
     STmin    stMin{};
@@ -86,19 +165,22 @@ private:
     uint8_t         sequenceNumber;
     Atomic_int64_t* availableMemoryForRunners;
     uint32_t        messageOffset;
-    char*           tag{};
 
     OSInterface_Mutex* mutex{};
     InternalStatus_t   internalStatus;
     int16_t            cfSentInThisBlock;
 
-    Timer_N* timerN_As{}; // Timer for sending a frame
-    Timer_N* timerN_Bs{}; // Timer that holds the time since the last FF or CF to the next CF.
-    Timer_N* timerN_Cs{}; // Timer that calls out once STmin has passed.
+    Timer_N timerN_As; // Timer for sending a frame
+    Timer_N timerN_Bs; // Timer that holds the time since the last FF or CF to the next CF.
+    Timer_N timerN_Cs; // Timer that calls out once STmin has passed.
 
     OSInterface*        osInterface;
+    MemoryArena*        messageArena;
     CANMessageACKQueue* CanMessageACKQueue;
 
+    N_USData_release_cb_t releaseCallback{}; // Not nullptr if messageData is a lent buffer.
+    void*                 releaseContext{};
+
     CANFrame frameToHold{};
     bool     frameToHoldValid{false};
 };
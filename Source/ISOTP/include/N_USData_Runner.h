@@ -24,8 +24,9 @@
     {                                                                                                                  \
         auto oldStatus = internalStatus;                                                                               \
         internalStatus = newStatus;                                                                                    \
-        OSInterfaceLogDebug(tag, "internalStatus changed from %s (%d) to %s (%d)", internalStatusToString(oldStatus),  \
-                            oldStatus, internalStatusToString(internalStatus), internalStatus);                        \
+        OSInterfaceLogDebug(getTAG(), "internalStatus changed from %s (%d) to %s (%d)",                                \
+                            internalStatusToString(oldStatus), oldStatus, internalStatusToString(internalStatus),      \
+                            internalStatus);                                                                           \
     }                                                                                                                  \
     while (0)
 
@@ -34,7 +35,7 @@
     {                                                                                                                  \
         updateInternalStatus(ERROR);                                                                                   \
         result = errorCode;                                                                                            \
-        OSInterfaceLogError(tag, "Returning error %s.", N_ResultToString(errorCode));                                  \
+        OSInterfaceLogError(getTAG(), "Returning error %s.", N_ResultToString(errorCode));                             \
         return result;                                                                                                 \
     }                                                                                                                  \
     while (false)
@@ -44,7 +45,7 @@
     {                                                                                                                  \
         updateInternalStatus(ERROR);                                                                                   \
         result = errorCode;                                                                                            \
-        OSInterfaceLogError(tag, "Returning error %s. " fmt, N_ResultToString(errorCode), ##__VA_ARGS__);              \
+        OSInterfaceLogError(getTAG(), "Returning error %s. " fmt, N_ResultToString(errorCode), ##__VA_ARGS__);         \
         return result;                                                                                                 \
     }                                                                                                                  \
     while (false)
@@ -60,6 +61,8 @@ public:
     constexpr static uint8_t  MAX_CF_MESSAGE_LENGTH          = 7;
     constexpr static uint8_t  FC_MESSAGE_LENGTH              = 3;
     constexpr static uint32_t MIN_FF_DL_WITH_ESCAPE_SEQUENCE = 4096;
+    constexpr static uint32_t MAX_RUNNER_TAG_SIZE =
+        MAX_N_AI_STR_SIZE + 23; // 23 = "ISOTP_IndicationRunner_", the longest static tag of the runners
 
 #if ISOTP_USE_DEBUG_TIMEOUTS
     constexpr static int32_t N_As_TIMEOUT_MS = 100000000;
@@ -111,6 +114,13 @@ public:
      */
     [[nodiscard]] virtual N_AI getN_AI() const = 0;
 
+    /**
+     * @brief Returns the N_AI carried by the frames this runner receives (e.g. the FCs of a request runner have the
+     * N_SA and N_TA swapped).
+     * @return The N_AI of the frames received by the runner.
+     */
+    [[nodiscard]] virtual N_AI getInboundN_AI() const = 0;
+
     /**
      * @brief Returns the message data of the runner.
      * @return The message data of the runner.
@@ -148,11 +158,22 @@ public:
     virtual void messageACKReceivedCallback(CANInterface::ACKResult success) = 0;
 
     /**
-     * @brief Returns the logging tag of the runner.
+     * @brief Formats the logging tag of the runner (its static tag followed by its N_AI) into a buffer provided by the
+     * caller, so it can be kept or formatted together with other tags.
+     * @param buffer The buffer to write the tag to, MAX_RUNNER_TAG_SIZE bytes are enough for any runner.
+     * @param bufferSize The size of the buffer.
+     * @return buffer.
+     */
+    [[nodiscard]] virtual const char* formatTag(char* buffer, size_t bufferSize) const = 0;
+
+    /**
+     * @brief Returns the logging tag of the runner, for its own log calls.
      * @return The logging tag of the runner.
+     *
+     * @note The tag is written to a per-thread buffer, overwritten by the next call from the same thread. Use
+     * formatTag() to keep it or to log several tags at once.
      */
-    [[nodiscard]] virtual const char*
-    getTAG() const = 0; // TODO: in the future, allow ISOTP to set logging level of the runner.
+    [[nodiscard]] const char* getTAG() const; // TODO: in the future, allow ISOTP to set logging level of the runner.
 
     /**
      * @brief Returns if the frame is for this runner.
@@ -160,6 +181,18 @@ public:
      * @return True if the frame is for this runner, false otherwise.
      */
     [[nodiscard]] virtual bool isThisFrameForMe(const CANFrame& frame) const = 0;
+
+protected:
+    /**
+     * @brief Formats the logging tag of a runner as staticTag followed by its N_AI. Runners keep no tag storage, it is
+     * built on demand.
+     * @param buffer The buffer to write the tag to.
+     * @param bufferSize The size of the buffer.
+     * @param staticTag The prefix of the tag.
+     * @param nAi The N_AI of the runner.
+     * @return buffer.
+     */
+    static const char* formatRunnerTag(char* buffer, size_t bufferSize, const char* staticTag, const N_AI& nAi);
 };
 
 #endif // N_USDATA_RUNNER_H
@@ -0,0 +1,70 @@
+#ifndef PENDINGRUNNERQUEUES_H
+#define PENDINGRUNNERQUEUES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include "N_USData_Runner.h"
+
+/**
+ * Runners waiting to be started, queued per N_AI. ISO 15765-2 allows only one message with the same N_AI at a time, so
+ * only the first runner of an idle N_AI can start. The N_AIs that have a runner able to start are kept in a ready
+ * list, so starting the runners does not walk the ones that have to keep waiting.
+ *
+ * An N_AI is busy from the moment one of its runners is started (or acquire() is called) until release() is called,
+ * which makes its next runner ready in constant time.
+ */
+class PendingRunnerQueues
+{
+public:
+    /**
+     * @brief Queues a runner after the other runners with its N_AI.
+     * @param runner The runner to queue.
+     */
+    void push(N_USData_Runner* runner);
+
+    /**
+     * @brief Removes and returns the first runner of the next ready N_AI, and marks that N_AI as busy.
+     * @return The runner to start, or nullptr if no N_AI is ready.
+     */
+    [[nodiscard]] N_USData_Runner* popReady();
+
+    /**
+     * @brief Marks an N_AI as busy, so its queued runners wait until it is released.
+     * @param nAi The N_AI of a runner that was started without being queued.
+     */
+    void acquire(const N_AI& nAi);
+
+    /**
+     * @brief Marks an N_AI as idle, making its next queued runner (if any) ready.
+     * @param nAi The N_AI of a runner that finished.
+     */
+    void release(const N_AI& nAi);
+
+    /**
+     * @brief Removes every queued runner and forgets the busy N_AIs.
+     * @param runners The list the queued runners are appended to, in the order they were queued for each N_AI.
+     */
+    void takeAll(std::list<N_USData_Runner*>& runners);
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    using Queue = struct Queue
+    {
+        std::deque<N_USData_Runner*> runners;
+        bool                         busy;
+        bool                         ready; // Whether the N_AI is in readyN_AIs.
+    };
+
+    void markReady(typeof(N_AI::N_AI) key, Queue& queue);
+
+    std::unordered_map<typeof(N_AI::N_AI), Queue> queues;
+    // N_AIs that may have a runner able to start. Entries are checked again when popped, so stale ones are harmless.
+    std::deque<typeof(N_AI::N_AI)> readyN_AIs;
+    size_t                         runnerCount = 0;
+};
+
+#endif // PENDINGRUNNERQUEUES_H
@@ -0,0 +1,66 @@
+#ifndef RUNNERDISPATCHINDEX_H
+#define RUNNERDISPATCHINDEX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include "CANInterface.h"
+#include "N_USData_Runner.h"
+
+/**
+ * Index of the active runners keyed by the N_AI of the frames they receive, so an inbound frame finds its runner with a
+ * single hash lookup instead of asking every runner with N_USData_Runner::isThisFrameForMe().
+ *
+ * A request runner and an indication runner can await frames with the same N_AI (a request to a node and a request
+ * from that same node), so each key holds one slot per runner type: FCs are dispatched to the request runner and SFs,
+ * FFs and CFs to the indication runner.
+ */
+class RunnerDispatchIndex
+{
+public:
+    /**
+     * @brief Adds a runner to the index.
+     * @param runner The runner to add.
+     * @return True if the runner was added, false if another runner of the same type is already indexed with the same
+     * inbound N_AI.
+     */
+    bool insert(N_USData_Runner* runner);
+
+    /**
+     * @brief Removes a runner from the index. Does nothing if the runner is not indexed.
+     * @param runner The runner to remove.
+     */
+    void erase(const N_USData_Runner* runner);
+
+    /**
+     * @brief Finds the runner that is awaiting a frame.
+     * @param frame The received frame.
+     * @return The runner awaiting the frame, or nullptr if there is none.
+     */
+    [[nodiscard]] N_USData_Runner* find(const CANFrame& frame) const;
+
+    [[nodiscard]] size_t size() const;
+
+    void clear();
+
+    /**
+     * @brief Returns the key used to index a N_AI. Only the addressing fields are used, so the unnamed bits of the
+     * identifier do not affect the lookup.
+     * @param nAi The N_AI to get the key for.
+     * @return The key of the N_AI.
+     */
+    static uint32_t getDispatchKey(const N_AI& nAi);
+
+private:
+    using Slot = struct
+    {
+        N_USData_Runner* requestRunner;
+        N_USData_Runner* indicationRunner;
+    };
+
+    static N_USData_Runner*& getSlotEntry(Slot& slot, N_USData_Runner::RunnerType runnerType);
+
+    std::unordered_map<uint32_t, Slot> index;
+    size_t                             runnerCount = 0;
+};
+
+#endif // RUNNERDISPATCHINDEX_H
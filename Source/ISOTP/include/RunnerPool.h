@@ -0,0 +1,109 @@
+#ifndef RUNNERPOOL_H
+#define RUNNERPOOL_H
+
+#include <cstddef>
+#include "Atomic_int64_t.h"
+#include "BoundedMPMCQueue.h"
+#include "CANMessageACKQueue.h"
+#include "MemoryArena.h"
+#include "N_USData_Indication_Runner.h"
+#include "N_USData_Request_Runner.h"
+
+/**
+ * Preallocated runners that are recycled between messages, so a message does not allocate a runner and its mutex.
+ *
+ * The pool creates its capacity of runners of each type up front and never creates or deletes any other one, so the
+ * capacity is the maximum number of messages of each type (sent and received) that can be queued or in progress at
+ * once. When all the runners of a type are in use, acquiring one fails.
+ *
+ * The idle runners of each type are kept in a BoundedMPMCQueue, so acquiring and releasing a runner never takes a lock.
+ */
+class RunnerPool
+{
+public:
+    /**
+     * @brief Creates the pool and its idle runners.
+     * @param result Set to true if all the runners were created, false otherwise (the pool only has the runners
+     * created before the failure).
+     * @param capacity The number of runners of each type the pool creates.
+     * @param messageArena The arena the messages of the runners are allocated from, or nullptr to use osMalloc().
+     */
+    RunnerPool(bool& result, size_t capacity, Atomic_int64_t& availableMemoryForRunners, OSInterface& osInterface,
+               CANMessageACKQueue& canMessageACKQueue, MemoryArena* messageArena = nullptr);
+
+    ~RunnerPool();
+
+    RunnerPool(const RunnerPool&)            = delete;
+    RunnerPool& operator=(const RunnerPool&) = delete;
+
+    /**
+     * @brief Returns a runner ready to send a message (see N_USData_Request_Runner::reset()).
+     * @return The runner, or nullptr if every runner is in use or it could not be prepared (the runner stays in the
+     * pool).
+     */
+    N_USData_Request_Runner* acquireRequestRunner(N_AI nAi, Mtype mType, const uint8_t* messageData,
+                                                  uint32_t messageLength);
+
+    /**
+     * @brief Returns a runner ready to send a message from a lent buffer (see N_USData_Request_Runner::reset()).
+     * @return The runner, or nullptr if every runner is in use or it could not be prepared (the runner stays in the
+     * pool and releaseCallback is not called).
+     */
+    N_USData_Request_Runner* acquireRequestRunner(N_AI nAi, Mtype mType, const uint8_t* messageData,
+                                                  uint32_t messageLength, N_USData_release_cb_t releaseCallback,
+                                                  void* releaseContext);
+
+    /**
+     * @brief Returns a runner ready to send a message from lent segments (see N_USData_Request_Runner::reset()).
+     * @return The runner, or nullptr if every runner is in use or it could not be prepared (the runner stays in the
+     * pool and releaseCallback is not called).
+     */
+    N_USData_Request_Runner* acquireRequestRunner(N_AI nAi, Mtype mType, const N_USData_Segment* segments,
+                                                  uint8_t segmentCount, N_USData_release_cb_t releaseCallback,
+                                                  void* releaseContext);
+
+    /**
+     * @brief Returns a runner ready to send a message pulled from a data source (see N_USData_Request_Runner::reset()).
+     * @return The runner, or nullptr if every runner is in use or it could not be prepared (the runner stays in the
+     * pool).
+     */
+    N_USData_Request_Runner* acquireRequestRunner(N_AI nAi, Mtype mType, uint32_t messageLength,
+                                                  N_USData_source_cb_t source, void* sourceContext);
+
+    /**
+     * @brief Returns a runner ready to receive a message (see N_USData_Indication_Runner::reset()).
+     * @return The runner, or nullptr if every runner is in use or it could not be prepared (the runner stays in the
+     * pool).
+     */
+    N_USData_Indication_Runner* acquireIndicationRunner(N_AI nAi, uint8_t blockSize, STmin stMin,
+                                                        N_USData_ReceiveBufferProvider rxBufferProvider = {},
+                                                        N_USData_StreamingSink         streamingSink    = {});
+
+    /**
+     * @brief Gives a runner back to the pool, releasing its message. Can be called from any thread.
+     * @param runner A runner returned by acquireRequestRunner() or acquireIndicationRunner().
+     */
+    void release(N_USData_Runner* runner);
+
+    // Only snapshots while other threads acquire or release runners.
+    [[nodiscard]] size_t getIdleRequestRunners() const;
+    [[nodiscard]] size_t getIdleIndicationRunners() const;
+
+    constexpr static const char* TAG = "ISOTP-RunnerPool";
+
+private:
+    template <typename T> T* takeIdleRunner(BoundedMPMCQueue<T*>& idleRunners);
+    template <typename T> void putIdleRunner(BoundedMPMCQueue<T*>& idleRunners, T* runner);
+
+    size_t              capacity;
+    Atomic_int64_t*     availableMemoryForRunners;
+    OSInterface*        osInterface;
+    CANMessageACKQueue* canMessageACKQueue;
+    MemoryArena*        messageArena;
+
+    // At least as large as the capacity, so giving back a runner of the pool never fails.
+    BoundedMPMCQueue<N_USData_Request_Runner*>    idleRequestRunners;
+    BoundedMPMCQueue<N_USData_Indication_Runner*> idleIndicationRunners;
+};
+
+#endif // RUNNERPOOL_H
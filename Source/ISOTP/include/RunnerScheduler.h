@@ -0,0 +1,75 @@
+#ifndef RUNNERSCHEDULER_H
+#define RUNNERSCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "N_USData_Runner.h"
+
+/**
+ * Min-heap of the active runners ordered by their next run time, so a runStep only touches the runners whose deadline
+ * has passed instead of asking every runner for N_USData_Runner::getNextRunTime().
+ *
+ * Deadlines are stored when a runner is scheduled, so a runner must be rescheduled after anything that can change its
+ * next run time (running it, or delivering an ACK to it). Rescheduling or removing a runner does not search the heap:
+ * its previous entry is left behind and discarded when it reaches the top (each entry carries a sequence number and
+ * only the latest one of each runner is valid).
+ */
+class RunnerScheduler
+{
+public:
+    /**
+     * @brief Schedules a runner, replacing its previous deadline if it was already scheduled.
+     * @param runner The runner to schedule.
+     * @param deadline The timestamp after which the runner must run, derived from OSInterface::osMillis().
+     */
+    void schedule(N_USData_Runner* runner, uint32_t deadline);
+
+    /**
+     * @brief Removes a runner from the scheduler. Does nothing if the runner is not scheduled.
+     * @param runner The runner to remove.
+     */
+    void remove(const N_USData_Runner* runner);
+
+    /**
+     * @brief Removes and returns the runner with the earliest deadline if that deadline has passed.
+     * @param now The current timestamp. A runner is due when now is greater than its deadline.
+     * @return The due runner, or nullptr if no runner is due.
+     */
+    [[nodiscard]] N_USData_Runner* popDue(uint32_t now);
+
+    /**
+     * @brief Returns the earliest deadline of the scheduled runners.
+     * @param deadline Set to the earliest deadline if there is any scheduled runner.
+     * @return True if there is any scheduled runner, false otherwise.
+     */
+    [[nodiscard]] bool getNextDeadline(uint32_t& deadline);
+
+    [[nodiscard]] bool isScheduled(const N_USData_Runner* runner) const;
+
+    [[nodiscard]] size_t size() const;
+
+    void clear();
+
+private:
+    using Entry = struct
+    {
+        uint32_t         deadline;
+        uint64_t         sequence;
+        N_USData_Runner* runner;
+    };
+
+    static bool isLater(const Entry& a, const Entry& b);
+
+    [[nodiscard]] bool isStale(const Entry& entry) const;
+    void               discardStaleTop();
+    void               compact();
+
+    std::vector<Entry> heap;
+    // Sequence number of the valid entry of each scheduled runner.
+    std::unordered_map<const N_USData_Runner*, uint64_t> scheduledSequences;
+    uint64_t                                             nextSequence = 0;
+};
+
+#endif // RUNNERSCHEDULER_H
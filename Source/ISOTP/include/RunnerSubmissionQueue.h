@@ -0,0 +1,43 @@
+#ifndef RUNNERSUBMISSIONQUEUE_H
+#define RUNNERSUBMISSIONQUEUE_H
+
+#include <cstddef>
+#include "BoundedMPSCQueue.h"
+#include "N_USData_Runner.h"
+
+/**
+ * Bounded lock-free multi-producer/single-consumer queue of the runners created by ISOTP::N_USData_request() that the
+ * run loop has not taken yet (see BoundedMPSCQueue): a full queue makes push() fail instead of blocking.
+ */
+class RunnerSubmissionQueue
+{
+public:
+    /**
+     * @brief Creates an empty queue.
+     * @param capacity The maximum number of queued runners. It is rounded up to a power of two.
+     */
+    explicit RunnerSubmissionQueue(size_t capacity);
+
+    RunnerSubmissionQueue(const RunnerSubmissionQueue&)            = delete;
+    RunnerSubmissionQueue& operator=(const RunnerSubmissionQueue&) = delete;
+
+    /**
+     * @brief Adds a runner to the queue. Can be called from any thread.
+     * @param runner The runner to add.
+     * @return True if the runner was added, false if the queue is full.
+     */
+    bool push(N_USData_Runner* runner);
+
+    /**
+     * @brief Removes the oldest runner from the queue. Must only be called from one thread at a time.
+     * @return The oldest runner, or nullptr if the queue is empty.
+     */
+    [[nodiscard]] N_USData_Runner* pop();
+
+    [[nodiscard]] size_t capacity() const;
+
+private:
+    BoundedMPSCQueue<N_USData_Runner*> queue;
+};
+
+#endif // RUNNERSUBMISSIONQUEUE_H
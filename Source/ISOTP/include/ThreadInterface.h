@@ -0,0 +1,74 @@
+#ifndef THREADINTERFACE_H
+#define THREADINTERFACE_H
+
+#include <cstdint>
+
+/**
+ * A thread created by ThreadInterface::createThread(). Deleting it after join() releases its resources.
+ */
+class ThreadInterface_Thread
+{
+public:
+    /**
+     * @brief Waits for the function of the thread to return.
+     */
+    virtual void join() = 0;
+
+    virtual ~ThreadInterface_Thread() = default;
+};
+
+/**
+ * A binary semaphore created by ThreadInterface::createSemaphore(), given by one thread to wake up another one.
+ */
+class ThreadInterface_Semaphore
+{
+public:
+    /**
+     * @brief Takes the semaphore, waiting until it is given.
+     * @param timeoutMs The maximum time to wait.
+     * @return True if it was taken, false if the timeout expired.
+     */
+    virtual bool wait(uint32_t timeoutMs) = 0;
+
+    /**
+     * @brief Gives the semaphore. Can be called from any thread, but not from an ISR. Giving it while it is already
+     * given has no effect.
+     */
+    virtual void signal() = 0;
+
+    virtual ~ThreadInterface_Semaphore() = default;
+};
+
+/**
+ * The threads and semaphores of the platform, given by the application to ISOTP so the library does not depend on a
+ * thread library (OSInterface has no thread primitive, and its mutexes can not be given back by another thread). It is
+ * implemented the same way as the OSInterface of the platform, e.g. with pthreads or std::thread on a computer, or with
+ * tasks and semaphores on an RTOS.
+ */
+class ThreadInterface
+{
+public:
+    using ThreadFunction = void (*)(void* arg);
+
+    /**
+     * @brief Creates a thread and starts running function in it.
+     * @param function The function to run. The thread ends when it returns.
+     * @param arg The argument passed to function.
+     * @param priority The priority of the thread. 0 keeps the default of the platform, the meaning of any other
+     * value is platform specific (e.g. a SCHED_FIFO priority or an RTOS task priority).
+     * @param name The name of the thread, for debugging.
+     * @return The thread, or nullptr if it could not be created.
+     */
+    virtual ThreadInterface_Thread* createThread(ThreadFunction function, void* arg, int priority,
+                                                 const char* name) = 0;
+
+    /**
+     * @brief Creates a binary semaphore, not given.
+     * @return The semaphore, or nullptr if it could not be created.
+     */
+    virtual ThreadInterface_Semaphore* createSemaphore() = 0;
+
+    virtual ~ThreadInterface() = default;
+};
+
+#endif // THREADINTERFACE_H
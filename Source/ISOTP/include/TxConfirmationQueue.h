@@ -0,0 +1,54 @@
+#ifndef TXCONFIRMATIONQUEUE_H
+#define TXCONFIRMATIONQUEUE_H
+
+#include <cstddef>
+#include "BoundedMPSCQueue.h"
+#include "CANInterface.h"
+
+/**
+ * Bounded lock-free multi-producer/single-consumer queue of the TX confirmations pushed by a CANInterface (see
+ * CANInterface::setTxConfirmationCallback()) that the CANMessageACKQueue has not stored yet (see BoundedMPSCQueue):
+ * the threads of the driver push without waiting for each other, and a full queue makes push() fail instead of
+ * blocking.
+ */
+class TxConfirmationQueue
+{
+public:
+    /**
+     * @brief Creates an empty queue.
+     * @param capacity The maximum number of queued confirmations. It is rounded up to a power of two.
+     */
+    explicit TxConfirmationQueue(size_t capacity);
+
+    TxConfirmationQueue(const TxConfirmationQueue&)            = delete;
+    TxConfirmationQueue& operator=(const TxConfirmationQueue&) = delete;
+
+    /**
+     * @brief Adds a confirmation to the queue. Can be called from any thread.
+     * @param token The token of the confirmed frame.
+     * @param ack The result of the transmission.
+     * @return True if the confirmation was added, false if the queue is full.
+     */
+    bool push(CANInterface::TxToken token, CANInterface::ACKResult ack);
+
+    /**
+     * @brief Removes the oldest confirmation from the queue. Must only be called from one thread at a time.
+     * @param token Set to the token of the confirmed frame.
+     * @param ack Set to the result of the transmission.
+     * @return True if a confirmation was removed, false if the queue is empty.
+     */
+    [[nodiscard]] bool pop(CANInterface::TxToken& token, CANInterface::ACKResult& ack);
+
+    [[nodiscard]] size_t capacity() const;
+
+private:
+    using TxConfirmation = struct TxConfirmation
+    {
+        CANInterface::TxToken   token;
+        CANInterface::ACKResult ack;
+    };
+
+    BoundedMPSCQueue<TxConfirmation> queue;
+};
+
+#endif // TXCONFIRMATIONQUEUE_H
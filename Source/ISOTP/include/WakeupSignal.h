@@ -0,0 +1,56 @@
+#ifndef WAKEUPSIGNAL_H
+#define WAKEUPSIGNAL_H
+
+#include <atomic>
+#include <cstdint>
+#include "OSInterface.h"
+#include "ThreadInterface.h"
+
+constexpr uint32_t WakeupSignal_PollPeriod_MS = 1; // Of wait() while it has no semaphore.
+
+/**
+ * Lets one thread sleep until another one has work for it.
+ *
+ * A pending flag makes every notification after the first one free until the waiter wakes up. The waiter sleeps on a
+ * ThreadInterface_Semaphore, given by the first notification, once one is set with setSemaphore(). Until then, it only
+ * has the OSInterface and checks the flag every WakeupSignal_PollPeriod_MS.
+ *
+ * @note notify() must not be called from an ISR.
+ */
+class WakeupSignal
+{
+public:
+    explicit WakeupSignal(OSInterface& osInterface);
+
+    ~WakeupSignal();
+
+    WakeupSignal(const WakeupSignal&)            = delete;
+    WakeupSignal& operator=(const WakeupSignal&) = delete;
+
+    /**
+     * @brief Creates the semaphore wait() sleeps on. It does nothing if it is already created.
+     * @warning It must not be called while a thread is in wait(), notify() can be called meanwhile.
+     * @param threadInterface The ThreadInterface the semaphore is created with.
+     * @return True if the semaphore is created, false otherwise (wait() keeps polling).
+     */
+    bool setSemaphore(ThreadInterface& threadInterface);
+
+    /**
+     * @brief Wakes up the waiter, or makes its next wait() return right away. Can be called from any thread.
+     */
+    void notify();
+
+    /**
+     * @brief Sleeps until notify() is called. Must only be called from one thread at a time.
+     * @param timeoutMs The maximum time to sleep.
+     * @return True if it was notified (the notifications are consumed), false if the timeout expired.
+     */
+    bool wait(uint32_t timeoutMs);
+
+private:
+    OSInterface&                            osInterface;
+    std::atomic<ThreadInterface_Semaphore*> semaphore; // nullptr until setSemaphore() is called.
+    std::atomic<bool>                       pending;
+};
+
+#endif // WAKEUPSIGNAL_H
@@ -43,6 +43,16 @@ uint32_t LocalCANNetworkCANInterface::getNodeID() const
     return nodeID;
 }
 
+void LocalCANNetworkCANInterface::notifyNetworkEvent() const
+{
+    notifyWakeup();
+}
+
+LocalCANNetworkCANInterface::~LocalCANNetworkCANInterface()
+{
+    network->disconnect(nodeID);
+}
+
 LocalCANNetwork::LocalCANNetwork()
 {
     this->accessMutex = LinuxOSInterface().osCreateMutex();
@@ -59,8 +69,10 @@ LocalCANNetworkCANInterface* LocalCANNetwork::newCANInterfaceConnection(const ch
     {
         network.emplace_back();
         lastACKQueueList.emplace_back();
+        auto* canInterface = new LocalCANNetworkCANInterface(this, nextNodeID++, tag);
+        interfaces.push_back(canInterface);
         accessMutex->signal();
-        return new LocalCANNetworkCANInterface(this, nextNodeID++, tag);
+        return canInterface;
     }
     return nullptr;
 }
@@ -83,6 +95,14 @@ bool LocalCANNetwork::writeFrame(const uint32_t emitterID, CANFrame* frame)
                     lastACKQueueList[i].push(CANInterface::ACK_SUCCESS); // Simulate successful write
                 }
             }
+            // Every node has either a new frame or a new ACK.
+            for (const auto canInterface : interfaces)
+            {
+                if (canInterface != nullptr)
+                {
+                    canInterface->notifyNetworkEvent();
+                }
+            }
             accessMutex->signal();
             return true;
         }
@@ -165,6 +185,18 @@ bool LocalCANNetwork::checkNodeID(uint32_t nodeID) const
     return nodeID < network.size();
 }
 
+void LocalCANNetwork::disconnect(const uint32_t nodeID)
+{
+    if (accessMutex->wait(maxSyncTimeMS))
+    {
+        if (checkNodeID(nodeID))
+        {
+            interfaces[nodeID] = nullptr;
+        }
+        accessMutex->signal();
+    }
+}
+
 void LocalCANNetwork::overrideActive(bool forceDisable)
 {
     allowActiveFlag = !forceDisable;
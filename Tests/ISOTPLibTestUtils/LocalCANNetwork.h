@@ -74,10 +74,17 @@ public:
 
     void overrideActive(bool forceDisable);
 
+    /**
+     * @brief Disconnect a node so it is no longer notified (Internal use only)
+     * @param nodeID The ID of the node to disconnect
+     */
+    void disconnect(uint32_t nodeID);
+
 private:
     std::vector<std::queue<CANInterface::ACKResult>> lastACKQueueList;
     [[nodiscard]] bool                               checkNodeID(uint32_t nodeID) const;
     std::vector<std::list<CANFrame>>                 network;
+    std::vector<LocalCANNetworkCANInterface*>        interfaces; // Notified on every write, nullptr once deleted.
     uint32_t                                         nextNodeID      = 0;
     bool                                             allowActiveFlag = true;
     OSInterface_Mutex*                               accessMutex     = nullptr;
@@ -98,9 +105,16 @@ public:
 
     [[nodiscard]] uint32_t getNodeID() const;
 
+    /**
+     * @brief Notify the user of the interface that a frame or an ACK is available (Internal use only)
+     */
+    void notifyNetworkEvent() const;
+
     LocalCANNetworkCANInterface(LocalCANNetwork* network, uint32_t nodeID,
                                 const char* tag = "LocalCANNetworkCANInterface");
 
+    ~LocalCANNetworkCANInterface() override;
+
 private:
     const char*      tag;
     LocalCANNetwork* network;
@@ -0,0 +1,67 @@
+#include "StdThreadInterface.h"
+
+#include <cstring>
+#if __has_include(<pthread.h>)
+#include <pthread.h>
+#endif
+#include "OSInterface.h"
+
+StdThreadInterface_Thread::StdThreadInterface_Thread(std::thread&& thread) : thread(std::move(thread))
+{
+}
+
+void StdThreadInterface_Thread::join()
+{
+    if (this->thread.joinable())
+    {
+        this->thread.join();
+    }
+}
+
+ThreadInterface_Thread* StdThreadInterface::createThread(const ThreadFunction function, void* arg, const int priority,
+                                                         const char* name)
+{
+    std::thread thread(function, arg);
+
+    if (priority != 0)
+    {
+#if __has_include(<pthread.h>)
+        sched_param param{};
+        param.sched_priority = priority;
+        if (const int res = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param); res != 0)
+        {
+            OSInterfaceLogWarning(TAG, "Failed to set the priority of the %s thread to %d: %s", name, priority,
+                                  strerror(res));
+        }
+#else
+        OSInterfaceLogWarning(TAG, "Failed to set the priority of the %s thread to %d: not supported", name, priority);
+#endif
+    }
+
+    return new StdThreadInterface_Thread(std::move(thread));
+}
+
+ThreadInterface_Semaphore* StdThreadInterface::createSemaphore()
+{
+    return new StdThreadInterface_Semaphore();
+}
+
+bool StdThreadInterface_Semaphore::wait(const uint32_t timeoutMs)
+{
+    std::unique_lock lock(this->mutex);
+    if (!this->given.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return this->isGiven; }))
+    {
+        return false;
+    }
+    this->isGiven = false;
+    return true;
+}
+
+void StdThreadInterface_Semaphore::signal()
+{
+    {
+        std::lock_guard lock(this->mutex);
+        this->isGiven = true;
+    }
+    this->given.notify_one();
+}
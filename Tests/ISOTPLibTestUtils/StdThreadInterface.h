@@ -0,0 +1,54 @@
+#ifndef DOCANTESTPROJECT_STDTHREADINTERFACE_H
+#define DOCANTESTPROJECT_STDTHREADINTERFACE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "ThreadInterface.h"
+
+/**
+ * @brief A ThreadInterface_Thread backed by a std::thread
+ */
+class StdThreadInterface_Thread : public ThreadInterface_Thread
+{
+public:
+    explicit StdThreadInterface_Thread(std::thread&& thread);
+
+    void join() override;
+
+private:
+    std::thread thread;
+};
+
+/**
+ * @brief A ThreadInterface_Semaphore backed by a std::condition_variable
+ */
+class StdThreadInterface_Semaphore : public ThreadInterface_Semaphore
+{
+public:
+    bool wait(uint32_t timeoutMs) override;
+
+    void signal() override;
+
+private:
+    std::mutex              mutex;
+    std::condition_variable given;
+    bool                    isGiven = false;
+};
+
+/**
+ * @brief A ThreadInterface that creates std::threads and condition variable semaphores, to give to ISOTP in the tests
+ * The priorities other than 0 are set as SCHED_FIFO priorities with pthreads, if available
+ */
+class StdThreadInterface : public ThreadInterface
+{
+public:
+    ThreadInterface_Thread* createThread(ThreadFunction function, void* arg, int priority, const char* name) override;
+
+    ThreadInterface_Semaphore* createSemaphore() override;
+
+private:
+    constexpr static const char* TAG = "StdThreadInterface";
+};
+
+#endif // DOCANTESTPROJECT_STDTHREADINTERFACE_H
@@ -0,0 +1,70 @@
+#include "Atomic_int64_t.h"
+
+#include <thread>
+#include <vector>
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+TEST(Atomic_int64_t, operations)
+{
+    Atomic_int64_t value(10, linuxOSInterface);
+    int64_t        out = 0;
+
+    ASSERT_TRUE(value.get(&out));
+    EXPECT_EQ(10, out);
+
+    EXPECT_TRUE(value.add(5));
+    EXPECT_TRUE(value.sub(3));
+    ASSERT_TRUE(value.get(&out));
+    EXPECT_EQ(12, out);
+
+    EXPECT_TRUE(value.subIfResIsGreaterThanZero(11));
+    EXPECT_FALSE(value.subIfResIsGreaterThanZero(1)); // The result would be 0.
+    ASSERT_TRUE(value.get(&out));
+    EXPECT_EQ(1, out);
+
+    EXPECT_TRUE(value.set(-4));
+    ASSERT_TRUE(value.get(&out));
+    EXPECT_EQ(-4, out);
+}
+
+TEST(Atomic_int64_t, concurrent_subIfResIsGreaterThanZero)
+{
+    constexpr int64_t threads     = 4;
+    constexpr int64_t subsPerCall = 3;
+    constexpr int64_t budget      = 1000;
+
+    Atomic_int64_t           value(budget, linuxOSInterface);
+    std::vector<std::thread> workers;
+    std::vector<int64_t>     successes(threads, 0);
+
+    for (int64_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back(
+            [&, t]
+            {
+                while (value.subIfResIsGreaterThanZero(subsPerCall))
+                {
+                    successes[t]++;
+                }
+            });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    // The budget is never overdrawn, and it is used until another subtraction would take it to 0 or below.
+    int64_t total = 0;
+    for (const int64_t s : successes)
+    {
+        total += s;
+    }
+    int64_t out = 0;
+    ASSERT_TRUE(value.get(&out));
+    EXPECT_EQ(budget - total * subsPerCall, out);
+    EXPECT_GT(out, 0);
+    EXPECT_LE(out, subsPerCall);
+}
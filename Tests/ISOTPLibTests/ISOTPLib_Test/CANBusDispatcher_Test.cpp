@@ -0,0 +1,157 @@
+#include "CANBusDispatcher.h"
+
+#include <ISOTP.h>
+#include <memory>
+#include <N_USData_Runner.h>
+#include "ASSERT_MACROS.h"
+#include "LinuxOSInterface.h"
+#include "StdThreadInterface.h"
+#include "LocalCANNetwork.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface   osInterface;
+static StdThreadInterface threadInterface;
+
+static CANFrame newFrame(const N_AI nAi, const uint8_t firstByte)
+{
+    CANFrame frame         = NewCANFrameISOTP();
+    frame.identifier       = nAi;
+    frame.data[0]          = firstByte;
+    frame.data_length_code = 1;
+    return frame;
+}
+
+TEST(CANBusDispatcher, routesFramesByN_TA)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> busInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    CANBusDispatcher              dispatcher(*busInterface, osInterface);
+
+    CANInterface* connection1 = dispatcher.getCANInterface(1);
+    CANInterface* connection3 = dispatcher.getCANInterface(3);
+    EXPECT_EQ(connection1, dispatcher.getCANInterface(1));
+    EXPECT_NE(connection1, connection3);
+
+    CANFrame toConnection3 = newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 3, 2), 0x13);
+    CANFrame toConnection1 = newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2), 0x11);
+    CANFrame toNobody      = newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 4, 2), 0x14);
+    CANFrame toEverybody   = newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 7, 2), 0x17);
+    ASSERT_TRUE(peerInterface->writeFrame(&toConnection3));
+    ASSERT_TRUE(peerInterface->writeFrame(&toConnection1));
+    ASSERT_TRUE(peerInterface->writeFrame(&toNobody));
+    ASSERT_TRUE(peerInterface->writeFrame(&toEverybody));
+
+    // Reading from one connection reads the bus once for both of them.
+    EXPECT_EQ(2, connection1->frameAvailable());
+    EXPECT_EQ(0, busInterface->frameAvailable());
+
+    CANFrame frame;
+    ASSERT_TRUE(connection1->readFrame(&frame));
+    EXPECT_EQ(0x11, frame.data[0]);
+    ASSERT_TRUE(connection1->readFrame(&frame));
+    EXPECT_EQ(0x17, frame.data[0]);
+    EXPECT_FALSE(connection1->readFrame(&frame));
+
+    ASSERT_TRUE(connection3->readFrame(&frame));
+    EXPECT_EQ_FRAMES(toConnection3, frame);
+    ASSERT_TRUE(connection3->readFrame(&frame));
+    EXPECT_EQ(0x17, frame.data[0]);
+    EXPECT_FALSE(connection3->readFrame(&frame));
+}
+
+TEST(CANBusDispatcher, routesACKsToTheirWriter)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> busInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    CANBusDispatcher              dispatcher(*busInterface, osInterface);
+
+    CANInterface* connection1 = dispatcher.getCANInterface(1);
+    CANInterface* connection3 = dispatcher.getCANInterface(3);
+    EXPECT_TRUE(connection1->active());
+
+    CANFrame frame1 = newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1), 0x21);
+    CANFrame frame3 = newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 3), 0x23);
+    ASSERT_TRUE(connection3->writeFrame(&frame3));
+    ASSERT_TRUE(connection1->writeFrame(&frame1));
+    ASSERT_TRUE(connection1->writeFrame(&frame1));
+
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, connection1->getWriteFrameACK());
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, connection1->getWriteFrameACK());
+    EXPECT_EQ(CANInterface::ACK_NONE, connection1->getWriteFrameACK());
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, connection3->getWriteFrameACK());
+    EXPECT_EQ(CANInterface::ACK_NONE, connection3->getWriteFrameACK());
+    EXPECT_EQ(3, peerInterface->frameAvailable());
+}
+
+static uint32_t Dispatcher_indication_cb_calls = 0;
+static uint32_t Dispatcher_confirm_cb_calls    = 0;
+static N_AI     Dispatcher_lastIndicationN_AI  = {};
+
+static void Dispatcher_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    Dispatcher_confirm_cb_calls++;
+}
+static void Dispatcher_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                     Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    Dispatcher_lastIndicationN_AI = nAi;
+    Dispatcher_indication_cb_calls++;
+}
+static void Dispatcher_FF_indication_cb(const N_AI nAi, const uint32_t messageLength, const Mtype mtype)
+{
+}
+
+TEST(CANBusDispatcher, ISOTPInstancesShareTheBus)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> busInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    CANBusDispatcher              dispatcher(*busInterface, osInterface);
+
+    ISOTP ecu1(1, 2000, Dispatcher_confirm_cb, Dispatcher_indication_cb, Dispatcher_FF_indication_cb, osInterface,
+               *dispatcher.getCANInterface(1), 2, {0, ms}, "ecu1");
+    ISOTP ecu3(3, 2000, Dispatcher_confirm_cb, Dispatcher_indication_cb, Dispatcher_FF_indication_cb, osInterface,
+               *dispatcher.getCANInterface(3), 2, {0, ms}, "ecu3");
+    ISOTP peer(2, 2000, Dispatcher_confirm_cb, Dispatcher_indication_cb, Dispatcher_FF_indication_cb, osInterface,
+               *peerInterface, 2, {0, ms}, "peer");
+    ASSERT_TRUE(ecu1.start(threadInterface));
+    ASSERT_TRUE(ecu3.start(threadInterface));
+    ASSERT_TRUE(peer.start(threadInterface));
+
+    const uint8_t message[] = "A multi frame message for each of the ECUs";
+    for (const typeof(N_AI::N_TA) nTa : {1, 3})
+    {
+        const uint32_t initialIndicationCalls = Dispatcher_indication_cb_calls;
+        const uint32_t initialConfirmCalls    = Dispatcher_confirm_cb_calls;
+        ASSERT_TRUE(peer.N_USData_request(nTa, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+        const uint32_t initialTime = osInterface.osMillis();
+        while ((Dispatcher_indication_cb_calls == initialIndicationCalls ||
+                Dispatcher_confirm_cb_calls == initialConfirmCalls) &&
+               osInterface.osMillis() - initialTime < 2000)
+        {
+            osInterface.osSleep(1);
+        }
+        EXPECT_EQ(initialIndicationCalls + 1, Dispatcher_indication_cb_calls);
+        EXPECT_EQ(initialConfirmCalls + 1, Dispatcher_confirm_cb_calls);
+        EXPECT_EQ(nTa, Dispatcher_lastIndicationN_AI.N_TA);
+    }
+
+    // And the other way around, the ACKs of the shared bus reach the right instance.
+    const uint32_t initialConfirmCalls = Dispatcher_confirm_cb_calls;
+    ASSERT_TRUE(ecu3.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    const uint32_t initialTime = osInterface.osMillis();
+    while (Dispatcher_confirm_cb_calls == initialConfirmCalls && osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    EXPECT_EQ(initialConfirmCalls + 1, Dispatcher_confirm_cb_calls);
+
+    ecu1.stop();
+    ecu3.stop();
+    peer.stop();
+}
@@ -0,0 +1,130 @@
+#include "CANInterface.h"
+
+#include <cstring>
+#include <thread>
+#include <ISOTP.h>
+#include <memory>
+#include "LocalCANNetwork.h"
+#include "gtest/gtest.h"
+
+TEST(CANInterface, nAiToString_buffer)
+{
+    const N_AI nAi1 = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    const N_AI nAi2 = ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 3, 4);
+    char       buffer1[MAX_N_AI_STR_SIZE];
+    char       buffer2[MAX_N_AI_STR_SIZE];
+
+    // Both strings are still valid after the second call.
+    const char* str1 = nAiToString(nAi1, buffer1, sizeof(buffer1));
+    const char* str2 = nAiToString(nAi2, buffer2, sizeof(buffer2));
+    EXPECT_EQ(buffer1, str1);
+    EXPECT_STREQ("{N_SA=2, N_TA=1, N_TAtype=N_TATYPE_5_CAN_CLASSIC_29bit_Physical}", str1);
+    EXPECT_STREQ("{N_SA=4, N_TA=3, N_TAtype=N_TATYPE_6_CAN_CLASSIC_29bit_Functional}", str2);
+    EXPECT_STREQ(str1, nAiToString(nAi1));
+}
+
+TEST(CANInterface, frameToString_buffer)
+{
+    CANFrame frame         = {};
+    frame.extd             = 1;
+    frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    frame.data_length_code = 3;
+    frame.data[0]          = 0x02;
+    frame.data[1]          = 0xAB;
+    frame.data[2]          = 0x0C;
+
+    char dataBuffer[MAX_FRAME_DATA_STR_SIZE];
+    EXPECT_STREQ("02AB0C", frameDataToString(frame.data, frame.data_length_code, dataBuffer, sizeof(dataBuffer)));
+    char shortDataBuffer[4];
+    EXPECT_STREQ("02", frameDataToString(frame.data, frame.data_length_code, shortDataBuffer, sizeof(shortDataBuffer)));
+
+    char frameBuffer[MAX_FRAME_STR_SIZE];
+    EXPECT_STREQ("{N_AI={N_SA=2, N_TA=1, N_TAtype=N_TATYPE_5_CAN_CLASSIC_29bit_Physical}, flags={extd=1, rtr=0, ss=0, "
+                 "self=0, dlc_non_comp=0}, data_length_code=3, data=[0x02AB0C]}",
+                 frameToString(frame, frameBuffer, sizeof(frameBuffer)));
+    EXPECT_STREQ(frameBuffer, frameToString(frame));
+}
+
+TEST(CANInterface, frameToString_concurrent)
+{
+    constexpr uint32_t iterations = 20000;
+
+    auto formatter = [](const typeof(N_AI::N_TA) nTa, bool& ok)
+    {
+        CANFrame frame         = {};
+        frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nTa, 1);
+        frame.data_length_code = 1;
+        frame.data[0]          = nTa;
+
+        char expected[MAX_FRAME_STR_SIZE];
+        char buffer[MAX_FRAME_STR_SIZE];
+        frameToString(frame, expected, sizeof(expected));
+        ok = true;
+        for (uint32_t i = 0; i < iterations && ok; i++)
+        {
+            ok = strcmp(expected, frameToString(frame, buffer, sizeof(buffer))) == 0;
+        }
+    };
+
+    bool        ok1 = false;
+    bool        ok2 = false;
+    std::thread thread1(formatter, 1, std::ref(ok1));
+    std::thread thread2(formatter, 2, std::ref(ok2));
+    thread1.join();
+    thread2.join();
+    EXPECT_TRUE(ok1);
+    EXPECT_TRUE(ok2);
+}
+
+TEST(CANInterface, defaultTxTokensFollowTheWriteOrder)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    CANFrame                      frame = NewCANFrameISOTP();
+    frame.data_length_code              = 1;
+
+    CANInterface::TxToken firstToken;
+    CANInterface::TxToken secondToken;
+    ASSERT_TRUE(canInterface->writeFrameWithToken(&frame, firstToken));
+    ASSERT_TRUE(canInterface->writeFrameWithToken(&frame, secondToken));
+    EXPECT_NE(firstToken, secondToken);
+
+    CANInterface::TxToken token;
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, canInterface->getWriteFrameACKWithToken(token));
+    EXPECT_EQ(firstToken, token);
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, canInterface->getWriteFrameACKWithToken(token));
+    EXPECT_EQ(secondToken, token);
+    EXPECT_EQ(CANInterface::ACK_NONE, canInterface->getWriteFrameACKWithToken(token));
+}
+
+static void CountWakeups(void* context)
+{
+    (*static_cast<uint32_t*>(context))++;
+}
+
+TEST(CANInterface, singleWakeupCallback)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    CANFrame                      frame = NewCANFrameISOTP();
+    frame.data_length_code              = 1;
+    uint32_t firstWakeups               = 0;
+    uint32_t secondWakeups              = 0;
+
+    EXPECT_TRUE(canInterface->setWakeupCallback(CountWakeups, &firstWakeups));
+    EXPECT_FALSE(canInterface->setWakeupCallback(CountWakeups, &secondWakeups));
+    canInterface->clearWakeupCallback(&secondWakeups); // Not the one set, it is kept.
+
+    ASSERT_TRUE(peerInterface->writeFrame(&frame));
+    EXPECT_LT(0, firstWakeups);
+    EXPECT_EQ(0, secondWakeups);
+
+    canInterface->clearWakeupCallback(&firstWakeups);
+    EXPECT_TRUE(canInterface->setWakeupCallback(CountWakeups, &secondWakeups));
+    const uint32_t firstWakeupsBefore = firstWakeups;
+    ASSERT_TRUE(peerInterface->writeFrame(&frame));
+    EXPECT_EQ(firstWakeupsBefore, firstWakeups);
+    EXPECT_LT(0, secondWakeups);
+}
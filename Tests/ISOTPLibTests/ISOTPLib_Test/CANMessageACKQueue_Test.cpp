@@ -4,6 +4,8 @@
 #include <N_USData_Request_Runner.h>
 
 #include <N_USData_Runner.h>
+#include <deque>
+#include <utility>
 #include "ASSERT_MACROS.h"
 #include "LinuxOSInterface.h"
 #include "LocalCANNetwork.h"
@@ -92,3 +94,279 @@ TEST(CANMessageACKQueue, writeFrame)
     delete canInterface;
     delete receivedCanInterface;
 }
+
+/**
+ * CANInterface with several TX mailboxes: every frame written gets the token of a free mailbox (the token is its
+ * index), and the test decides which mailbox finishes transmission first, and whether its ACK is polled or pushed.
+ */
+class MailboxCANInterface : public CANInterface
+{
+public:
+    uint32_t frameAvailable() override
+    {
+        return 0;
+    }
+
+    bool readFrame(CANFrame* frame) override
+    {
+        return false;
+    }
+
+    bool writeFrame(CANFrame* frame) override
+    {
+        TxToken token;
+        return writeFrameWithToken(frame, token);
+    }
+
+    bool active() override
+    {
+        return true;
+    }
+
+    ACKResult getWriteFrameACK() override
+    {
+        TxToken token;
+        return getWriteFrameACKWithToken(token);
+    }
+
+    bool writeFrameWithToken(CANFrame* frame, TxToken& token) override
+    {
+        if (this->freeMailboxes.empty())
+        {
+            token = this->nextMailbox++;
+        }
+        else
+        {
+            token = this->freeMailboxes.front();
+            this->freeMailboxes.pop_front();
+        }
+        return true;
+    }
+
+    ACKResult getWriteFrameACKWithToken(TxToken& token) override
+    {
+        if (this->confirmed.empty())
+        {
+            return ACK_NONE;
+        }
+        token               = this->confirmed.front().first;
+        const ACKResult ack = this->confirmed.front().second;
+        this->confirmed.pop_front();
+        this->freeMailboxes.push_back(token);
+        return ack;
+    }
+
+    void confirm(const TxToken mailbox, const ACKResult ack)
+    {
+        this->confirmed.emplace_back(mailbox, ack);
+    }
+
+    bool push(const TxToken mailbox, const ACKResult ack)
+    {
+        if (!notifyTxConfirmation(mailbox, ack))
+        {
+            confirm(mailbox, ack); // Kept to be polled.
+            return false;
+        }
+        this->freeMailboxes.push_back(mailbox);
+        return true;
+    }
+
+private:
+    TxToken                                   nextMailbox = 0;
+    std::deque<TxToken>                       freeMailboxes;
+    std::deque<std::pair<TxToken, ACKResult>> confirmed;
+};
+
+TEST(CANMessageACKQueue, outOfOrderACKs)
+{
+    // Given
+    MailboxCANInterface canInterface;
+    CANMessageACKQueue  canMessageACKQueue(canInterface, linuxOSInterface);
+    CANFrame            frame = NewCANFrameISOTP();
+
+    int64_t                 availableMemoryConst = 100;
+    Atomic_int64_t          availableMemoryMock(availableMemoryConst, linuxOSInterface);
+    const uint8_t           testMessage[]        = {0};
+    bool                    result;
+    N_USData_Request_Runner runner0(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2),
+                                    availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                    canMessageACKQueue);
+    N_USData_Request_Runner runner1(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 3, 2),
+                                    availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                    canMessageACKQueue);
+    N_USData_Request_Runner runner2(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 4, 2),
+                                    availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                    canMessageACKQueue);
+
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(runner0, frame));
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(runner1, frame));
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(runner2, frame));
+
+    // When the last frame is confirmed first
+    canInterface.confirm(2, CANInterface::ACK_SUCCESS);
+    canInterface.confirm(0, CANInterface::ACK_ERROR);
+    EXPECT_TRUE(canMessageACKQueue.runStep());
+    EXPECT_FALSE(canMessageACKQueue.runStep());
+
+    // Want the callbacks in ACK order, without waiting for the frame written before.
+    std::vector<N_USData_Runner*> ackedRunners;
+    canMessageACKQueue.runAvailableAckCallbacks(ackedRunners);
+    ASSERT_EQ(2, ackedRunners.size());
+    EXPECT_EQ(&runner2, ackedRunners[0]);
+    EXPECT_EQ(&runner0, ackedRunners[1]);
+
+    // The frame not confirmed is still waiting.
+    EXPECT_FALSE(canMessageACKQueue.removeFromQueue(runner0.getN_AI()));
+    EXPECT_TRUE(canMessageACKQueue.removeFromQueue(runner1.getN_AI()));
+}
+
+TEST(CANMessageACKQueue, removedRunnerIgnoresItsACK)
+{
+    // Given
+    MailboxCANInterface canInterface;
+    CANMessageACKQueue  canMessageACKQueue(canInterface, linuxOSInterface);
+    CANFrame            frame = NewCANFrameISOTP();
+
+    int64_t                 availableMemoryConst = 100;
+    Atomic_int64_t          availableMemoryMock(availableMemoryConst, linuxOSInterface);
+    const uint8_t           testMessage[]        = {0};
+    bool                    result;
+    N_USData_Request_Runner runner(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2),
+                                   availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                   canMessageACKQueue);
+
+    // When the runner is removed after its ACK was stored
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(runner, frame));
+    canInterface.confirm(0, CANInterface::ACK_SUCCESS);
+    EXPECT_TRUE(canMessageACKQueue.runStep());
+    EXPECT_TRUE(canMessageACKQueue.removeFromQueue(runner.getN_AI()));
+
+    // Want no callback
+    std::vector<N_USData_Runner*> ackedRunners;
+    canMessageACKQueue.runAvailableAckCallbacks(ackedRunners);
+    EXPECT_TRUE(ackedRunners.empty());
+}
+
+TEST(CANMessageACKQueue, full)
+{
+    // Given
+    MailboxCANInterface canInterface;
+    CANMessageACKQueue  canMessageACKQueue(canInterface, linuxOSInterface);
+    CANFrame            frame = NewCANFrameISOTP();
+
+    int64_t                 availableMemoryConst = 100;
+    Atomic_int64_t          availableMemoryMock(availableMemoryConst, linuxOSInterface);
+    const uint8_t           testMessage[]        = {0};
+    bool                    result;
+    N_USData_Request_Runner runner(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2),
+                                   availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                   canMessageACKQueue);
+
+    for (size_t i = 0; i < CANMessageACKQueue_Capacity; i++)
+    {
+        ASSERT_TRUE(canMessageACKQueue.writeFrame(runner, frame));
+    }
+
+    // Want the next frame rejected until an ACK frees a slot.
+    EXPECT_FALSE(canMessageACKQueue.writeFrame(runner, frame));
+
+    canInterface.confirm(5, CANInterface::ACK_SUCCESS);
+    EXPECT_TRUE(canMessageACKQueue.runStep());
+    canMessageACKQueue.runAvailableAckCallbacks();
+    EXPECT_TRUE(canMessageACKQueue.writeFrame(runner, frame));
+}
+
+TEST(CANMessageACKQueue, removedRunnerFreesItsSlots)
+{
+    // Given
+    MailboxCANInterface canInterface;
+    CANMessageACKQueue  canMessageACKQueue(canInterface, linuxOSInterface);
+    CANFrame            frame = NewCANFrameISOTP();
+
+    int64_t                 availableMemoryConst = 100;
+    Atomic_int64_t          availableMemoryMock(availableMemoryConst, linuxOSInterface);
+    const uint8_t           testMessage[]        = {0};
+    const N_AI              nAi                  = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    bool                    result;
+    N_USData_Request_Runner runner(result, nAi, availableMemoryMock, Mtype_Diagnostics, testMessage, 0,
+                                   linuxOSInterface, canMessageACKQueue);
+    N_USData_Request_Runner sameNAiRunner(result, nAi, availableMemoryMock, Mtype_Diagnostics, testMessage, 0,
+                                          linuxOSInterface, canMessageACKQueue);
+
+    // When the ACKs of all the frames of a runner never arrive (e.g. the bus went inactive)
+    for (size_t i = 1; i < CANMessageACKQueue_Capacity; i++)
+    {
+        ASSERT_TRUE(canMessageACKQueue.writeFrame(runner, frame));
+    }
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(sameNAiRunner, frame));
+    EXPECT_FALSE(canMessageACKQueue.writeFrame(runner, frame));
+
+    // Want removing the runner to free its slots, but not the ones of another runner with the same N_AI.
+    EXPECT_TRUE(canMessageACKQueue.removeFromQueue(runner));
+    EXPECT_FALSE(canMessageACKQueue.removeFromQueue(runner));
+    EXPECT_TRUE(canMessageACKQueue.waitingForAcks());
+    for (size_t i = 1; i < CANMessageACKQueue_Capacity; i++)
+    {
+        ASSERT_TRUE(canMessageACKQueue.writeFrame(runner, frame));
+    }
+    EXPECT_TRUE(canMessageACKQueue.removeFromQueue(runner));
+
+    canInterface.confirm(CANMessageACKQueue_Capacity - 1, CANInterface::ACK_SUCCESS);
+    EXPECT_TRUE(canMessageACKQueue.runStep());
+    std::vector<N_USData_Runner*> ackedRunners;
+    canMessageACKQueue.runAvailableAckCallbacks(ackedRunners);
+    ASSERT_EQ(1, ackedRunners.size());
+    EXPECT_EQ(&sameNAiRunner, ackedRunners[0]);
+    EXPECT_FALSE(canMessageACKQueue.waitingForAcks());
+}
+
+TEST(CANMessageACKQueue, pushedACKs)
+{
+    // Given
+    MailboxCANInterface canInterface;
+    CANMessageACKQueue  canMessageACKQueue(canInterface, linuxOSInterface);
+    CANFrame            frame = NewCANFrameISOTP();
+
+    int64_t                 availableMemoryConst = 100;
+    Atomic_int64_t          availableMemoryMock(availableMemoryConst, linuxOSInterface);
+    const uint8_t           testMessage[]        = {0};
+    bool                    result;
+    N_USData_Request_Runner runner0(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2),
+                                    availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                    canMessageACKQueue);
+    N_USData_Request_Runner runner1(result, ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 3, 2),
+                                    availableMemoryMock, Mtype_Diagnostics, testMessage, 0, linuxOSInterface,
+                                    canMessageACKQueue);
+
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(runner0, frame));
+    ASSERT_TRUE(canMessageACKQueue.writeFrame(runner1, frame));
+
+    // When the driver pushes the ACK of the second frame
+    EXPECT_TRUE(canInterface.push(1, CANInterface::ACK_SUCCESS));
+
+    // Want its callback without polling the CANInterface
+    std::vector<N_USData_Runner*> ackedRunners;
+    canMessageACKQueue.runAvailableAckCallbacks(ackedRunners);
+    ASSERT_EQ(1, ackedRunners.size());
+    EXPECT_EQ(&runner1, ackedRunners[0]);
+    EXPECT_FALSE(canMessageACKQueue.runStep());
+}
+
+TEST(CANMessageACKQueue, pushedACKsFallBackToPolling)
+{
+    MailboxCANInterface   canInterface;
+    CANFrame              frame = NewCANFrameISOTP();
+    CANInterface::TxToken token;
+    ASSERT_TRUE(canInterface.writeFrameWithToken(&frame, token));
+
+    {
+        CANMessageACKQueue canMessageACKQueue(canInterface, linuxOSInterface);
+    }
+
+    // Without a CANMessageACKQueue registered, the driver keeps its ACKs to be polled.
+    EXPECT_FALSE(canInterface.push(token, CANInterface::ACK_SUCCESS));
+    CANInterface::TxToken polledToken;
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, canInterface.getWriteFrameACKWithToken(polledToken));
+    EXPECT_EQ(token, polledToken);
+}
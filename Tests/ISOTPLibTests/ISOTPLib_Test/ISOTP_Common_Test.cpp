@@ -29,3 +29,16 @@ TEST(ISOTP_Common, getStMinInMs)
     STmin stMin3{.value = 0, .unit = usX100};
     EXPECT_EQ(0, getStMinInMs(stMin3));
 }
+
+TEST(ISOTP_Common, STminToString)
+{
+    char msBuffer[MAX_STMIN_STR_SIZE];
+    char usBuffer[MAX_STMIN_STR_SIZE];
+
+    const char* msStr = STminToString({.value = 127, .unit = ms}, msBuffer, sizeof(msBuffer));
+    const char* usStr = STminToString({.value = 9, .unit = usX100}, usBuffer, sizeof(usBuffer));
+    EXPECT_EQ(msBuffer, msStr);
+    EXPECT_STREQ("127 ms", msStr);
+    EXPECT_STREQ("900 us", usStr);
+    EXPECT_STREQ("5 ms", STminToString({.value = 5, .unit = ms}));
+}
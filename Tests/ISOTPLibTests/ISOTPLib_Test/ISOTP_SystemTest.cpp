@@ -1,11 +1,15 @@
 #include "ISOTP.h"
 
 #include <LocalCANNetwork.h>
+#include <atomic>
+#include <thread>
 #include "ASSERT_MACROS.h"
 #include "LinuxOSInterface.h"
+#include "StdThreadInterface.h"
 #include "gtest/gtest.h"
 
 static LinuxOSInterface   osInterface;
+static StdThreadInterface threadInterface;
 constexpr uint32_t DEFAULT_TIMEOUT = 10000;
 
 volatile bool senderKeepRunning   = true;
@@ -453,7 +457,7 @@ void            ManySendReceiveTestBroadcast_N_USData_confirm_cb(N_AI nAi, N_Res
 
     if (ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls == 2)
     {
-        N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 2, .N_SA = 1};
+        N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 3, .N_SA = 1};
         EXPECT_EQ_N_AI(expectedNAi, nAi);
         EXPECT_EQ(N_OK, nResult);
         EXPECT_EQ(Mtype_Diagnostics, mtype);
@@ -464,7 +468,7 @@ void            ManySendReceiveTestBroadcast_N_USData_confirm_cb(N_AI nAi, N_Res
 
     if (ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls == 1)
     {
-        N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 3, .N_SA = 1};
+        N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 2, .N_SA = 1};
         EXPECT_EQ_N_AI(expectedNAi, nAi);
         EXPECT_EQ(N_OK, nResult);
         EXPECT_EQ(Mtype_Diagnostics, mtype);
@@ -479,7 +483,9 @@ void ManySendReceiveTestBroadcast_N_USData_indication_cb(N_AI nAi, const uint8_t
 {
     ManySendReceiveTestBroadcast_N_USData_indication_cb_calls++;
 
-    if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 1)
+    // The requests are sent in the order they were issued: receiverISOTP1 receives both messages before
+    // receiverISOTP2 runs and receives the first one.
+    if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 2)
     {
         N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 3, .N_SA = 1};
         EXPECT_EQ(N_OK, nResult);
@@ -491,7 +497,7 @@ void ManySendReceiveTestBroadcast_N_USData_indication_cb(N_AI nAi, const uint8_t
         EXPECT_EQ_ARRAY(ManySendReceiveTestBroadcast_message2, messageData,
                         ManySendReceiveTestBroadcast_messageLength2);
 
-        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "First call");
+        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "Second call");
     }
     else if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls <= 3)
     {
@@ -505,9 +511,9 @@ void ManySendReceiveTestBroadcast_N_USData_indication_cb(N_AI nAi, const uint8_t
         EXPECT_EQ_ARRAY(ManySendReceiveTestBroadcast_message1, messageData,
                         ManySendReceiveTestBroadcast_messageLength1);
 
-        if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 2)
+        if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 1)
         {
-            OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "Second call");
+            OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "First call");
         }
         else if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 3)
         {
@@ -1079,7 +1085,7 @@ TEST(ISOTP_SystemTests, LowMemorySenderTestSF)
     CANInterface*   senderInterface   = network.newCANInterfaceConnection("senderInterface");
     CANInterface*   receiverInterface = network.newCANInterfaceConnection("receiverInterface");
     ISOTP*       senderISOTP =
-        new ISOTP(1, 100, LowMemorySenderTestSF_N_USData_confirm_cb, LowMemorySenderTestSF_N_USData_indication_cb,
+        new ISOTP(1, 5, LowMemorySenderTestSF_N_USData_confirm_cb, LowMemorySenderTestSF_N_USData_indication_cb,
                      LowMemorySenderTestSF_N_USData_FF_indication_cb, osInterface, *senderInterface, 2,
                      ISOTP_DefaultSTmin, "senderISOTP");
     ISOTP* receiverISOTP =
@@ -1180,7 +1186,7 @@ TEST(ISOTP_SystemTests, LowMemoryReceiverTestSF)
                      LowMemoryReceiverTestSF_N_USData_indication_cb, LowMemoryReceiverTestSF_N_USData_FF_indication_cb,
                      osInterface, *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP");
     ISOTP* receiverISOTP =
-        new ISOTP(2, 100, LowMemoryReceiverTestSF_N_USData_confirm_cb,
+        new ISOTP(2, 5, LowMemoryReceiverTestSF_N_USData_confirm_cb,
                      LowMemoryReceiverTestSF_N_USData_indication_cb, LowMemoryReceiverTestSF_N_USData_FF_indication_cb,
                      osInterface, *receiverInterface, 2, ISOTP_DefaultSTmin, "receiverISOTP");
 
@@ -1273,7 +1279,7 @@ TEST(ISOTP_SystemTests, LowMemorySenderTestMF)
     CANInterface*   senderInterface   = network.newCANInterfaceConnection();
     CANInterface*   receiverInterface = network.newCANInterfaceConnection();
     ISOTP*       senderISOTP =
-        new ISOTP(1, 100, LowMemorySenderTestMF_N_USData_confirm_cb, LowMemorySenderTestMF_N_USData_indication_cb,
+        new ISOTP(1, 5, LowMemorySenderTestMF_N_USData_confirm_cb, LowMemorySenderTestMF_N_USData_indication_cb,
                      LowMemorySenderTestMF_N_USData_FF_indication_cb, osInterface, *senderInterface, 2,
                      ISOTP_DefaultSTmin, "senderISOTP");
     ISOTP* receiverISOTP =
@@ -1378,7 +1384,7 @@ TEST(ISOTP_SystemTests, LowMemoryReceiverTestMF)
                      LowMemoryReceiverTestMF_N_USData_indication_cb, LowMemoryReceiverTestMF_N_USData_FF_indication_cb,
                      osInterface, *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP");
     ISOTP* receiverISOTP =
-        new ISOTP(2, 100, LowMemoryReceiverTestMF_N_USData_confirm_cb,
+        new ISOTP(2, 5, LowMemoryReceiverTestMF_N_USData_confirm_cb,
                      LowMemoryReceiverTestMF_N_USData_indication_cb, LowMemoryReceiverTestMF_N_USData_FF_indication_cb,
                      osInterface, *receiverInterface, 2, ISOTP_DefaultSTmin, "receiverISOTP");
 
@@ -2431,3 +2437,214 @@ TEST(ISOTP_SystemTests, MessageExchangeMF)
     delete interface2;
 }
 // END MessageExchangeMF
+
+// EventDrivenSendReceiveTestMF
+constexpr char     EventDrivenSendReceiveTestMF_message[]     = "01234567890123456789";
+constexpr uint32_t EventDrivenSendReceiveTestMF_messageLength = 21;
+constexpr STmin    EventDrivenSendReceiveTestMF_STmin         = {10, ms};
+
+static uint32_t EventDrivenSendReceiveTestMF_N_USData_confirm_cb_calls = 0;
+void            EventDrivenSendReceiveTestMF_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    EventDrivenSendReceiveTestMF_N_USData_confirm_cb_calls++;
+
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+
+    OSInterfaceLogInfo("EventDrivenSendReceiveTestMF_N_USData_confirm_cb", "SenderKeepRunning set to false");
+    senderKeepRunning = false;
+}
+
+static uint32_t EventDrivenSendReceiveTestMF_N_USData_indication_cb_calls = 0;
+void EventDrivenSendReceiveTestMF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                         N_Result nResult, Mtype mtype)
+{
+    EventDrivenSendReceiveTestMF_N_USData_indication_cb_calls++;
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(EventDrivenSendReceiveTestMF_messageLength, messageLength);
+    ASSERT_NE(nullptr, messageData);
+    ASSERT_EQ_ARRAY(EventDrivenSendReceiveTestMF_message, messageData, EventDrivenSendReceiveTestMF_messageLength);
+
+    OSInterfaceLogInfo("EventDrivenSendReceiveTestMF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+    receiverKeepRunning = false;
+}
+
+static uint32_t EventDrivenSendReceiveTestMF_N_USData_FF_indication_cb_calls = 0;
+void            EventDrivenSendReceiveTestMF_N_USData_FF_indication_cb(const N_AI nAi, const uint32_t messageLength,
+                                                                       const Mtype mtype)
+{
+    EventDrivenSendReceiveTestMF_N_USData_FF_indication_cb_calls++;
+}
+
+// Each ISOTP runs in its own thread with runUntil(), sleeping between frames instead of spinning runStep().
+TEST(ISOTP_SystemTests, EventDrivenSendReceiveTestMF)
+{
+    constexpr uint32_t TIMEOUT = 10000;
+    constexpr uint32_t SLICE   = 10; // runUntil() returns every SLICE ms to check if the test is over.
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+
+    LocalCANNetwork network;
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection();
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection();
+    ISOTP*          senderISOTP       = new ISOTP(1, 2000, EventDrivenSendReceiveTestMF_N_USData_confirm_cb,
+                                                  EventDrivenSendReceiveTestMF_N_USData_indication_cb,
+                                                  EventDrivenSendReceiveTestMF_N_USData_FF_indication_cb, osInterface,
+                                                  *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP");
+    ISOTP*          receiverISOTP     = new ISOTP(2, 2000, EventDrivenSendReceiveTestMF_N_USData_confirm_cb,
+                                                  EventDrivenSendReceiveTestMF_N_USData_indication_cb,
+                                                  EventDrivenSendReceiveTestMF_N_USData_FF_indication_cb, osInterface,
+                                                  *receiverInterface, 2, EventDrivenSendReceiveTestMF_STmin,
+                                                  "receiverISOTP");
+
+    uint32_t initialTime = osInterface.osMillis();
+
+    std::thread senderThread(
+        [senderISOTP, initialTime]
+        {
+            while (senderKeepRunning && osInterface.osMillis() - initialTime < TIMEOUT)
+            {
+                senderISOTP->runUntil(osInterface.osMillis() + SLICE);
+            }
+        });
+    std::thread receiverThread(
+        [receiverISOTP, initialTime]
+        {
+            while (receiverKeepRunning && osInterface.osMillis() - initialTime < TIMEOUT)
+            {
+                receiverISOTP->runUntil(osInterface.osMillis() + SLICE);
+            }
+        });
+
+    osInterface.osSleep(SLICE);
+    EXPECT_TRUE(senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                              reinterpret_cast<const uint8_t*>(EventDrivenSendReceiveTestMF_message),
+                                              EventDrivenSendReceiveTestMF_messageLength, Mtype_Diagnostics));
+
+    senderThread.join();
+    receiverThread.join();
+    uint32_t elapsedTime = osInterface.osMillis() - initialTime;
+
+    EXPECT_EQ(1, EventDrivenSendReceiveTestMF_N_USData_FF_indication_cb_calls);
+    EXPECT_EQ(1, EventDrivenSendReceiveTestMF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(1, EventDrivenSendReceiveTestMF_N_USData_indication_cb_calls);
+
+    // The 2 CFs of each block are separated by the receiver STmin.
+    EXPECT_GE(elapsedTime, SLICE + EventDrivenSendReceiveTestMF_STmin.value);
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+// END EventDrivenSendReceiveTestMF
+
+// WorkersSendReceiveTest
+constexpr char     WorkersSendReceiveTest_slowMessage[]     = "slow";
+constexpr uint32_t WorkersSendReceiveTest_slowMessageLength = 5;
+constexpr char     WorkersSendReceiveTest_message[]         = "01234567890123456789";
+constexpr uint32_t WorkersSendReceiveTest_messageLength     = 21;
+constexpr uint32_t WorkersSendReceiveTest_slowCallback_MS   = 500;
+
+static std::atomic<uint32_t> WorkersSendReceiveTest_N_USData_confirm_cb_calls    = 0;
+static std::atomic<uint32_t> WorkersSendReceiveTest_N_USData_indication_cb_calls = 0;
+static std::atomic<bool>     WorkersSendReceiveTest_slowCallbackRunning          = false;
+
+void WorkersSendReceiveTest_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    if (++WorkersSendReceiveTest_N_USData_confirm_cb_calls == 2)
+    {
+        // The MF message was sent (FC and CFs handled by the receiver) while its previous indication was running.
+        EXPECT_TRUE(WorkersSendReceiveTest_slowCallbackRunning);
+        senderKeepRunning = false;
+    }
+}
+
+void WorkersSendReceiveTest_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                   N_Result nResult, Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    if (++WorkersSendReceiveTest_N_USData_indication_cb_calls == 1)
+    {
+        ASSERT_EQ(WorkersSendReceiveTest_slowMessageLength, messageLength);
+        EXPECT_EQ_ARRAY(WorkersSendReceiveTest_slowMessage, messageData, WorkersSendReceiveTest_slowMessageLength);
+
+        WorkersSendReceiveTest_slowCallbackRunning = true;
+        osInterface.osSleep(WorkersSendReceiveTest_slowCallback_MS);
+        WorkersSendReceiveTest_slowCallbackRunning = false;
+    }
+    else
+    {
+        ASSERT_EQ(WorkersSendReceiveTest_messageLength, messageLength);
+        EXPECT_EQ_ARRAY(WorkersSendReceiveTest_message, messageData, WorkersSendReceiveTest_messageLength);
+        receiverKeepRunning = false;
+    }
+}
+
+void WorkersSendReceiveTest_N_USData_FF_indication_cb(const N_AI nAi, const uint32_t messageLength, const Mtype mtype)
+{
+}
+
+// Both ISOTPs run on their own workers. The receiver is stuck in a slow indication callback while the sender sends it a
+// MF message, which must still complete in time because the RX worker keeps handling the frames.
+TEST(ISOTP_SystemTests, WorkersSendReceiveTest)
+{
+    constexpr uint32_t TIMEOUT = 10000;
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+
+    LocalCANNetwork network;
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection();
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection();
+    ISOTP*          senderISOTP       = new ISOTP(1, 2000, WorkersSendReceiveTest_N_USData_confirm_cb,
+                                                  WorkersSendReceiveTest_N_USData_indication_cb,
+                                                  WorkersSendReceiveTest_N_USData_FF_indication_cb, osInterface,
+                                                  *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP");
+    ISOTP*          receiverISOTP     = new ISOTP(2, 2000, WorkersSendReceiveTest_N_USData_confirm_cb,
+                                                  WorkersSendReceiveTest_N_USData_indication_cb,
+                                                  WorkersSendReceiveTest_N_USData_FF_indication_cb, osInterface,
+                                                  *receiverInterface, 2, ISOTP_DefaultSTmin, "receiverISOTP");
+
+    ASSERT_TRUE(senderISOTP->start(threadInterface));
+    ASSERT_TRUE(receiverISOTP->start(threadInterface));
+
+    uint32_t initialTime = osInterface.osMillis();
+
+    EXPECT_TRUE(senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                              reinterpret_cast<const uint8_t*>(WorkersSendReceiveTest_slowMessage),
+                                              WorkersSendReceiveTest_slowMessageLength, Mtype_Diagnostics));
+    while (!WorkersSendReceiveTest_slowCallbackRunning && osInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        osInterface.osSleep(1);
+    }
+    EXPECT_TRUE(senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                              reinterpret_cast<const uint8_t*>(WorkersSendReceiveTest_message),
+                                              WorkersSendReceiveTest_messageLength, Mtype_Diagnostics));
+
+    while ((senderKeepRunning || receiverKeepRunning) && osInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        osInterface.osSleep(1);
+    }
+    uint32_t elapsedTime = osInterface.osMillis() - initialTime;
+
+    senderISOTP->stop();
+    receiverISOTP->stop();
+
+    EXPECT_EQ(2, WorkersSendReceiveTest_N_USData_confirm_cb_calls);
+    EXPECT_EQ(2, WorkersSendReceiveTest_N_USData_indication_cb_calls);
+
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+// END WorkersSendReceiveTest
@@ -1,11 +1,18 @@
 #include "ISOTP.h"
 
 #include <LocalCANNetwork.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
 #include "ASSERT_MACROS.h"
 #include "LinuxOSInterface.h"
+#include "StdThreadInterface.h"
 #include "gtest/gtest.h"
 
-static LinuxOSInterface osInterface;
+static LinuxOSInterface   osInterface;
+static StdThreadInterface threadInterface;
 
 static uint32_t Dummy_N_USData_confirm_cb_calls = 0;
 void            Dummy_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
@@ -36,34 +43,49 @@ void            Dummy_N_USData_FF_indication_cb(const N_AI nAi, const uint32_t m
 
 TEST(ISOTP, getN_SA)
 {
-    LocalCANNetwork canNetwork;
-    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
 
     ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
                       osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
 
     EXPECT_EQ(ISOTP.getN_SA(), 1);
-
-    delete canInterface;
 }
 
 TEST(ISOTP, getTag)
 {
-    LocalCANNetwork canNetwork;
-    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
 
     ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
                       osInterface, *canInterface, 2, ISOTP_DefaultSTmin, "TestISOTP");
 
     EXPECT_STREQ(ISOTP.getTag(), "TestISOTP");
+}
+
+static void Ignored_wakeup_cb(void* context)
+{
+}
+
+TEST(ISOTP, sharedCANInterfaceWakeupCallback)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
 
-    delete canInterface;
+    ISOTP first(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin, "firstISOTP");
+    {
+        // The callback of the first one is kept, and destroying the second one does not unregister it.
+        ISOTP second(2, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                     osInterface, *canInterface, 2, ISOTP_DefaultSTmin, "secondISOTP");
+    }
+    EXPECT_FALSE(canInterface->setWakeupCallback(Ignored_wakeup_cb, nullptr));
 }
 
 TEST(ISOTP, AcceptedFunctionalN_TA)
 {
-    LocalCANNetwork canNetwork;
-    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
 
     ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
                       osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
@@ -76,13 +98,116 @@ TEST(ISOTP, AcceptedFunctionalN_TA)
 
     EXPECT_FALSE(ISOTP.removeAcceptedFunctionalN_TA(2));
 
-    delete canInterface;
+    // Every N_TA can be accepted, independently of the others.
+    ISOTP.addAcceptedFunctionalN_TA(0);
+    ISOTP.addAcceptedFunctionalN_TA(255);
+    EXPECT_TRUE(ISOTP.hasAcceptedFunctionalN_TA(0));
+    EXPECT_TRUE(ISOTP.hasAcceptedFunctionalN_TA(255));
+    EXPECT_FALSE(ISOTP.hasAcceptedFunctionalN_TA(1));
+    EXPECT_FALSE(ISOTP.hasAcceptedFunctionalN_TA(254));
+    EXPECT_TRUE(ISOTP.removeAcceptedFunctionalN_TA(255));
+    EXPECT_TRUE(ISOTP.hasAcceptedFunctionalN_TA(0));
+}
+
+TEST(ISOTP, AcceptedPhysicalN_SA)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    // The N_SA given to the constructor is always accepted.
+    EXPECT_TRUE(ISOTP.hasAcceptedPhysicalN_SA(1));
+    EXPECT_FALSE(ISOTP.removeAcceptedPhysicalN_SA(1));
+    EXPECT_TRUE(ISOTP.hasAcceptedPhysicalN_SA(1));
+
+    ISOTP.addAcceptedPhysicalN_SA(3);
+    EXPECT_TRUE(ISOTP.hasAcceptedPhysicalN_SA(3));
+    EXPECT_FALSE(ISOTP.hasAcceptedPhysicalN_SA(2));
+    EXPECT_EQ(1, ISOTP.getN_SA());
+
+    const uint8_t message[] = "Hi";
+    EXPECT_TRUE(ISOTP.N_USData_request(3, 2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    EXPECT_FALSE(ISOTP.N_USData_request(4, 2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    EXPECT_TRUE(ISOTP.removeAcceptedPhysicalN_SA(3));
+    EXPECT_FALSE(ISOTP.hasAcceptedPhysicalN_SA(3));
+    EXPECT_FALSE(ISOTP.removeAcceptedPhysicalN_SA(3));
+    EXPECT_FALSE(ISOTP.N_USData_request(3, 2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+}
+
+TEST(ISOTP, RunnerPoolCapacity)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin, "ISOTP", false, 2);
+
+    // Every queued request holds a runner until it is sent, and no runner is created past the capacity.
+    const uint8_t message[] = "Hi";
+    EXPECT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    EXPECT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    EXPECT_FALSE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+}
+
+TEST(ISOTP, DefaultRunnerPoolCapacity)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    // By default, the pool does not cap the requests below what the submission queue holds.
+    const uint8_t message[] = "Hi";
+    for (size_t i = 0; i < ISOTP_SubmissionQueueCapacity; i++)
+    {
+        EXPECT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    }
+    EXPECT_FALSE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+}
+
+TEST(ISOTP, multiplePhysicalN_SAs)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+    ISOTP.addAcceptedPhysicalN_SA(3);
+    class ISOTP peer(2, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                     osInterface, *peerInterface, 2, ISOTP_DefaultSTmin);
+    ASSERT_TRUE(ISOTP.start(threadInterface));
+    ASSERT_TRUE(peer.start(threadInterface));
+
+    // Multi-frame messages in both directions, so the Flow Control frames must reach the right instance too.
+    const uint8_t  message[]              = "A multi frame message for an extra N_SA";
+    const uint32_t initialIndicationCalls = Dummy_N_USData_indication_cb_calls;
+    const uint32_t initialConfirmCalls    = Dummy_N_USData_confirm_cb_calls;
+    ASSERT_TRUE(peer.N_USData_request(3, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    ASSERT_TRUE(ISOTP.N_USData_request(3, 2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    const uint32_t initialTime = osInterface.osMillis();
+    while ((Dummy_N_USData_indication_cb_calls < initialIndicationCalls + 2 ||
+            Dummy_N_USData_confirm_cb_calls < initialConfirmCalls + 2) &&
+           osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    ISOTP.stop();
+    peer.stop();
+
+    EXPECT_EQ(initialIndicationCalls + 2, Dummy_N_USData_indication_cb_calls);
+    EXPECT_EQ(initialConfirmCalls + 2, Dummy_N_USData_confirm_cb_calls);
 }
 
 TEST(ISOTP, BlockSize)
 {
-    LocalCANNetwork canNetwork;
-    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
 
     ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
                       osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
@@ -91,14 +216,12 @@ TEST(ISOTP, BlockSize)
 
     EXPECT_TRUE(ISOTP.setBlockSize(3));
     EXPECT_EQ(ISOTP.getBlockSize(), 3);
-
-    delete canInterface;
 }
 
 TEST(ISOTP, STmin)
 {
-    LocalCANNetwork canNetwork;
-    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
 
     ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
                       osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
@@ -124,6 +247,940 @@ TEST(ISOTP, STmin)
     STmin invalidSTmin3 = {128, ms};
     EXPECT_FALSE(ISOTP.setSTmin(invalidSTmin3));
     EXPECT_EQ_STMIN(ISOTP_DefaultSTmin, ISOTP.getSTmin());
+}
+
+TEST(ISOTP, MaxFramesPerStep)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    EXPECT_EQ(ISOTP.getMaxFramesPerStep(), ISOTP_DefaultMaxFramesPerStep);
+
+    ISOTP.setMaxFramesPerStep(4);
+    EXPECT_EQ(ISOTP.getMaxFramesPerStep(), 4);
+
+    ISOTP.setMaxFramesPerStep(0);
+    EXPECT_EQ(ISOTP.getMaxFramesPerStep(), 0);
+}
+
+TEST(ISOTP, PollAcksInRunStep)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    EXPECT_FALSE(ISOTP.getPollAcksInRunStep());
+
+    ISOTP.setPollAcksInRunStep(true);
+    EXPECT_TRUE(ISOTP.getPollAcksInRunStep());
+
+    ISOTP.setPollAcksInRunStep(false);
+    EXPECT_FALSE(ISOTP.getPollAcksInRunStep());
+}
+
+TEST(ISOTP, runStepPollsAcks)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> senderInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> receiverInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP sender(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *senderInterface, 2, {0, ms});
+    ISOTP receiver(2, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *receiverInterface, 2, {0, ms});
+    sender.setPollAcksInRunStep(true);
+    receiver.setPollAcksInRunStep(true);
+
+    // Without canMessageACKQueueRunStep() the ACKs of the FF and the FCs are only stored by the runSteps.
+    const uint8_t  message[]              = "A multi frame message sent only with runStep calls";
+    const uint32_t initialIndicationCalls = Dummy_N_USData_indication_cb_calls;
+    const uint32_t initialConfirmCalls    = Dummy_N_USData_confirm_cb_calls;
+    ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    const uint32_t initialTime = osInterface.osMillis();
+    while ((Dummy_N_USData_indication_cb_calls == initialIndicationCalls ||
+            Dummy_N_USData_confirm_cb_calls == initialConfirmCalls) &&
+           osInterface.osMillis() - initialTime < 1000)
+    {
+        sender.runStep();
+        receiver.runStep();
+    }
+
+    EXPECT_EQ(initialIndicationCalls + 1, Dummy_N_USData_indication_cb_calls);
+    EXPECT_EQ(initialConfirmCalls + 1, Dummy_N_USData_confirm_cb_calls);
+}
+
+/**
+ * CANInterface whose bus can be disconnected. The frames written are counted, but never acknowledged.
+ */
+class UnacknowledgedCANInterface : public CANInterface
+{
+public:
+    uint32_t frameAvailable() override
+    {
+        return 0;
+    }
+
+    bool readFrame(CANFrame* frame) override
+    {
+        return false;
+    }
+
+    bool writeFrame(CANFrame* frame) override
+    {
+        this->writtenFrames++;
+        return true;
+    }
+
+    bool active() override
+    {
+        return this->connected;
+    }
+
+    ACKResult getWriteFrameACK() override
+    {
+        return ACK_NONE;
+    }
+
+    bool     connected     = true;
+    uint32_t writtenFrames = 0;
+};
+
+TEST(ISOTP, busInactiveMidTransfer)
+{
+    UnacknowledgedCANInterface canInterface;
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, canInterface, 2, ISOTP_DefaultSTmin);
+
+    // Every request writes its first frame and waits for its ACK, until all the slots of the ACK queue are taken.
+    const uint8_t message[] = "A multi frame message";
+    for (size_t i = 0; i < CANMessageACKQueue_Capacity; i++)
+    {
+        ASSERT_TRUE(ISOTP.N_USData_request(static_cast<uint8_t>(i + 2), N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                           message, sizeof(message)));
+    }
+    uint32_t initialTime = osInterface.osMillis();
+    while (canInterface.writtenFrames < CANMessageACKQueue_Capacity && osInterface.osMillis() - initialTime < 500)
+    {
+        ISOTP.runStep();
+    }
+    ASSERT_EQ(CANMessageACKQueue_Capacity, canInterface.writtenFrames);
+
+    // When the bus goes inactive, the transfers fail.
+    const uint32_t initialConfirmCalls = Dummy_N_USData_confirm_cb_calls;
+    canInterface.connected             = false;
+    ISOTP.runStep();
+    EXPECT_EQ(initialConfirmCalls + CANMessageACKQueue_Capacity, Dummy_N_USData_confirm_cb_calls);
+
+    // Want the slots of their frames freed, so a new request is written once the bus is back.
+    canInterface.connected = true;
+    ASSERT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    initialTime = osInterface.osMillis();
+    while (canInterface.writtenFrames == CANMessageACKQueue_Capacity && osInterface.osMillis() - initialTime < 500)
+    {
+        ISOTP.runStep();
+    }
+    EXPECT_EQ(CANMessageACKQueue_Capacity + 1, canInterface.writtenFrames);
+}
+
+static uint32_t BurstSF_N_USData_indication_cb_calls = 0;
+void BurstSF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                    Mtype mtype)
+{
+    BurstSF_N_USData_indication_cb_calls++;
+    EXPECT_EQ(N_OK, nResult);
+}
+
+TEST(ISOTP, runStepProcessesBurstOfFrames)
+{
+    constexpr uint32_t burstSize = 5;
+
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, BurstSF_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    for (uint8_t i = 0; i < burstSize; i++)
+    {
+        CANFrame frame   = NewCANFrameISOTP();
+        frame.identifier = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, static_cast<uint8_t>(i + 2));
+        frame.data[0]    = 1; // SF with 1 byte of data
+        frame.data[1]    = i;
+        frame.data_length_code = 2;
+        ASSERT_TRUE(peerInterface->writeFrame(&frame));
+    }
+
+    BurstSF_N_USData_indication_cb_calls = 0;
+    ISOTP.setMaxFramesPerStep(2);
+    ISOTP.runStep();
+    EXPECT_EQ(2, BurstSF_N_USData_indication_cb_calls);
+    EXPECT_EQ(burstSize - 2, canInterface->frameAvailable());
+
+    ISOTP.setMaxFramesPerStep(0);
+    ISOTP.runStep();
+    EXPECT_EQ(burstSize, BurstSF_N_USData_indication_cb_calls);
+    EXPECT_EQ(0, canInterface->frameAvailable());
+}
+
+TEST(ISOTP, runStepReturnsTimeUntilNextRun)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    EXPECT_EQ(ISOTP_MaxWaitForWork_MS, ISOTP.runStep()); // Nothing to do.
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        const uint8_t nSA      = i + 2;
+        CANFrame      frame    = NewCANFrameISOTP();
+        frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, nSA);
+        frame.data[0]          = 1; // SF with 1 byte of data
+        frame.data[1]          = i;
+        frame.data_length_code = 2;
+        ASSERT_TRUE(peerInterface->writeFrame(&frame));
+    }
+
+    ISOTP.setMaxFramesPerStep(1);
+    EXPECT_EQ(0, ISOTP.runStep()); // The second frame is still waiting.
+    EXPECT_EQ(ISOTP_MaxWaitForWork_MS, ISOTP.runStep());
+
+    // A FF starts a runner that sends an FC and then waits for the CFs until N_Cr expires.
+    CANFrame frame         = NewCANFrameISOTP();
+    frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    frame.data[0]          = N_USData_Runner::FF_CODE << 4;
+    frame.data[1]          = 20; // 20 bytes message
+    frame.data_length_code = 8;
+    ASSERT_TRUE(peerInterface->writeFrame(&frame));
+
+    ISOTP.runStep();
+    ISOTP.canMessageACKQueueRunStep();
+    const uint32_t timeUntilNextRun = ISOTP.runStep();
+    EXPECT_GT(timeUntilNextRun, 0);
+    EXPECT_LE(timeUntilNextRun, ISOTP_MaxWaitForWork_MS);
+}
+
+TEST(ISOTP, waitForWork)
+{
+    constexpr uint32_t timeout = 50;
+
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    // Nothing happens, so the wait lasts the whole timeout.
+    uint32_t start = osInterface.osMillis();
+    EXPECT_FALSE(ISOTP.waitForWork(timeout));
+    EXPECT_GE(osInterface.osMillis() - start, timeout);
+
+    // A frame received by the CANInterface wakes it up.
+    std::thread peer(
+        [&peerInterface]
+        {
+            osInterface.osSleep(10);
+            CANFrame frame         = NewCANFrameISOTP();
+            frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+            frame.data[0]          = 1; // SF with 1 byte of data
+            frame.data_length_code = 2;
+            peerInterface->writeFrame(&frame);
+        });
+    EXPECT_TRUE(ISOTP.waitForWork(UINT32_MAX));
+    peer.join();
+    EXPECT_EQ(1, canInterface->frameAvailable());
+
+    // So does a message queued by another thread.
+    std::thread application(
+        [&ISOTP]
+        {
+            osInterface.osSleep(10);
+            const uint8_t message[] = {1, 2, 3};
+            EXPECT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+        });
+    EXPECT_TRUE(ISOTP.waitForWork(UINT32_MAX));
+    application.join();
+
+    // A wakeup before the wait is not lost.
+    ISOTP.wakeup();
+    start = osInterface.osMillis();
+    EXPECT_TRUE(ISOTP.waitForWork(timeout));
+    EXPECT_LT(osInterface.osMillis() - start, timeout);
+
+    // Neither when it sleeps on the semaphores of the ThreadInterface.
+    ASSERT_TRUE(ISOTP.setThreadInterface(threadInterface));
+    start = osInterface.osMillis();
+    EXPECT_FALSE(ISOTP.waitForWork(timeout));
+    EXPECT_GE(osInterface.osMillis() - start, timeout);
+    ISOTP.wakeup();
+    start = osInterface.osMillis();
+    EXPECT_TRUE(ISOTP.waitForWork(timeout));
+    EXPECT_LT(osInterface.osMillis() - start, timeout);
+}
+
+TEST(ISOTP, startStop)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    EXPECT_FALSE(ISOTP.isStarted());
+    ISOTP.stop(); // Stopping workers that are not running is harmless.
+
+    EXPECT_TRUE(ISOTP.start(threadInterface));
+    EXPECT_TRUE(ISOTP.isStarted());
+    EXPECT_FALSE(ISOTP.start(threadInterface));
+
+    ISOTP.stop();
+    EXPECT_FALSE(ISOTP.isStarted());
+
+    // The workers can be restarted, and the destructor stops them.
+    EXPECT_TRUE(ISOTP.start(threadInterface));
+}
+
+TEST(ISOTP, configChangesWhileRunning)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+    ASSERT_TRUE(ISOTP.start(threadInterface));
+
+    // The RX worker reads the configuration of each runStep while it is replaced, keep it busy with functional frames.
+    CANFrame frame              = NewCANFrameISOTP();
+    frame.identifier            = ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 7, 2);
+    frame.data[0]               = 0x01;
+    frame.data_length_code      = 2;
+    const uint32_t initialCalls = Dummy_N_USData_indication_cb_calls;
+
+    for (uint8_t i = 0; i < 200; i++)
+    {
+        ISOTP.addAcceptedFunctionalN_TA(7);
+        EXPECT_TRUE(ISOTP.setSTmin({static_cast<uint8_t>(i % 128), ms}));
+        EXPECT_TRUE(peerInterface->writeFrame(&frame));
+        EXPECT_TRUE(ISOTP.hasAcceptedFunctionalN_TA(7));
+        EXPECT_EQ(i % 128, ISOTP.getSTmin().value);
+        EXPECT_TRUE(ISOTP.removeAcceptedFunctionalN_TA(7));
+    }
+
+    ISOTP.addAcceptedFunctionalN_TA(7);
+    EXPECT_TRUE(peerInterface->writeFrame(&frame));
+    osInterface.osSleep(50);
+    ISOTP.stop();
+
+    // Frames that arrived while N_TA 7 was not accepted were discarded, but the last one must have been received.
+    EXPECT_LT(initialCalls, Dummy_N_USData_indication_cb_calls);
+}
+
+TEST(ISOTP, configReadsFromSeveralThreads)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+    ASSERT_TRUE(ISOTP.start(threadInterface));
+
+    // The getters read the snapshots without a lock while the setters replace and free them.
+    std::atomic<bool>     reading      = true;
+    std::atomic<uint32_t> invalidReads = 0;
+    auto                  reader       = [&]
+    {
+        while (reading)
+        {
+            if (ISOTP.getBlockSize() > 10 || ISOTP.getSTmin().value > 10 || !ISOTP.hasAcceptedPhysicalN_SA(1))
+            {
+                ++invalidReads;
+            }
+        }
+    };
+    std::thread firstReader(reader);
+    std::thread secondReader(reader);
+
+    for (uint8_t i = 0; i < 200; i++)
+    {
+        EXPECT_TRUE(ISOTP.setBlockSize(i % 11));
+        EXPECT_TRUE(ISOTP.setSTmin({static_cast<uint8_t>(i % 11), ms}));
+    }
+
+    reading = false;
+    firstReader.join();
+    secondReader.join();
+    ISOTP.stop();
+
+    EXPECT_EQ(0, invalidReads);
+}
+
+TEST(ISOTP, MemoryArena)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    MemoryArena::Stats            stats{};
+
+    {
+        ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                    osInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+        EXPECT_FALSE(ISOTP.getMemoryArenaStats(stats));
+    }
+
+    ISOTP sender(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 2, {0, ms}, "sender", true);
+    ISOTP receiver(2, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 2, {0, ms}, "receiver", true);
+    ASSERT_TRUE(sender.getMemoryArenaStats(stats));
+    EXPECT_EQ(2000, stats.capacity);
+    EXPECT_EQ(0, stats.usedBytes);
+
+    uint8_t message[100];
+    for (uint8_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = i;
+    }
+    const uint32_t initialConfirmCalls    = Dummy_N_USData_confirm_cb_calls;
+    const uint32_t initialIndicationCalls = Dummy_N_USData_indication_cb_calls;
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+    EXPECT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    const uint32_t initialTime = osInterface.osMillis();
+    while ((Dummy_N_USData_confirm_cb_calls == initialConfirmCalls ||
+            Dummy_N_USData_indication_cb_calls == initialIndicationCalls) &&
+           osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    sender.stop();
+    receiver.stop();
+    EXPECT_LT(initialConfirmCalls, Dummy_N_USData_confirm_cb_calls);
+    EXPECT_LT(initialIndicationCalls, Dummy_N_USData_indication_cb_calls);
+
+    // Both messages were carved from the arenas, and given back once their callbacks were called.
+    for (const auto isotp : {&sender, &receiver})
+    {
+        ASSERT_TRUE(isotp->getMemoryArenaStats(stats));
+        EXPECT_EQ(0, stats.usedBytes);
+        EXPECT_EQ(0, stats.allocations);
+        EXPECT_LE(sizeof(message), stats.highWaterMark);
+        EXPECT_EQ(0, stats.failedAllocations);
+        EXPECT_EQ(1, stats.freeBlocks);
+    }
+}
+
+static uint8_t  Long_received[300];
+static uint32_t Long_receivedLength = 0;
+static N_Result Long_result         = NOT_STARTED;
+static void     Long_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                   Mtype mtype)
+{
+    if (nResult == N_OK && messageLength <= sizeof(Long_received))
+    {
+        memcpy(Long_received, messageData, messageLength);
+        Long_receivedLength = messageLength;
+    }
+    Long_result = nResult;
+}
+
+TEST(ISOTP, longMessage)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP sender(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 0, {0, ms}, "sender");
+    ISOTP receiver(2, 2000, Dummy_N_USData_confirm_cb, Long_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 0, {0, ms}, "receiver");
+
+    // Longer than 6 + 15 * 7 = 111 bytes, so the SN of the CFs wraps around from 15 to 0 (twice).
+    uint8_t message[sizeof(Long_received)];
+    for (uint32_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = static_cast<uint8_t>(i);
+    }
+
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+    EXPECT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    const uint32_t initialTime = osInterface.osMillis();
+    while (Long_result == NOT_STARTED && osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    sender.stop();
+    receiver.stop();
+
+    EXPECT_EQ(N_OK, Long_result);
+    ASSERT_EQ(sizeof(message), Long_receivedLength);
+    EXPECT_EQ(0, memcmp(message, Long_received, sizeof(message)));
+}
+
+static uint32_t Lent_release_cb_calls      = 0;
+static uint32_t Lent_confirmCallsAtRelease = 0;
+static void     Lent_release_cb(const uint8_t* messageData, uint32_t messageLength, void* context)
+{
+    Lent_confirmCallsAtRelease = Dummy_N_USData_confirm_cb_calls;
+    Lent_release_cb_calls++;
+    EXPECT_EQ(context, messageData);
+}
+
+TEST(ISOTP, lentMessage)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+    MemoryArena::Stats            stats{};
+
+    ISOTP sender(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 2, {0, ms}, "sender", true);
+    ISOTP receiver(2, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 2, {0, ms}, "receiver");
+
+    uint8_t message[100];
+    for (uint8_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = i;
+    }
+
+    // A failed request does not take the buffer.
+    EXPECT_FALSE(sender.N_USData_request(3, 2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message),
+                                         Lent_release_cb, message));
+    EXPECT_EQ(0, Lent_release_cb_calls);
+
+    const uint32_t initialConfirmCalls    = Dummy_N_USData_confirm_cb_calls;
+    const uint32_t initialIndicationCalls = Dummy_N_USData_indication_cb_calls;
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+    EXPECT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message),
+                                        Lent_release_cb, message));
+
+    const uint32_t initialTime = osInterface.osMillis();
+    while ((Lent_release_cb_calls == 0 || Dummy_N_USData_indication_cb_calls == initialIndicationCalls) &&
+           osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    sender.stop();
+    receiver.stop();
+    EXPECT_EQ(initialIndicationCalls + 1, Dummy_N_USData_indication_cb_calls);
+
+    // The buffer is released once, after the confirmation.
+    EXPECT_EQ(1, Lent_release_cb_calls);
+    EXPECT_EQ(initialConfirmCalls + 1, Lent_confirmCallsAtRelease);
+
+    // The message was sent from the buffer of the caller, it was never copied to the arena of the sender.
+    ASSERT_TRUE(sender.getMemoryArenaStats(stats));
+    EXPECT_EQ(0, stats.highWaterMark);
+}
+
+static uint32_t Segmented_indication_cb_calls = 0;
+static uint8_t  Segmented_receivedMessage[64];
+static uint32_t Segmented_receivedLength = 0;
+static void     Segmented_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                        N_Result nResult, Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    ASSERT_LE(messageLength, sizeof(Segmented_receivedMessage));
+    memcpy(Segmented_receivedMessage, messageData, messageLength);
+    Segmented_receivedLength = messageLength;
+    Segmented_indication_cb_calls++;
+}
+
+static uint32_t Segmented_release_cb_calls = 0;
+static void     Segmented_release_cb(const uint8_t* messageData, uint32_t messageLength, void* context)
+{
+    EXPECT_EQ(context, messageData); // The first segment.
+    Segmented_release_cb_calls++;
+}
+
+TEST(ISOTP, segmentedMessage)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP sender(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 2, {0, ms}, "sender");
+    ISOTP receiver(2, 2000, Dummy_N_USData_confirm_cb, Segmented_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 2, {0, ms}, "receiver");
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+
+    // A header, then payload blocks whose boundaries do not match the frame boundaries.
+    const uint8_t          header[]   = {0x62, 0xF1, 0x90};
+    const uint8_t          block1[]   = "0123456789ABCDEFGHIJ";
+    const uint8_t          block2[]   = "z";
+    const N_USData_Segment segments[] = {{header, sizeof(header)}, {block1, 0}, {block1, 20}, {block2, 1}};
+    const uint8_t          expected[] = "\x62\xF1\x90"
+                                        "0123456789ABCDEFGHIJz";
+
+    for (const uint8_t segmentCount : {1, 4})
+    {
+        const uint32_t expectedLength          = segmentCount == 1 ? sizeof(header) : sizeof(expected) - 1;
+        const uint32_t initialIndicationCalls  = Segmented_indication_cb_calls;
+        const uint32_t initialReleaseCallbacks = Segmented_release_cb_calls;
+        ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, segments, segmentCount,
+                                            Segmented_release_cb, const_cast<uint8_t*>(header)));
+
+        const uint32_t initialTime = osInterface.osMillis();
+        while ((Segmented_indication_cb_calls == initialIndicationCalls ||
+                Segmented_release_cb_calls == initialReleaseCallbacks) &&
+               osInterface.osMillis() - initialTime < 2000)
+        {
+            osInterface.osSleep(1);
+        }
+        ASSERT_EQ(initialIndicationCalls + 1, Segmented_indication_cb_calls);
+        EXPECT_EQ(initialReleaseCallbacks + 1, Segmented_release_cb_calls);
+        ASSERT_EQ(expectedLength, Segmented_receivedLength);
+        EXPECT_EQ_ARRAY(expected, Segmented_receivedMessage, expectedLength);
+    }
+
+    // Invalid segment lists are rejected without taking the segments.
+    const N_USData_Segment noData[] = {{header, sizeof(header)}, {nullptr, 0}};
+    EXPECT_FALSE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, noData, 2, Segmented_release_cb,
+                                         const_cast<uint8_t*>(header)));
+    EXPECT_FALSE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, segments, 0, Segmented_release_cb,
+                                         const_cast<uint8_t*>(header)));
+    N_USData_Segment tooManySegments[ISOTP_MaxMessageSegments + 1];
+    std::fill_n(tooManySegments, ISOTP_MaxMessageSegments + 1, N_USData_Segment{block2, 1});
+    EXPECT_FALSE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, tooManySegments,
+                                         ISOTP_MaxMessageSegments + 1, Segmented_release_cb,
+                                         const_cast<uint8_t*>(header)));
+    EXPECT_EQ(2, Segmented_release_cb_calls);
+
+    sender.stop();
+    receiver.stop();
+}
+
+static uint8_t        Provided_buffer[100];
+static const uint8_t* Provided_indicationData       = nullptr;
+static uint32_t       Provided_indication_cb_calls  = 0;
+static uint32_t       Provided_release_cb_calls     = 0;
+static uint32_t       Provided_indicationsAtRelease = 0;
+
+static uint8_t* Provided_getBuffer(N_AI nAi, uint32_t messageLength, void* context)
+{
+    return messageLength <= sizeof(Provided_buffer) ? Provided_buffer : nullptr;
+}
+static void Provided_releaseBuffer(const uint8_t* messageData, uint32_t messageLength, void* context)
+{
+    EXPECT_EQ(Provided_buffer, messageData);
+    Provided_indicationsAtRelease = Provided_indication_cb_calls;
+    Provided_release_cb_calls++;
+}
+static void Provided_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                   Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    Provided_indicationData = messageData;
+    Provided_indication_cb_calls++;
+}
+
+TEST(ISOTP, ReceiveBufferProvider)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP sender(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 2, {0, ms}, "sender");
+    ISOTP receiver(2, 2000, Dummy_N_USData_confirm_cb, Provided_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 2, {0, ms}, "receiver", true);
+
+    EXPECT_EQ(nullptr, receiver.getReceiveBufferProvider().getBuffer);
+    EXPECT_FALSE(receiver.setReceiveBufferProvider({Provided_getBuffer, nullptr, nullptr}));
+    EXPECT_EQ(nullptr, receiver.getReceiveBufferProvider().getBuffer);
+    EXPECT_TRUE(receiver.setReceiveBufferProvider({Provided_getBuffer, Provided_releaseBuffer, nullptr}));
+    EXPECT_EQ(Provided_getBuffer, receiver.getReceiveBufferProvider().getBuffer);
+
+    uint8_t message[sizeof(Provided_buffer)];
+    for (uint8_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = i;
+    }
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+    ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    const uint32_t initialTime = osInterface.osMillis();
+    while (Provided_release_cb_calls == 0 && osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    sender.stop();
+    receiver.stop();
+
+    // The message was reassembled in the provided buffer, handed to the indication and then given back.
+    ASSERT_EQ(1, Provided_indication_cb_calls);
+    EXPECT_EQ(Provided_buffer, Provided_indicationData);
+    EXPECT_EQ_ARRAY(message, Provided_buffer, sizeof(message));
+    EXPECT_EQ(1, Provided_release_cb_calls);
+    EXPECT_EQ(1, Provided_indicationsAtRelease);
+
+    // The library did not allocate it.
+    MemoryArena::Stats stats{};
+    ASSERT_TRUE(receiver.getMemoryArenaStats(stats));
+    EXPECT_EQ(0, stats.highWaterMark);
+}
+
+static uint8_t  Streaming_received[1000];
+static uint32_t Streaming_receivedLength      = 0;
+static uint32_t Streaming_maxChunkLength      = 0;
+static uint32_t Streaming_abortAtOffset       = UINT32_MAX;
+static uint32_t Streaming_indication_cb_calls = 0;
+static N_Result Streaming_firstResult         = NOT_STARTED; // The CFs sent after an abort end in more indications.
+static bool     Streaming_firstDataWasNull    = false;
+
+static bool Streaming_onChunk(N_AI nAi, uint32_t offset, const uint8_t* chunk, uint32_t chunkLength, void* context)
+{
+    EXPECT_EQ(Streaming_receivedLength, offset); // The chunks arrive in order, without gaps.
+    if (offset >= Streaming_abortAtOffset)
+    {
+        return false;
+    }
+    memcpy(&Streaming_received[offset], chunk, chunkLength);
+    Streaming_receivedLength += chunkLength;
+    Streaming_maxChunkLength = std::max(Streaming_maxChunkLength, chunkLength);
+    return true;
+}
+static void Streaming_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                    Mtype mtype)
+{
+    if (Streaming_firstResult == NOT_STARTED)
+    {
+        Streaming_firstResult      = nResult;
+        Streaming_firstDataWasNull = messageData == nullptr;
+    }
+    Streaming_indication_cb_calls++;
+}
+
+TEST(ISOTP, StreamingSink)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    // The receiver has much less memory than the message, only a chunk is kept at once.
+    ISOTP sender(1, 5000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 2, {0, ms}, "sender");
+    ISOTP receiver(2, 100, Dummy_N_USData_confirm_cb, Streaming_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 2, {0, ms}, "receiver");
+    EXPECT_EQ(nullptr, receiver.getStreamingSink().onChunk);
+
+    uint8_t message[sizeof(Streaming_received)];
+    for (uint32_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = static_cast<uint8_t>(i * 7);
+    }
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+
+    // Chunks of the configured size, then chunks of a block (2 CFs) and finally a reception aborted by the sink.
+    using Case = struct
+    {
+        uint32_t chunkSize;
+        uint32_t expectedMaxChunkLength;
+        uint32_t abortAtOffset;
+        N_Result expectedResult;
+    };
+    for (const Case& c : {Case{64, 64, UINT32_MAX, N_OK}, Case{0, 14, UINT32_MAX, N_OK}, Case{64, 64, 128, N_ERROR}})
+    {
+        receiver.setStreamingSink({Streaming_onChunk, 100, c.chunkSize, nullptr});
+        EXPECT_EQ(Streaming_onChunk, receiver.getStreamingSink().onChunk);
+        Streaming_receivedLength = 0;
+        Streaming_maxChunkLength = 0;
+        Streaming_abortAtOffset  = c.abortAtOffset;
+        Streaming_firstResult    = NOT_STARTED;
+        memset(Streaming_received, 0, sizeof(Streaming_received));
+
+        const uint32_t initialIndicationCalls = Streaming_indication_cb_calls;
+        ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+        const uint32_t initialTime = osInterface.osMillis();
+        while (Streaming_indication_cb_calls == initialIndicationCalls && osInterface.osMillis() - initialTime < 3000)
+        {
+            osInterface.osSleep(1);
+        }
+        ASSERT_LT(initialIndicationCalls, Streaming_indication_cb_calls);
+        EXPECT_EQ(c.expectedResult, Streaming_firstResult);
+        EXPECT_TRUE(Streaming_firstDataWasNull);
+        EXPECT_EQ(c.expectedMaxChunkLength, Streaming_maxChunkLength);
+        if (c.expectedResult == N_OK)
+        {
+            ASSERT_EQ(sizeof(message), Streaming_receivedLength);
+            EXPECT_EQ_ARRAY(message, Streaming_received, sizeof(message));
+        }
+        else
+        {
+            EXPECT_EQ(c.abortAtOffset, Streaming_receivedLength);
+        }
+    }
+
+    sender.stop();
+    receiver.stop();
+}
+
+static uint8_t Source_byteAt(const uint32_t offset)
+{
+    return static_cast<uint8_t>(offset * 31 + offset / 256);
+}
+
+static uint32_t Source_nextOffset = 0;
+static uint32_t Source_failAt     = UINT32_MAX;
+
+static bool Source_cb(const uint32_t offset, uint8_t* destination, const uint32_t length, void* context)
+{
+    EXPECT_EQ(Source_nextOffset, offset); // The bytes are pulled in order, once.
+    if (offset >= Source_failAt)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+        destination[i] = Source_byteAt(offset + i);
+    }
+    Source_nextOffset += length;
+    return true;
+}
+
+static uint32_t Source_indication_cb_calls = 0;
+static bool     Source_receivedMatches     = false;
+static void     Source_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                     Mtype mtype)
+{
+    Source_receivedMatches = nResult == N_OK;
+    for (uint32_t i = 0; i < messageLength && Source_receivedMatches; i++)
+    {
+        Source_receivedMatches = messageData[i] == Source_byteAt(i);
+    }
+    Source_indication_cb_calls++;
+}
+
+static uint32_t Source_confirm_cb_calls  = 0;
+static N_Result Source_lastConfirmResult = NOT_STARTED;
+static void     Source_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    Source_lastConfirmResult = nResult;
+    Source_confirm_cb_calls++;
+}
+
+TEST(ISOTP, dataSourceMessage)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    // The sender has less memory than the message, it is never held in memory.
+    ISOTP sender(1, 100, Source_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb, osInterface,
+                 *canInterface, 2, {0, ms}, "sender", true);
+    ISOTP receiver(2, 10000, Dummy_N_USData_confirm_cb, Source_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 0, {0, ms}, "receiver");
+    ASSERT_TRUE(sender.start(threadInterface));
+    ASSERT_TRUE(receiver.start(threadInterface));
+
+    // A message long enough for the FF escape sequence, then a short one, sent as a SF.
+    for (const uint32_t length : {5000u, 5u})
+    {
+        Source_nextOffset                     = 0;
+        const uint32_t initialIndicationCalls = Source_indication_cb_calls;
+        const uint32_t initialConfirmCalls    = Source_confirm_cb_calls;
+        ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, length, Source_cb, nullptr));
+
+        const uint32_t initialTime = osInterface.osMillis();
+        while ((Source_indication_cb_calls == initialIndicationCalls ||
+                Source_confirm_cb_calls == initialConfirmCalls) &&
+               osInterface.osMillis() - initialTime < 5000)
+        {
+            osInterface.osSleep(1);
+        }
+        ASSERT_EQ(initialIndicationCalls + 1, Source_indication_cb_calls);
+        ASSERT_EQ(initialConfirmCalls + 1, Source_confirm_cb_calls);
+        EXPECT_EQ(N_OK, Source_lastConfirmResult);
+        EXPECT_TRUE(Source_receivedMatches);
+        EXPECT_EQ(length, Source_nextOffset);
+    }
+
+    // A source that fails aborts the transmission.
+    Source_nextOffset                  = 0;
+    Source_failAt                      = 50;
+    const uint32_t initialConfirmCalls = Source_confirm_cb_calls;
+    ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 200, Source_cb, nullptr));
+    const uint32_t initialTime = osInterface.osMillis();
+    while (Source_confirm_cb_calls == initialConfirmCalls && osInterface.osMillis() - initialTime < 2000)
+    {
+        osInterface.osSleep(1);
+    }
+    ASSERT_EQ(initialConfirmCalls + 1, Source_confirm_cb_calls);
+    EXPECT_EQ(N_ERROR, Source_lastConfirmResult);
+    Source_failAt = UINT32_MAX;
+
+    EXPECT_FALSE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 200, nullptr, nullptr));
+
+    sender.stop();
+    receiver.stop();
+
+    MemoryArena::Stats stats{};
+    ASSERT_TRUE(sender.getMemoryArenaStats(stats));
+    EXPECT_EQ(0, stats.highWaterMark);
+}
+
+TEST(ISOTP, runStepLogLevelBenchmark)
+{
+    LocalCANNetwork               canNetwork;
+    std::unique_ptr<CANInterface> canInterface(canNetwork.newCANInterfaceConnection());
+    std::unique_ptr<CANInterface> peerInterface(canNetwork.newCANInterfaceConnection());
+
+    ISOTP sender(1, 8000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                 osInterface, *canInterface, 0, {0, ms}, "sender");
+    ISOTP receiver(2, 8000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                   osInterface, *peerInterface, 0, {0, ms}, "receiver");
+
+    uint8_t message[4000];
+    for (uint32_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = static_cast<uint8_t>(i);
+    }
+    const uint32_t initialConfirmCalls    = Dummy_N_USData_confirm_cb_calls;
+    const uint32_t initialIndicationCalls = Dummy_N_USData_indication_cb_calls;
+    ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    // Every CF of the message goes through a runStep of each side, so most of the cost is the per-frame logging.
+    std::chrono::nanoseconds runStepTime{0};
+    uint32_t                 steps       = 0;
+    const uint32_t           initialTime = osInterface.osMillis();
+    while ((Dummy_N_USData_confirm_cb_calls == initialConfirmCalls ||
+            Dummy_N_USData_indication_cb_calls == initialIndicationCalls) &&
+           osInterface.osMillis() - initialTime < 10000)
+    {
+        auto start = std::chrono::steady_clock::now();
+        sender.runStep();
+        receiver.runStep();
+        runStepTime += std::chrono::steady_clock::now() - start;
+        steps += 2;
+
+        sender.canMessageACKQueueRunStep();
+        receiver.canMessageACKQueueRunStep();
+    }
+    ASSERT_LT(initialConfirmCalls, Dummy_N_USData_confirm_cb_calls);
+    ASSERT_LT(initialIndicationCalls, Dummy_N_USData_indication_cb_calls);
 
-    delete canInterface;
+    // Compare the output of builds configured with -DISOTP_LOG_LEVEL=ERROR and -DISOTP_LOG_LEVEL=VERBOSE.
+    printf("[ BENCHMARK] ISOTP_LOG_LEVEL=%s: %u runSteps, %8.1f ns/runStep\n", ISOTP_BENCHMARK_LOG_LEVEL, steps,
+           std::chrono::duration<double, std::nano>(runStepTime).count() / steps);
 }
@@ -0,0 +1,119 @@
+#include "MemoryArena.h"
+
+#include <cstring>
+#include <vector>
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+TEST(MemoryArena, allocate_and_free)
+{
+    bool        result = false;
+    MemoryArena arena(result, 4096, linuxOSInterface);
+    ASSERT_TRUE(result);
+
+    MemoryArena::Stats stats = arena.getStats();
+    EXPECT_EQ(4096, stats.capacity);
+    EXPECT_EQ(0, stats.usedBytes);
+    EXPECT_EQ(4096, stats.freeBytes);
+    EXPECT_EQ(1, stats.freeBlocks);
+    EXPECT_EQ(0, stats.fragmentation);
+
+    auto first  = static_cast<uint8_t*>(arena.allocate(100));
+    auto second = static_cast<uint8_t*>(arena.allocate(0));
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(first) % alignof(std::max_align_t));
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(second) % alignof(std::max_align_t));
+    memset(first, 0xAA, 100);
+    memset(second, 0xBB, 1);
+
+    stats = arena.getStats();
+    EXPECT_EQ(2, stats.allocations);
+    EXPECT_LT(100, stats.usedBytes);
+    EXPECT_EQ(4096, stats.usedBytes + stats.freeBytes);
+    EXPECT_EQ(stats.usedBytes, stats.highWaterMark);
+
+    // Freeing every block merges the arena back into a single free block.
+    arena.free(first);
+    arena.free(second);
+    arena.free(nullptr);
+    const uint32_t highWaterMark = stats.usedBytes;
+    stats                        = arena.getStats();
+    EXPECT_EQ(0, stats.allocations);
+    EXPECT_EQ(0, stats.usedBytes);
+    EXPECT_EQ(highWaterMark, stats.highWaterMark);
+    EXPECT_EQ(1, stats.freeBlocks);
+    EXPECT_EQ(4096, stats.freeBytes);
+    EXPECT_EQ(0, stats.failedAllocations);
+}
+
+TEST(MemoryArena, does_not_fit)
+{
+    bool        result = false;
+    MemoryArena arena(result, 1024, linuxOSInterface);
+    ASSERT_TRUE(result);
+
+    EXPECT_EQ(nullptr, arena.allocate(1024)); // The header does not fit either.
+    EXPECT_EQ(nullptr, arena.allocate(UINT32_MAX));
+
+    const uint32_t largest = arena.getStats().largestFreeBlock;
+    void*          block   = arena.allocate(largest);
+    ASSERT_NE(nullptr, block);
+    EXPECT_EQ(nullptr, arena.allocate(1));
+
+    MemoryArena::Stats stats = arena.getStats();
+    EXPECT_EQ(3, stats.failedAllocations);
+    EXPECT_EQ(0, stats.freeBytes);
+    EXPECT_EQ(0, stats.largestFreeBlock);
+    EXPECT_EQ(1024, stats.highWaterMark);
+
+    arena.free(block);
+    EXPECT_EQ(largest, arena.getStats().largestFreeBlock);
+
+    MemoryArena tooSmall(result, 8, linuxOSInterface);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(nullptr, tooSmall.allocate(1));
+}
+
+TEST(MemoryArena, fragmentation)
+{
+    bool        result = false;
+    MemoryArena arena(result, 8192, linuxOSInterface);
+    ASSERT_TRUE(result);
+
+    std::vector<void*> blocks;
+    for (void* block = arena.allocate(200); block != nullptr; block = arena.allocate(200))
+    {
+        blocks.push_back(block);
+    }
+    ASSERT_LT(4, blocks.size());
+
+    // Every other block freed: plenty of free memory, but no room for a larger block.
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        arena.free(blocks[i]);
+    }
+    MemoryArena::Stats stats = arena.getStats();
+    EXPECT_LT(1, stats.freeBlocks);
+    EXPECT_LT(400, stats.freeBytes);
+    EXPECT_GT(400, stats.largestFreeBlock);
+    EXPECT_LT(50, stats.fragmentation);
+    EXPECT_EQ(nullptr, arena.allocate(400));
+
+    // The freed blocks are reused for blocks of the same size.
+    void* reused = arena.allocate(200);
+    EXPECT_NE(nullptr, reused);
+    arena.free(reused);
+
+    // Once their neighbours are freed too, they are merged again.
+    for (size_t i = 1; i < blocks.size(); i += 2)
+    {
+        arena.free(blocks[i]);
+    }
+    stats = arena.getStats();
+    EXPECT_EQ(1, stats.freeBlocks);
+    EXPECT_EQ(0, stats.fragmentation);
+    EXPECT_NE(nullptr, arena.allocate(400));
+}
@@ -30,6 +30,8 @@ TEST(N_USData_Indication_Runner, constructor_getters)
 
     ASSERT_EQ(result, true);
     ASSERT_STREQ(runner.getTAG(), buff);
+    char tag[N_USData_Runner::MAX_RUNNER_TAG_SIZE];
+    ASSERT_STREQ(runner.formatTag(tag, sizeof(tag)), buff);
     ASSERT_EQ(N_USData_Runner::RunnerIndicationType, runner.getRunnerType());
     ASSERT_EQ_N_AI(NAi, runner.getN_AI());
     ASSERT_EQ(nullptr, runner.getMessageData());
@@ -56,7 +58,7 @@ TEST(N_USData_Indication_Runner, constructor_destructor_argument_availableMemory
                                           canMessageACKQueue);
         int64_t                    actualMemory;
         ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
-        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory + N_USDATA_INDICATION_RUNNER_TAG_SIZE);
+        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory); // Nothing is charged until the FF is received.
         ASSERT_TRUE(result);
     }
     int64_t actualMemory;
@@ -66,28 +68,60 @@ TEST(N_USData_Indication_Runner, constructor_destructor_argument_availableMemory
     delete canInterface;
 }
 
-TEST(N_USData_Indication_Runner, constructor_destructor_argument_notAvailableMemoryTest)
+TEST(N_USData_Indication_Runner, runStep_notAvailableMemory)
 {
     LocalCANNetwork    can_network;
     int64_t            availableMemoryConst = 2;
     Atomic_int64_t     availableMemoryMock(availableMemoryConst, linuxOSInterface);
     CANInterface*      canInterface = can_network.newCANInterfaceConnection();
     CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
-    N_AI               NAi   = ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 1, 2);
     int                bs    = 2;
     STmin              stMin = {10, ms};
+    int64_t            actualMemory;
+
+    const char*    testMessageString = "0123456789"; // strlen = 10
+    const uint8_t* testMessage       = reinterpret_cast<const uint8_t*>(testMessageString);
 
+    // The runner itself needs no memory, the budget is only charged when the SF or the FF is received.
     {
+        N_AI                       NAi = ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 1, 2);
         bool                       result;
         N_USData_Indication_Runner runner(result, NAi, availableMemoryMock, bs, stMin, linuxOSInterface,
                                           canMessageACKQueue);
-        int64_t                    actualMemory;
+        ASSERT_TRUE(result);
+        ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
+        ASSERT_EQ(availableMemoryConst, actualMemory);
+
+        CANFrame sentFrame   = NewCANFrameISOTP();
+        sentFrame.identifier = NAi;
+        sentFrame.data[0]    = (N_USData_Runner::SF_CODE << 4) | 7;
+        memcpy(&sentFrame.data[1], testMessage, 7);
+
+        ASSERT_EQ(N_ERROR, runner.runStep(&sentFrame));
+        ASSERT_EQ(N_ERROR, runner.getResult());
+        ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
+        ASSERT_EQ(availableMemoryConst, actualMemory);
+    }
+
+    {
+        N_AI                       NAi = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+        bool                       result;
+        N_USData_Indication_Runner runner(result, NAi, availableMemoryMock, bs, stMin, linuxOSInterface,
+                                          canMessageACKQueue);
+        ASSERT_TRUE(result);
+
+        CANFrame sentFrame   = NewCANFrameISOTP();
+        sentFrame.identifier = NAi;
+        sentFrame.data[0]    = (N_USData_Runner::FF_CODE << 4);
+        sentFrame.data[1]    = 10;
+        memcpy(&sentFrame.data[2], testMessage, 6);
+
+        ASSERT_EQ(N_ERROR, runner.runStep(&sentFrame)); // An OVERFLOW FC is sent to the peer.
+        ASSERT_EQ(N_ERROR, runner.getResult());
         ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
         ASSERT_EQ(availableMemoryConst, actualMemory);
-        ASSERT_FALSE(result);
     }
 
-    int64_t actualMemory;
     ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
     ASSERT_EQ(availableMemoryConst, actualMemory);
 
@@ -169,6 +203,76 @@ TEST(N_USData_Indication_Runner, runStep_SF_valid_void)
     delete canInterface;
 }
 
+static uint8_t  ProvidedBuffer[7];
+static uint32_t ProvidedBuffer_released = 0;
+
+static uint8_t* ProvidedBuffer_get(const N_AI nAi, const uint32_t messageLength, void* context)
+{
+    EXPECT_EQ(&ProvidedBuffer_released, context);
+    return messageLength <= sizeof(ProvidedBuffer) ? ProvidedBuffer : nullptr;
+}
+
+static void ProvidedBuffer_release(const uint8_t* messageData, const uint32_t messageLength, void* context)
+{
+    EXPECT_EQ(ProvidedBuffer, messageData);
+    EXPECT_EQ(&ProvidedBuffer_released, context);
+    ProvidedBuffer_released++;
+}
+
+TEST(N_USData_Indication_Runner, runStep_SF_providedBuffer)
+{
+    LocalCANNetwork can_network;
+
+    Atomic_int64_t availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+
+    CANInterface*      canInterface = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+
+    N_AI NAi = ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 1, 2);
+
+    const char*    testMessageString = "1234567"; // strlen = 7
+    size_t         messageLen        = strlen(testMessageString);
+    const uint8_t* testMessage       = reinterpret_cast<const uint8_t*>(testMessageString);
+    bool           result;
+
+    N_USData_Indication_Runner runner(result, availableMemoryMock, linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(runner.reset(NAi, 2, {10, ms}, {ProvidedBuffer_get, ProvidedBuffer_release, &ProvidedBuffer_released}));
+
+    CANFrame sentFrame   = NewCANFrameISOTP();
+    sentFrame.identifier = NAi;
+    sentFrame.data[0]    = (N_USData_Runner::SF_CODE << 4) | messageLen;
+    memcpy(&sentFrame.data[1], testMessage, messageLen);
+
+    // The message is received straight into the provided buffer, which is not charged to the available memory.
+    ASSERT_EQ(N_OK, runner.runStep(&sentFrame));
+    ASSERT_EQ(ProvidedBuffer, runner.getMessageData());
+    ASSERT_EQ_ARRAY(testMessage, ProvidedBuffer, messageLen);
+    int64_t availableMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+
+    // And given back when the runner is released.
+    const uint32_t initialReleases = ProvidedBuffer_released;
+    runner.release();
+    ASSERT_EQ(initialReleases + 1, ProvidedBuffer_released);
+
+    // A message the provider has no buffer for is allocated by the runner.
+    sentFrame.data[0] = (N_USData_Runner::SF_CODE << 4) | 3;
+    ASSERT_TRUE(runner.reset(NAi, 2, {10, ms}, {[](N_AI, uint32_t, void*) -> uint8_t* { return nullptr; },
+                                                ProvidedBuffer_release, nullptr}));
+    ASSERT_EQ(N_OK, runner.runStep(&sentFrame));
+    ASSERT_NE(ProvidedBuffer, runner.getMessageData());
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST - 3, availableMemory);
+    runner.release();
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+    ASSERT_EQ(initialReleases + 1, ProvidedBuffer_released);
+
+    delete canInterface;
+}
+
 TEST(N_USData_Indication_Runner, runStep_SF_Mtype_invalid)
 {
     LocalCANNetwork can_network;
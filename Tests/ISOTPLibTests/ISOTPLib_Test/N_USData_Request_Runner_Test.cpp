@@ -55,7 +55,7 @@ TEST(N_USData_Request_Runner, constructor_destructor_argument_availableMemoryTes
 
         int64_t actualMemory;
         ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
-        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory + messageLen + N_USDATA_REQUEST_RUNNER_TAG_SIZE);
+        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory + messageLen);
         ASSERT_TRUE(result);
     }
     int64_t actualMemory;
@@ -0,0 +1,138 @@
+#include "PendingRunnerQueues.h"
+
+#include <algorithm>
+#include <list>
+#include <vector>
+#include <ISOTP.h>
+#include <LocalCANNetwork.h>
+#include <N_USData_Request_Runner.h>
+#include "ASSERT_MACROS.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+constexpr int64_t DEFAULT_AVAILABLE_MEMORY_CONST = 1000000;
+
+// The queues never run the runners, they only need runners with the given N_TAs.
+static std::vector<N_USData_Runner*> newRunners(const std::vector<uint8_t>& nTAs, Atomic_int64_t& availableMemory,
+                                                CANMessageACKQueue& canMessageACKQueue)
+{
+    const uint8_t*                message = reinterpret_cast<const uint8_t*>("0123456789");
+    std::vector<N_USData_Runner*> runners;
+    for (const uint8_t nTA : nTAs)
+    {
+        bool result = false;
+        runners.push_back(new N_USData_Request_Runner(result,
+                                                      ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nTA, 1),
+                                                      availableMemory, Mtype_Diagnostics, message, 10,
+                                                      linuxOSInterface, canMessageACKQueue));
+        EXPECT_TRUE(result);
+    }
+    return runners;
+}
+
+static void deleteRunners(const std::vector<N_USData_Runner*>& runners)
+{
+    for (const auto runner : runners)
+    {
+        delete runner;
+    }
+}
+
+TEST(PendingRunnerQueues, one_runner_per_N_AI_at_a_time)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners({2, 2, 3, 2}, availableMemoryMock, canMessageACKQueue);
+
+    PendingRunnerQueues queues;
+    for (const auto runner : runners)
+    {
+        queues.push(runner);
+    }
+    EXPECT_EQ(4, queues.size());
+
+    // Only the first runner of each N_AI is ready.
+    EXPECT_EQ(runners[0], queues.popReady());
+    EXPECT_EQ(runners[2], queues.popReady());
+    EXPECT_EQ(nullptr, queues.popReady());
+    EXPECT_EQ(2, queues.size());
+
+    queues.release(runners[2]->getN_AI()); // Nothing else is queued for N_TA 3.
+    EXPECT_EQ(nullptr, queues.popReady());
+
+    queues.release(runners[0]->getN_AI());
+    EXPECT_EQ(runners[1], queues.popReady());
+    EXPECT_EQ(nullptr, queues.popReady());
+
+    queues.release(runners[1]->getN_AI());
+    EXPECT_EQ(runners[3], queues.popReady());
+    EXPECT_EQ(0, queues.size());
+
+    // A runner queued for a busy N_AI waits for it to be released.
+    queues.push(runners[1]);
+    EXPECT_EQ(nullptr, queues.popReady());
+    queues.release(runners[3]->getN_AI());
+    EXPECT_EQ(runners[1], queues.popReady());
+
+    deleteRunners(runners);
+    delete canInterface;
+}
+
+TEST(PendingRunnerQueues, acquire_blocks_queued_runners)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners({2, 3}, availableMemoryMock, canMessageACKQueue);
+
+    PendingRunnerQueues queues;
+    queues.push(runners[0]);
+    queues.acquire(runners[0]->getN_AI()); // Acquired after becoming ready.
+    queues.acquire(runners[1]->getN_AI()); // Acquired before anything is queued.
+    queues.push(runners[1]);
+    EXPECT_EQ(nullptr, queues.popReady());
+
+    queues.release(runners[1]->getN_AI());
+    EXPECT_EQ(runners[1], queues.popReady());
+    queues.release(runners[0]->getN_AI());
+    EXPECT_EQ(runners[0], queues.popReady());
+    EXPECT_EQ(nullptr, queues.popReady());
+
+    deleteRunners(runners);
+    delete canInterface;
+}
+
+TEST(PendingRunnerQueues, takeAll)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners({2, 2, 3}, availableMemoryMock, canMessageACKQueue);
+
+    PendingRunnerQueues queues;
+    for (const auto runner : runners)
+    {
+        queues.push(runner);
+    }
+    EXPECT_EQ(runners[0], queues.popReady());
+
+    std::list<N_USData_Runner*> taken;
+    queues.takeAll(taken);
+    EXPECT_EQ(2, taken.size());
+    EXPECT_NE(taken.end(), std::ranges::find(taken, runners[1]));
+    EXPECT_NE(taken.end(), std::ranges::find(taken, runners[2]));
+    EXPECT_EQ(0, queues.size());
+    EXPECT_EQ(nullptr, queues.popReady());
+
+    // The busy N_AIs are forgotten too.
+    queues.push(runners[1]);
+    EXPECT_EQ(runners[1], queues.popReady());
+
+    deleteRunners(runners);
+    delete canInterface;
+}
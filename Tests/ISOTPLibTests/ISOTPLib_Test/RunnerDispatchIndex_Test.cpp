@@ -0,0 +1,182 @@
+#include "RunnerDispatchIndex.h"
+
+#include <chrono>
+#include <vector>
+#include <ISOTP.h>
+#include <LocalCANNetwork.h>
+#include <N_USData_Indication_Runner.h>
+#include <N_USData_Request_Runner.h>
+#include "ASSERT_MACROS.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+constexpr int64_t DEFAULT_AVAILABLE_MEMORY_CONST = 1000000;
+
+static CANFrame newFrame(const N_AI nAi, const uint8_t pci)
+{
+    CANFrame frame         = NewCANFrameISOTP();
+    frame.identifier       = nAi;
+    frame.data[0]          = pci;
+    frame.data_length_code = 3;
+    return frame;
+}
+
+TEST(RunnerDispatchIndex, insert_find_erase)
+{
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+
+    N_AI NAi    = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    bool result = false;
+    N_USData_Indication_Runner runner(result, NAi, availableMemoryMock, 0, {0, ms}, linuxOSInterface,
+                                      canMessageACKQueue);
+    ASSERT_TRUE(result);
+
+    RunnerDispatchIndex index;
+    EXPECT_EQ(0, index.size());
+    EXPECT_TRUE(index.insert(&runner));
+    EXPECT_TRUE(index.insert(&runner)); // Inserting the same runner twice is harmless.
+    EXPECT_EQ(1, index.size());
+
+    EXPECT_EQ(&runner, index.find(newFrame(NAi, N_USData_Runner::SF_CODE << 4 | 1)));
+    EXPECT_EQ(nullptr, index.find(newFrame(NAi, N_USData_Runner::FC_CODE << 4)));
+    EXPECT_EQ(nullptr,
+              index.find(newFrame(ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 3), 1)));
+
+    index.erase(&runner);
+    EXPECT_EQ(0, index.size());
+    EXPECT_EQ(nullptr, index.find(newFrame(NAi, N_USData_Runner::SF_CODE << 4 | 1)));
+
+    delete canInterface;
+}
+
+TEST(RunnerDispatchIndex, request_and_indication_with_same_inbound_N_AI)
+{
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANInterface*      peerInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+
+    // Node 1 is sending a message to node 2 while receiving another message from node 2.
+    N_AI           requestNAi    = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+    N_AI           indicationNAi = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    const uint8_t* message       = reinterpret_cast<const uint8_t*>("0123456789");
+    bool           result        = false;
+
+    N_USData_Request_Runner requestRunner(result, requestNAi, availableMemoryMock, Mtype_Diagnostics, message, 10,
+                                          linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+    ASSERT_EQ(IN_PROGRESS, requestRunner.runStep(nullptr)); // Send the FF, now it awaits an FC.
+
+    N_USData_Indication_Runner indicationRunner(result, indicationNAi, availableMemoryMock, 0, {0, ms},
+                                                linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+
+    EXPECT_EQ(RunnerDispatchIndex::getDispatchKey(requestRunner.getInboundN_AI()),
+              RunnerDispatchIndex::getDispatchKey(indicationRunner.getInboundN_AI()));
+
+    RunnerDispatchIndex index;
+    EXPECT_TRUE(index.insert(&requestRunner));
+    EXPECT_TRUE(index.insert(&indicationRunner));
+    EXPECT_EQ(2, index.size());
+
+    EXPECT_EQ(&requestRunner, index.find(newFrame(indicationNAi, N_USData_Runner::FC_CODE << 4)));
+    EXPECT_EQ(&indicationRunner, index.find(newFrame(indicationNAi, N_USData_Runner::SF_CODE << 4 | 1)));
+
+    index.erase(&requestRunner);
+    EXPECT_EQ(1, index.size());
+    EXPECT_EQ(nullptr, index.find(newFrame(indicationNAi, N_USData_Runner::FC_CODE << 4)));
+    EXPECT_EQ(&indicationRunner, index.find(newFrame(indicationNAi, N_USData_Runner::SF_CODE << 4 | 1)));
+
+    delete peerInterface;
+    delete canInterface;
+}
+
+// Measures the cost of dispatching a frame to its runner as the number of active runners grows. The index lookup must
+// stay flat, while asking every runner with isThisFrameForMe() (what ISOTP used to do) grows linearly.
+TEST(RunnerDispatchIndex, benchmark_dispatch_cost_is_flat)
+{
+    constexpr uint32_t runnerCounts[] = {1, 10, 100, 1000};
+    constexpr uint32_t lookups        = 20000;
+    constexpr uint32_t repetitions    = 5;
+
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+
+    double indexCostNs[std::size(runnerCounts)];
+
+    for (size_t c = 0; c < std::size(runnerCounts); c++)
+    {
+        const uint32_t                           runnerCount = runnerCounts[c];
+        std::vector<N_USData_Indication_Runner*> runners;
+        std::vector<CANFrame>                    frames;
+        RunnerDispatchIndex                      index;
+
+        for (uint32_t i = 0; i < runnerCount; i++)
+        {
+            N_AI nAi    = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                            static_cast<typeof(N_AI::N_TA)>(i / 256),
+                                            static_cast<typeof(N_AI::N_SA)>(i % 256));
+            bool result = false;
+            runners.push_back(new N_USData_Indication_Runner(result, nAi, availableMemoryMock, 0, {0, ms},
+                                                             linuxOSInterface, canMessageACKQueue));
+            ASSERT_TRUE(result);
+            ASSERT_TRUE(index.insert(runners.back()));
+            frames.push_back(newFrame(nAi, N_USData_Runner::SF_CODE << 4 | 1));
+        }
+
+        double bestIndexNs  = 0;
+        double bestLinearNs = 0;
+        for (uint32_t r = 0; r < repetitions; r++)
+        {
+            uint32_t found = 0;
+            auto     start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < lookups; i++)
+            {
+                found += index.find(frames[i % runnerCount]) != nullptr;
+            }
+            auto end = std::chrono::steady_clock::now();
+            ASSERT_EQ(lookups, found);
+            double ns   = std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+            bestIndexNs = r == 0 ? ns : MIN(bestIndexNs, ns);
+
+            found = 0;
+            start = std::chrono::steady_clock::now();
+            for (const CANFrame& frame : frames) // Each frame once, so the scan covers the whole list on average.
+            {
+                for (const auto runner : runners)
+                {
+                    if (runner->isThisFrameForMe(frame))
+                    {
+                        found++;
+                        break;
+                    }
+                }
+            }
+            end = std::chrono::steady_clock::now();
+            ASSERT_EQ(runnerCount, found);
+            ns           = std::chrono::duration<double, std::nano>(end - start).count() / runnerCount;
+            bestLinearNs = r == 0 ? ns : MIN(bestLinearNs, ns);
+        }
+
+        indexCostNs[c] = bestIndexNs;
+        printf("[ BENCHMARK] %4u active runners: index %8.1f ns/frame, linear scan %10.1f ns/frame\n", runnerCount,
+               bestIndexNs, bestLinearNs);
+
+        for (const auto runner : runners)
+        {
+            delete runner;
+        }
+    }
+
+    // Generous bound so the check is stable on loaded machines and under valgrind.
+    EXPECT_LT(indexCostNs[std::size(runnerCounts) - 1], 5 * indexCostNs[0] + 100);
+
+    delete canInterface;
+}
@@ -0,0 +1,233 @@
+#include "RunnerPool.h"
+
+#include <ISOTP.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <LocalCANNetwork.h>
+#include "ASSERT_MACROS.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+constexpr int64_t DEFAULT_AVAILABLE_MEMORY_CONST = 1000000;
+
+TEST(RunnerPool, recycles_runners)
+{
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+
+    {
+        bool       result = false;
+        RunnerPool pool(result, 2, availableMemoryMock, linuxOSInterface, canMessageACKQueue);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(2, pool.getIdleRequestRunners());
+        EXPECT_EQ(2, pool.getIdleIndicationRunners());
+
+        // Idle runners are not charged to the memory budget.
+        int64_t availableMemory;
+        ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+        EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+
+        const uint8_t* message = reinterpret_cast<const uint8_t*>("0123456789");
+        N_AI           nAi     = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+
+        N_USData_Request_Runner* requestRunner = pool.acquireRequestRunner(nAi, Mtype_Diagnostics, message, 10);
+        ASSERT_NE(nullptr, requestRunner);
+        EXPECT_EQ(1, pool.getIdleRequestRunners());
+        EXPECT_EQ(nAi.N_AI, requestRunner->getN_AI().N_AI);
+        EXPECT_EQ(10, requestRunner->getMessageLength());
+        EXPECT_EQ_ARRAY(message, requestRunner->getMessageData(), 10);
+        ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+        EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST - 10, availableMemory);
+
+        N_USData_Indication_Runner* indicationRunner = pool.acquireIndicationRunner(nAi, 0, {0, ms});
+        ASSERT_NE(nullptr, indicationRunner);
+        EXPECT_EQ(1, pool.getIdleIndicationRunners());
+        EXPECT_EQ(N_USData_Runner::RunnerIndicationType, indicationRunner->getRunnerType());
+
+        // Released runners give their memory back and are handed out again.
+        pool.release(requestRunner);
+        pool.release(indicationRunner);
+        EXPECT_EQ(2, pool.getIdleRequestRunners());
+        EXPECT_EQ(2, pool.getIdleIndicationRunners());
+        ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+        EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+
+        // The idle runners are handed out in the order they were given back.
+        N_USData_Request_Runner* firstRunner = pool.acquireRequestRunner(nAi, Mtype_Diagnostics, message, 10);
+        ASSERT_NE(nullptr, firstRunner);
+        EXPECT_NE(requestRunner, firstRunner);
+        N_AI otherNAi = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 3, 1);
+        EXPECT_EQ(requestRunner, pool.acquireRequestRunner(otherNAi, Mtype_Diagnostics, message, 5));
+        EXPECT_EQ(otherNAi.N_AI, requestRunner->getN_AI().N_AI);
+        EXPECT_EQ(5, requestRunner->getMessageLength());
+        EXPECT_EQ(NOT_STARTED, requestRunner->getResult());
+        pool.release(firstRunner);
+        pool.release(requestRunner);
+    }
+
+    int64_t availableMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+
+    delete canInterface;
+}
+
+TEST(RunnerPool, fails_past_capacity)
+{
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    bool               result = false;
+    RunnerPool         pool(result, 1, availableMemoryMock, linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+
+    N_AI                        nAi   = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+    N_USData_Indication_Runner* first = pool.acquireIndicationRunner(nAi, 0, {0, ms});
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(nullptr, pool.acquireIndicationRunner(nAi, 0, {0, ms})); // No runner is created past the capacity.
+    EXPECT_EQ(0, pool.getIdleIndicationRunners());
+    EXPECT_EQ(1, pool.getIdleRequestRunners()); // Each type has its own runners.
+
+    pool.release(first);
+    EXPECT_EQ(1, pool.getIdleIndicationRunners());
+    N_USData_Indication_Runner* second = pool.acquireIndicationRunner(nAi, 0, {0, ms});
+    EXPECT_EQ(first, second); // The released runner is reused.
+    pool.release(second);
+
+    delete canInterface;
+}
+
+TEST(RunnerPool, failed_reset_keeps_runner)
+{
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(5, linuxOSInterface);
+    bool               result = false;
+    RunnerPool         pool(result, 1, availableMemoryMock, linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+
+    const uint8_t* message = reinterpret_cast<const uint8_t*>("0123456789");
+    N_AI           nAi     = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+    EXPECT_EQ(nullptr, pool.acquireRequestRunner(nAi, Mtype_Diagnostics, message, 10)); // Not enough memory.
+    EXPECT_EQ(1, pool.getIdleRequestRunners());
+
+    int64_t availableMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    EXPECT_EQ(5, availableMemory);
+
+    delete canInterface;
+}
+
+static uint32_t       RunnerPool_released_calls = 0;
+static const uint8_t* RunnerPool_released_data  = nullptr;
+
+static void RunnerPool_release_cb(const uint8_t* messageData, uint32_t messageLength, void* context)
+{
+    EXPECT_EQ(10, messageLength);
+    EXPECT_EQ(&RunnerPool_released_calls, context);
+    RunnerPool_released_data = messageData;
+    RunnerPool_released_calls++;
+}
+
+TEST(RunnerPool, lent_message_data)
+{
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(5, linuxOSInterface);
+    bool               result = false;
+    RunnerPool         pool(result, 1, availableMemoryMock, linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+
+    const uint8_t* message = reinterpret_cast<const uint8_t*>("0123456789");
+    N_AI           nAi     = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+
+    // The message is bigger than the available memory, but it is not copied nor charged.
+    N_USData_Request_Runner* runner = pool.acquireRequestRunner(nAi, Mtype_Diagnostics, message, 10,
+                                                                RunnerPool_release_cb, &RunnerPool_released_calls);
+    ASSERT_NE(nullptr, runner);
+    EXPECT_EQ(message, runner->getMessageData());
+    int64_t availableMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    EXPECT_EQ(5, availableMemory);
+    EXPECT_EQ(0, RunnerPool_released_calls);
+
+    pool.release(runner);
+    EXPECT_EQ(1, RunnerPool_released_calls);
+    EXPECT_EQ(message, RunnerPool_released_data);
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    EXPECT_EQ(5, availableMemory);
+
+    // A lent message that can not be sent is given back to the caller without calling the release callback.
+    N_AI functionalNAi = ISOTP_N_AI_CONFIG(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, 2, 1);
+    EXPECT_EQ(nullptr, pool.acquireRequestRunner(functionalNAi, Mtype_Diagnostics, message, 10, RunnerPool_release_cb,
+                                                 &RunnerPool_released_calls));
+    EXPECT_EQ(1, pool.getIdleRequestRunners());
+    EXPECT_EQ(nullptr, pool.acquireRequestRunner(nAi, Mtype_Diagnostics, message, 10, nullptr, nullptr));
+    EXPECT_EQ(1, RunnerPool_released_calls);
+
+    delete canInterface;
+}
+
+TEST(RunnerPool, concurrent_acquire_release)
+{
+    constexpr uint8_t  threads    = 4;
+    constexpr uint32_t iterations = 2000;
+
+    LocalCANNetwork    canNetwork;
+    CANInterface*      canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    bool               result = false;
+    RunnerPool         pool(result, threads, availableMemoryMock, linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+
+    // No lock is taken, but a runner is never handed out to two threads at once nor lost.
+    std::atomic<uint32_t>    sharedRunners(0);
+    std::atomic<uint32_t>    acquiredRunners(0);
+    std::vector<std::thread> workers;
+    for (uint8_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back(
+            [&, t]
+            {
+                const uint8_t* message = reinterpret_cast<const uint8_t*>("0123456789");
+                const N_AI     nAi     = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                                           static_cast<uint8_t>(t + 2), 1);
+                for (uint32_t i = 0; i < iterations; i++)
+                {
+                    N_USData_Request_Runner* runner = pool.acquireRequestRunner(nAi, Mtype_Diagnostics, message, 10);
+                    if (runner == nullptr)
+                    {
+                        continue;
+                    }
+                    acquiredRunners++;
+                    std::this_thread::yield();
+                    if (runner->getN_AI().N_AI != nAi.N_AI)
+                    {
+                        sharedRunners++;
+                    }
+                    pool.release(runner);
+                }
+            });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    EXPECT_EQ(0, sharedRunners.load());
+    EXPECT_GT(acquiredRunners.load(), 0);
+    EXPECT_EQ(threads, pool.getIdleRequestRunners());
+    int64_t availableMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+
+    delete canInterface;
+}
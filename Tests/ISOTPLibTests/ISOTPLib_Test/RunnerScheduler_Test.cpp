@@ -0,0 +1,154 @@
+#include "RunnerScheduler.h"
+
+#include <vector>
+#include <ISOTP.h>
+#include <LocalCANNetwork.h>
+#include <N_USData_Indication_Runner.h>
+#include "ASSERT_MACROS.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+constexpr int64_t DEFAULT_AVAILABLE_MEMORY_CONST = 1000000;
+
+// The scheduler never runs the runners, it only needs distinct runner objects.
+static std::vector<N_USData_Runner*> newRunners(const uint8_t count, Atomic_int64_t& availableMemory,
+                                                CANMessageACKQueue& canMessageACKQueue)
+{
+    std::vector<N_USData_Runner*> runners;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        bool result = false;
+        runners.push_back(new N_USData_Indication_Runner(result,
+                                                         ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, i),
+                                                         availableMemory, 0, {0, ms}, linuxOSInterface,
+                                                         canMessageACKQueue));
+        EXPECT_TRUE(result);
+    }
+    return runners;
+}
+
+static void deleteRunners(const std::vector<N_USData_Runner*>& runners)
+{
+    for (const auto runner : runners)
+    {
+        delete runner;
+    }
+}
+
+TEST(RunnerScheduler, pops_due_runners_in_deadline_order)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners(4, availableMemoryMock, canMessageACKQueue);
+
+    RunnerScheduler scheduler;
+    scheduler.schedule(runners[0], 30);
+    scheduler.schedule(runners[1], 10);
+    scheduler.schedule(runners[2], 20);
+    scheduler.schedule(runners[3], 10); // Same deadline as runners[1], scheduled later.
+    EXPECT_EQ(4, scheduler.size());
+
+    uint32_t deadline = 0;
+    ASSERT_TRUE(scheduler.getNextDeadline(deadline));
+    EXPECT_EQ(10, deadline);
+
+    EXPECT_EQ(nullptr, scheduler.popDue(10)); // A runner is due once its deadline has passed.
+    EXPECT_EQ(runners[1], scheduler.popDue(21));
+    EXPECT_EQ(runners[3], scheduler.popDue(21));
+    EXPECT_EQ(runners[2], scheduler.popDue(21));
+    EXPECT_EQ(nullptr, scheduler.popDue(21));
+    EXPECT_FALSE(scheduler.isScheduled(runners[1]));
+    EXPECT_TRUE(scheduler.isScheduled(runners[0]));
+    EXPECT_EQ(1, scheduler.size());
+
+    EXPECT_EQ(runners[0], scheduler.popDue(31));
+    EXPECT_EQ(0, scheduler.size());
+    EXPECT_FALSE(scheduler.getNextDeadline(deadline));
+
+    deleteRunners(runners);
+    delete canInterface;
+}
+
+TEST(RunnerScheduler, reschedule_and_remove_discard_previous_deadline)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners(4, availableMemoryMock, canMessageACKQueue);
+
+    RunnerScheduler scheduler;
+    scheduler.schedule(runners[0], 10);
+    scheduler.schedule(runners[1], 20);
+
+    scheduler.schedule(runners[0], 50); // Postponed.
+    scheduler.schedule(runners[1], 5);  // Brought forward.
+    EXPECT_EQ(2, scheduler.size());
+
+    uint32_t deadline = 0;
+    ASSERT_TRUE(scheduler.getNextDeadline(deadline));
+    EXPECT_EQ(5, deadline);
+
+    EXPECT_EQ(runners[1], scheduler.popDue(30));
+    EXPECT_EQ(nullptr, scheduler.popDue(30)); // The old deadline of runners[0] is ignored.
+
+    scheduler.remove(runners[0]);
+    scheduler.remove(runners[0]); // Removing a runner that is not scheduled is harmless.
+    EXPECT_EQ(0, scheduler.size());
+    EXPECT_EQ(nullptr, scheduler.popDue(100));
+    EXPECT_FALSE(scheduler.getNextDeadline(deadline));
+
+    deleteRunners(runners);
+    delete canInterface;
+}
+
+TEST(RunnerScheduler, frequent_reschedules_keep_a_single_valid_entry)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners(4, availableMemoryMock, canMessageACKQueue);
+
+    RunnerScheduler scheduler;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        scheduler.schedule(runners[i % runners.size()], 1000 - i % 1000);
+    }
+    EXPECT_EQ(runners.size(), scheduler.size());
+
+    uint32_t popped = 0;
+    while (scheduler.popDue(UINT32_MAX) != nullptr)
+    {
+        popped++;
+    }
+    EXPECT_EQ(runners.size(), popped);
+    EXPECT_EQ(0, scheduler.size());
+
+    deleteRunners(runners);
+    delete canInterface;
+}
+
+TEST(RunnerScheduler, clear)
+{
+    LocalCANNetwork               canNetwork;
+    CANInterface*                 canInterface = canNetwork.newCANInterfaceConnection();
+    CANMessageACKQueue            canMessageACKQueue(*canInterface, linuxOSInterface);
+    Atomic_int64_t                availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    std::vector<N_USData_Runner*> runners = newRunners(4, availableMemoryMock, canMessageACKQueue);
+
+    RunnerScheduler scheduler;
+    scheduler.schedule(runners[0], 0);
+    scheduler.schedule(runners[1], 0);
+    scheduler.clear();
+
+    EXPECT_EQ(0, scheduler.size());
+    EXPECT_FALSE(scheduler.isScheduled(runners[0]));
+    EXPECT_EQ(nullptr, scheduler.popDue(1));
+
+    deleteRunners(runners);
+    delete canInterface;
+}
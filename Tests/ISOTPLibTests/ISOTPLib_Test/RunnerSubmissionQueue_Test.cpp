@@ -0,0 +1,108 @@
+#include "RunnerSubmissionQueue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+// The queue never dereferences the runners, so any distinct non-null pointer works.
+static N_USData_Runner* fakeRunner(const uintptr_t id)
+{
+    return reinterpret_cast<N_USData_Runner*>(id << 4);
+}
+
+TEST(RunnerSubmissionQueue, pops_in_push_order)
+{
+    RunnerSubmissionQueue queue(4);
+    EXPECT_EQ(nullptr, queue.pop());
+
+    EXPECT_TRUE(queue.push(fakeRunner(1)));
+    EXPECT_TRUE(queue.push(fakeRunner(2)));
+    EXPECT_EQ(fakeRunner(1), queue.pop());
+    EXPECT_TRUE(queue.push(fakeRunner(3)));
+    EXPECT_EQ(fakeRunner(2), queue.pop());
+    EXPECT_EQ(fakeRunner(3), queue.pop());
+    EXPECT_EQ(nullptr, queue.pop());
+}
+
+TEST(RunnerSubmissionQueue, push_fails_when_full)
+{
+    RunnerSubmissionQueue queue(3);
+    EXPECT_EQ(4, queue.capacity()); // Rounded up to a power of two.
+
+    for (uintptr_t lap = 0; lap < 3; lap++) // Wrap around the ring a few times.
+    {
+        for (uintptr_t i = 1; i <= queue.capacity(); i++)
+        {
+            EXPECT_TRUE(queue.push(fakeRunner(i)));
+        }
+        EXPECT_FALSE(queue.push(fakeRunner(100)));
+
+        EXPECT_EQ(fakeRunner(1), queue.pop());
+        EXPECT_TRUE(queue.push(fakeRunner(5))); // The popped cell is free again.
+        EXPECT_FALSE(queue.push(fakeRunner(100)));
+
+        for (uintptr_t i = 2; i <= queue.capacity() + 1; i++)
+        {
+            EXPECT_EQ(fakeRunner(i), queue.pop());
+        }
+        EXPECT_EQ(nullptr, queue.pop());
+    }
+}
+
+TEST(RunnerSubmissionQueue, concurrent_producers)
+{
+    constexpr uintptr_t producers            = 4;
+    constexpr uintptr_t runnersPerProducer   = 10000;
+    constexpr uintptr_t producerIdMultiplier = runnersPerProducer + 1;
+
+    RunnerSubmissionQueue    queue(64);
+    std::atomic<bool>        go = false;
+    std::vector<std::thread> threads;
+
+    for (uintptr_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back(
+            [&, p]
+            {
+                while (!go)
+                {
+                    std::this_thread::yield();
+                }
+                for (uintptr_t i = 1; i <= runnersPerProducer; i++)
+                {
+                    while (!queue.push(fakeRunner(p * producerIdMultiplier + i)))
+                    {
+                        std::this_thread::yield(); // Full, let the consumer catch up.
+                    }
+                }
+            });
+    }
+
+    // Each producer's runners must come out complete and in the order that producer pushed them.
+    std::vector<uintptr_t> lastPopped(producers, 0);
+    uintptr_t              popped = 0;
+    go                            = true;
+    while (popped < producers * runnersPerProducer)
+    {
+        N_USData_Runner* runner = queue.pop();
+        if (runner == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const uintptr_t id = reinterpret_cast<uintptr_t>(runner) >> 4;
+        const uintptr_t p  = id / producerIdMultiplier;
+        const uintptr_t i  = id % producerIdMultiplier;
+        ASSERT_LT(p, producers);
+        ASSERT_EQ(lastPopped[p] + 1, i);
+        lastPopped[p] = i;
+        popped++;
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(nullptr, queue.pop());
+}
@@ -0,0 +1,116 @@
+#include "TxConfirmationQueue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+TEST(TxConfirmationQueue, pops_in_push_order)
+{
+    TxConfirmationQueue     queue(4);
+    CANInterface::TxToken   token;
+    CANInterface::ACKResult ack;
+    EXPECT_FALSE(queue.pop(token, ack));
+
+    EXPECT_TRUE(queue.push(1, CANInterface::ACK_SUCCESS));
+    EXPECT_TRUE(queue.push(2, CANInterface::ACK_ERROR));
+    ASSERT_TRUE(queue.pop(token, ack));
+    EXPECT_EQ(1, token);
+    EXPECT_EQ(CANInterface::ACK_SUCCESS, ack);
+    EXPECT_TRUE(queue.push(3, CANInterface::ACK_SUCCESS));
+    ASSERT_TRUE(queue.pop(token, ack));
+    EXPECT_EQ(2, token);
+    EXPECT_EQ(CANInterface::ACK_ERROR, ack);
+    ASSERT_TRUE(queue.pop(token, ack));
+    EXPECT_EQ(3, token);
+    EXPECT_FALSE(queue.pop(token, ack));
+}
+
+TEST(TxConfirmationQueue, push_fails_when_full)
+{
+    TxConfirmationQueue queue(3);
+    EXPECT_EQ(4, queue.capacity()); // Rounded up to a power of two.
+
+    CANInterface::TxToken   token;
+    CANInterface::ACKResult ack;
+    for (CANInterface::TxToken lap = 0; lap < 3; lap++) // Wrap around the ring a few times.
+    {
+        for (CANInterface::TxToken i = 1; i <= queue.capacity(); i++)
+        {
+            EXPECT_TRUE(queue.push(i, CANInterface::ACK_SUCCESS));
+        }
+        EXPECT_FALSE(queue.push(100, CANInterface::ACK_SUCCESS));
+
+        ASSERT_TRUE(queue.pop(token, ack));
+        EXPECT_EQ(1, token);
+        EXPECT_TRUE(queue.push(5, CANInterface::ACK_SUCCESS)); // The popped cell is free again.
+        EXPECT_FALSE(queue.push(100, CANInterface::ACK_SUCCESS));
+
+        for (CANInterface::TxToken i = 2; i <= queue.capacity() + 1; i++)
+        {
+            ASSERT_TRUE(queue.pop(token, ack));
+            EXPECT_EQ(i, token);
+        }
+        EXPECT_FALSE(queue.pop(token, ack));
+    }
+}
+
+TEST(TxConfirmationQueue, concurrent_producers)
+{
+    constexpr CANInterface::TxToken producers            = 4;
+    constexpr CANInterface::TxToken acksPerProducer      = 10000;
+    constexpr CANInterface::TxToken producerIdMultiplier = acksPerProducer + 1;
+
+    TxConfirmationQueue      queue(64);
+    std::atomic<bool>        go = false;
+    std::vector<std::thread> threads;
+
+    for (CANInterface::TxToken p = 0; p < producers; p++)
+    {
+        threads.emplace_back(
+            [&, p]
+            {
+                while (!go)
+                {
+                    std::this_thread::yield();
+                }
+                for (CANInterface::TxToken i = 1; i <= acksPerProducer; i++)
+                {
+                    while (!queue.push(p * producerIdMultiplier + i, CANInterface::ACK_SUCCESS))
+                    {
+                        std::this_thread::yield(); // Full, let the consumer catch up.
+                    }
+                }
+            });
+    }
+
+    // Each producer's confirmations must come out complete and in the order that producer pushed them.
+    std::vector<CANInterface::TxToken> lastPopped(producers, 0);
+    CANInterface::TxToken              popped = 0;
+    go                                        = true;
+    while (popped < producers * acksPerProducer)
+    {
+        CANInterface::TxToken   token;
+        CANInterface::ACKResult ack;
+        if (!queue.pop(token, ack))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const CANInterface::TxToken p = token / producerIdMultiplier;
+        const CANInterface::TxToken i = token % producerIdMultiplier;
+        ASSERT_LT(p, producers);
+        ASSERT_EQ(lastPopped[p] + 1, i);
+        ASSERT_EQ(CANInterface::ACK_SUCCESS, ack);
+        lastPopped[p] = i;
+        popped++;
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    CANInterface::TxToken   token;
+    CANInterface::ACKResult ack;
+    EXPECT_FALSE(queue.pop(token, ack));
+}
@@ -0,0 +1,83 @@
+#include "WakeupSignal.h"
+
+#include <atomic>
+#include <thread>
+#include "LinuxOSInterface.h"
+#include "StdThreadInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface   linuxOSInterface;
+static StdThreadInterface threadInterface;
+
+TEST(WakeupSignal, notifications_are_consumed_by_one_wait)
+{
+    WakeupSignal signal(linuxOSInterface);
+    EXPECT_FALSE(signal.wait(0));
+
+    signal.notify();
+    signal.notify(); // Merged with the previous one.
+    EXPECT_TRUE(signal.wait(0));
+    EXPECT_FALSE(signal.wait(0));
+
+    signal.notify();
+    EXPECT_TRUE(signal.wait(0));
+}
+
+TEST(WakeupSignal, wait_times_out)
+{
+    WakeupSignal   signal(linuxOSInterface);
+    const uint32_t initialTime = linuxOSInterface.osMillis();
+    EXPECT_FALSE(signal.wait(20));
+    EXPECT_LE(20, linuxOSInterface.osMillis() - initialTime);
+}
+
+static void NotifyFromAnotherThread(WakeupSignal& signal)
+{
+    std::atomic<bool> done = false;
+
+    std::thread notifier(
+        [&]
+        {
+            for (int i = 0; i < 1000; i++)
+            {
+                signal.notify();
+            }
+            done = true;
+            signal.notify();
+        });
+
+    // Every wait ends because of a notification, and the last one is never lost.
+    while (!done)
+    {
+        EXPECT_TRUE(signal.wait(1000));
+    }
+    notifier.join();
+    signal.wait(0); // The last notification may or may not have been consumed already.
+    EXPECT_FALSE(signal.wait(0));
+}
+
+TEST(WakeupSignal, notify_from_another_thread)
+{
+    WakeupSignal signal(linuxOSInterface);
+    NotifyFromAnotherThread(signal);
+}
+
+TEST(WakeupSignal, notify_from_another_thread_with_semaphore)
+{
+    WakeupSignal signal(linuxOSInterface);
+    ASSERT_TRUE(signal.setSemaphore(threadInterface));
+    NotifyFromAnotherThread(signal);
+}
+
+TEST(WakeupSignal, notification_before_the_semaphore_is_kept)
+{
+    WakeupSignal signal(linuxOSInterface);
+    signal.notify();
+    ASSERT_TRUE(signal.setSemaphore(threadInterface));
+    EXPECT_TRUE(signal.wait(0));
+
+    // Now sleeping on the semaphore.
+    const uint32_t initialTime = linuxOSInterface.osMillis();
+    EXPECT_FALSE(signal.wait(20));
+    EXPECT_LE(20, linuxOSInterface.osMillis() - initialTime);
+}